@@ -1,4 +1,9 @@
+#ifdef KICK_INSTANCED
+flat in vec4 vGameObjectUID;
+#define _gameObjectUID vGameObjectUID
+#else
 uniform vec4 _gameObjectUID;
+#endif
 
 out vec4 fragColor;
 
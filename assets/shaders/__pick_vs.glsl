@@ -1,8 +1,16 @@
 in vec4 position;
 
+#ifdef KICK_INSTANCED
+#pragma include "assets/shaders/instancing.glsl"
+flat out vec4 vGameObjectUID;
+#else
 uniform mat4 _mvProj;
+#endif
 
 void main(void) {
     // compute position
     gl_Position = _mvProj * position;
+#ifdef KICK_INSTANCED
+    vGameObjectUID = _instanceUID;
+#endif
 }
\ No newline at end of file
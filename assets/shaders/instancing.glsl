@@ -0,0 +1,14 @@
+// Engine uniforms of instanced draws (included by vertex shaders when KICK_INSTANCED is defined).
+// The model matrix and the game object uid are per instance attributes, and the matrices derived
+// from the model matrix are computed in the vertex shader.
+in mat4 _instanceModel;
+in vec4 _instanceUID;
+
+uniform mat4 _v;
+uniform mat4 _proj;
+uniform mat4 _lightMatWorld;
+
+#define _mv (_v * _instanceModel)
+#define _mvProj (_proj * _v * _instanceModel)
+#define _norm transpose(inverse(mat3(_v * _instanceModel)))
+#define _lightMat (_lightMatWorld * _instanceModel)
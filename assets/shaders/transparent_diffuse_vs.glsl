@@ -2,9 +2,13 @@ in vec4 position;
 in vec3 normal;
 in vec2 uv1;
 
+#ifdef KICK_INSTANCED
+#pragma include "assets/shaders/instancing.glsl"
+#else
 uniform mat4 _mvProj;
 uniform mat3 _norm;
 uniform mat4 _mv;
+#endif
 
 out vec2 vUv;
 out vec3 vNormal;
@@ -1,7 +1,11 @@
 in vec4 position;
 in vec2 uv1;
 
+#ifdef KICK_INSTANCED
+#pragma include "assets/shaders/instancing.glsl"
+#else
 uniform mat4 _mvProj;
+#endif
 
 out vec2 vUv;
 
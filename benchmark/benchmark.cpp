@@ -0,0 +1,23 @@
+//
+//  benchmark.cpp
+//  KickCPP
+//
+//  Microbenchmarks of engine internals. The benchmarks do not create an OpenGL context.
+//
+
+#include "benchmark.h"
+#include "spatial_benchmark.h"
+#include "event_benchmark.h"
+#include "transform_benchmark.h"
+#include "math_benchmark.h"
+#include "culling_benchmark.h"
+
+int main(int argc, char* argv[])
+{
+    SpatialBenchmark();
+    EventBenchmark();
+    TransformBenchmark();
+    MathBenchmark();
+    CullingBenchmark();
+    return 0;
+}
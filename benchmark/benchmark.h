@@ -0,0 +1,28 @@
+//
+//  benchmark.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+inline void printBenchmarkHeader(const std::string &name, int count){
+    std::cout << name << " (" << count << " objects)" << std::endl;
+}
+
+// Runs the function a number of times and prints the average time per iteration in milliseconds
+template <typename F>
+double benchmark(const std::string &name, int iterations, F function){
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++){
+        function();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    std::cout << "  " << std::left << std::setw(36) << name << std::right << std::setw(12) << std::fixed << std::setprecision(4) << ms << " ms" << std::endl;
+    return ms;
+}
@@ -0,0 +1,78 @@
+//
+//  culling_benchmark.h
+//  KickCPP
+//
+//  Benchmark of the batch bounds transform and frustum test against the per box versions
+//
+
+#pragma once
+
+#include "benchmark.h"
+#include "kick/math/bounds3.h"
+#include "kick/math/frustum.h"
+#include "kick/math/glm_ext.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <bitset>
+#include <random>
+#include <vector>
+
+void CullingBenchmark(int count = 100000){
+    using namespace glm;
+    using namespace kick;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-1, 1);
+    std::vector<Bounds3> bounds(count);
+    std::vector<mat4> matrices(count);
+    Bounds3Array boundsArray;
+    boundsArray.resize(count);
+    for (int i = 0; i < count; i++){
+        vec3 extent = abs(vec3{value(rng), value(rng), value(rng)}) + 0.1f;
+        bounds[i] = Bounds3{-extent, extent};
+        boundsArray.set(i, bounds[i]);
+        quat rotation = normalize(quat{value(rng), value(rng), value(rng), value(rng)});
+        matrices[i] = TRS(vec3{value(rng), value(rng), value(rng)} * 500.0f, rotation, vec3{1});
+    }
+    Frustum frustum;
+    frustum.extractPlanes(glm::perspective(radians(60.0f), 1.0f, 0.1f, 1000.0f) * glm::lookAt(vec3{0,0,500}, vec3{0}, vec3{0,1,0}));
+
+    std::vector<Bounds3> worldBounds(count);
+    Bounds3Array worldBoundsArray;
+    std::vector<uint32_t> visibleMask((count + 31) / 32);
+    int visible = 0;
+
+    printBenchmarkHeader("Culling", count);
+    benchmark("transform (8 corners)", 10, [&](){
+        for (int i = 0; i < count; i++){
+            Bounds3 res;
+            for (int c = 0; c < 8; c++){
+                vec3 corner{c & 1 ? bounds[i].max.x : bounds[i].min.x, c & 2 ? bounds[i].max.y : bounds[i].min.y, c & 4 ? bounds[i].max.z : bounds[i].min.z};
+                res.expand(vec3(matrices[i] * vec4(corner, 1)));
+            }
+            worldBounds[i] = res;
+        }
+    });
+    benchmark("transform", 10, [&](){
+        for (int i = 0; i < count; i++){
+            worldBounds[i] = bounds[i].transform(matrices[i]);
+        }
+    });
+    benchmark("transformBounds", 10, [&](){
+        transformBounds(boundsArray, matrices.data(), worldBoundsArray);
+    });
+    benchmark("intersectAabb", 10, [&](){
+        visible = 0;
+        for (int i = 0; i < count; i++){
+            if (frustum.intersectAabb(worldBounds[i]) != FrustumIntersection::Outside){
+                visible++;
+            }
+        }
+    });
+    benchmark("intersectAabbs", 10, [&](){
+        frustum.intersectAabbs(worldBoundsArray, visibleMask.data());
+    });
+    int batchVisible = 0;
+    for (auto word : visibleMask){
+        batchVisible += (int)std::bitset<32>(word).count();
+    }
+    std::cout << "  (visible " << visible << " / " << batchVisible << ")" << std::endl;
+}
@@ -0,0 +1,103 @@
+//
+//  event_benchmark.h
+//  KickCPP
+//
+//  Benchmark of Event<E> against the previous implementation (a sorted vector of std::function, dispatch by value)
+//
+
+#pragma once
+
+#include "benchmark.h"
+#include "kick/core/event.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+// The previous Event<E> implementation
+template <typename E>
+class LegacyEvent {
+public:
+    int createListener(std::function<void (E)> listener, int sortPriority = 0){
+        auto insertPos = listeners.begin();
+        while (insertPos != listeners.end() && std::get<2>(*insertPos) < sortPriority){
+            insertPos++;
+        }
+        listeners.emplace(insertPos, listener, eventListenerId, sortPriority);
+        return eventListenerId++;
+    }
+
+    void notifyListeners(E e){
+        for (auto & l : listeners){
+            std::get<0>(l)(e);
+        }
+    }
+
+    bool removeListener(int id){
+        for (auto iter = listeners.begin(); iter != listeners.end(); iter++){
+            if (std::get<1>(*iter) == id){
+                listeners.erase(iter);
+                return true;
+            }
+        }
+        return false;
+    }
+private:
+    std::vector<std::tuple<std::function<void (E)>, int, int>> listeners;
+    int eventListenerId = 0;
+};
+
+void EventBenchmark(int listenerCount = 1000, int notifications = 10000){
+    using namespace kick;
+    typedef std::pair<std::shared_ptr<int>, int> Payload;
+    printBenchmarkHeader("Event", listenerCount);
+    int sum = 0;
+    auto payload = Payload{std::make_shared<int>(1), 2};
+
+    LegacyEvent<Payload> legacyEvent;
+    for (int i = 0; i < listenerCount; i++){
+        legacyEvent.createListener([&sum](Payload p){ sum += p.second; });
+    }
+    Event<Payload> event;
+    std::vector<EventListener<Payload>> listeners;
+    for (int i = 0; i < listenerCount; i++){
+        listeners.push_back(event.createListener([&sum](const Payload &p){ sum += p.second; }));
+    }
+    benchmark("notify (legacy)", notifications, [&](){
+        legacyEvent.notifyListeners(payload);
+    });
+    benchmark("notify", notifications, [&](){
+        event.notifyListeners(payload);
+    });
+
+    // add and remove listeners in random order
+    std::mt19937 rng(42);
+    std::vector<int> order(listenerCount);
+    for (int i = 0; i < listenerCount; i++){
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    benchmark("add/remove (legacy)", 10, [&](){
+        LegacyEvent<Payload> e;
+        std::vector<int> ids;
+        for (int i = 0; i < listenerCount; i++){
+            ids.push_back(e.createListener([&sum](Payload p){ sum += p.second; }, i % 4));
+        }
+        for (int i : order){
+            e.removeListener(ids[i]);
+        }
+    });
+    benchmark("add/remove", 10, [&](){
+        Event<Payload> e;
+        std::vector<EventListener<Payload>> ids;
+        for (int i = 0; i < listenerCount; i++){
+            ids.push_back(e.createListener([&sum](const Payload &p){ sum += p.second; }, i % 4));
+        }
+        for (int i : order){
+            ids[i] = EventListener<Payload>();
+        }
+    });
+    std::cout << "  (" << sum << ")" << std::endl;
+}
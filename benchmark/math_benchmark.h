@@ -0,0 +1,64 @@
+//
+//  math_benchmark.h
+//  KickCPP
+//
+//  Benchmark of the TRS kernels in glm_ext against the glm reference (matrix products and a general inverse)
+//
+
+#pragma once
+
+#include "benchmark.h"
+#include "kick/math/glm_ext.h"
+#include <random>
+#include <vector>
+
+void MathBenchmark(int count = 100000){
+    using namespace glm;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-1, 1);
+    std::uniform_real_distribution<float> scaleValue(0.1f, 3);
+    std::vector<vec3> translate(count), scale(count);
+    std::vector<quat> rotate(count);
+    for (int i = 0; i < count; i++){
+        translate[i] = vec3{value(rng), value(rng), value(rng)} * 100.0f;
+        scale[i] = vec3{scaleValue(rng), scaleValue(rng), scaleValue(rng)};
+        rotate[i] = normalize(quat{value(rng), value(rng), value(rng), value(rng)});
+    }
+    std::vector<mat4> out(count);
+    float checksum = 0;
+
+    printBenchmarkHeader("TRS", count);
+    benchmark("glm TRS", 10, [&](){
+        for (int i = 0; i < count; i++){
+            out[i] = glm::translate(mat4{1}, translate[i]) * mat4_cast(rotate[i]) * glm::scale(mat4{1}, scale[i]);
+        }
+        checksum += out[count - 1][3][0];
+    });
+    benchmark("TRS", 10, [&](){
+        for (int i = 0; i < count; i++){
+            out[i] = kick::TRS(translate[i], rotate[i], scale[i]);
+        }
+        checksum += out[count - 1][3][0];
+    });
+    benchmark("TRS batch", 10, [&](){
+        kick::TRS(translate.data(), rotate.data(), scale.data(), out.data(), count);
+        checksum += out[count - 1][3][0];
+    });
+    benchmark("glm inverse(TRS)", 10, [&](){
+        for (int i = 0; i < count; i++){
+            out[i] = inverse(glm::translate(mat4{1}, translate[i]) * mat4_cast(rotate[i]) * glm::scale(mat4{1}, scale[i]));
+        }
+        checksum += out[count - 1][3][0];
+    });
+    benchmark("TRSInverse", 10, [&](){
+        for (int i = 0; i < count; i++){
+            out[i] = kick::TRSInverse(translate[i], rotate[i], scale[i]);
+        }
+        checksum += out[count - 1][3][0];
+    });
+    benchmark("TRSInverse batch", 10, [&](){
+        kick::TRSInverse(translate.data(), rotate.data(), scale.data(), out.data(), count);
+        checksum += out[count - 1][3][0];
+    });
+    std::cout << "  (" << checksum << ")" << std::endl;
+}
@@ -0,0 +1,137 @@
+//
+//  spatial_benchmark.h
+//  KickCPP
+//
+//  Benchmark of the dynamic AABB tree against a brute force scan (does not require an OpenGL context)
+//
+
+#pragma once
+
+#include "benchmark.h"
+#include "kick/math/dynamic_aabb_tree.h"
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+void SpatialBenchmark(int objectCount = 100000){
+    using namespace kick;
+    using namespace glm;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500, 500);
+    std::uniform_real_distribution<float> size(0.5f, 4);
+    std::vector<Bounds3> bounds;
+    for (int i = 0; i < objectCount; i++){
+        vec3 center{position(rng), position(rng), position(rng)};
+        vec3 extent{size(rng)};
+        bounds.push_back(Bounds3{center - extent, center + extent});
+    }
+
+    printBenchmarkHeader("Dynamic AABB tree", objectCount);
+
+    DynamicAABBTree tree;
+    std::vector<int> proxies(objectCount);
+    benchmark("build", 1, [&](){
+        for (int i = 0; i < objectCount; i++){
+            proxies[i] = tree.createProxy(bounds[i], (void*)(intptr_t)i);
+        }
+    });
+    std::cout << "  height " << tree.height() << " area ratio " << tree.areaRatio() << std::endl;
+
+    // move 10% of the objects each frame
+    std::uniform_int_distribution<int> pick(0, objectCount - 1);
+    std::uniform_real_distribution<float> velocity(-0.2f, 0.2f);
+    int reinserted = 0;
+    benchmark("move 10% (per frame)", 10, [&](){
+        for (int i = 0; i < objectCount / 10; i++){
+            int index = pick(rng);
+            vec3 displacement{velocity(rng), velocity(rng), velocity(rng)};
+            bounds[index] = Bounds3{bounds[index].min + displacement, bounds[index].max + displacement};
+            if (tree.moveProxy(proxies[index], bounds[index], displacement)){
+                reinserted++;
+            }
+        }
+    });
+    std::cout << "  reinserted " << reinserted << " of " << (objectCount / 10) * 10 << std::endl;
+
+    mat4 projection = perspective(radians(60.0f), 1.0f, 0.1f, 200.0f);
+    mat4 view = lookAt(vec3{0, 0, 0}, vec3{0, 0, -1}, vec3{0, 1, 0});
+    Frustum frustum;
+    frustum.extractPlanes(projection * view);
+
+    size_t visibleTree = 0;
+    benchmark("frustum query (tree)", 100, [&](){
+        visibleTree = 0;
+        tree.queryFrustum(frustum, [&](int proxyId, FrustumIntersection intersection, uint32_t planeMask){
+            if (intersection == FrustumIntersection::Inside ||
+                    frustum.intersectAabb(bounds[(intptr_t)tree.userData(proxyId)]) != FrustumIntersection::Outside){
+                visibleTree++;
+            }
+            return true;
+        });
+    });
+    // static camera: plane masks inherited from the parents and the rejecting plane cached between frames
+    std::vector<uint8_t> lastPlanes;
+    size_t visibleCoherent = 0;
+    benchmark("frustum query (tree, coherent)", 100, [&](){
+        visibleCoherent = 0;
+        tree.queryFrustum(frustum, [&](int proxyId, FrustumIntersection intersection, uint32_t planeMask){
+            if (intersection == FrustumIntersection::Inside ||
+                    frustum.intersectAabb(bounds[(intptr_t)tree.userData(proxyId)], planeMask, lastPlanes[proxyId]) != FrustumIntersection::Outside){
+                visibleCoherent++;
+            }
+            return true;
+        }, &lastPlanes);
+    });
+    size_t visibleBrute = 0;
+    benchmark("frustum query (brute force)", 100, [&](){
+        visibleBrute = 0;
+        for (auto & b : bounds){
+            if (frustum.intersectAabb(b) != FrustumIntersection::Outside){
+                visibleBrute++;
+            }
+        }
+    });
+    std::cout << "  visible " << visibleTree << " (tree) " << visibleCoherent << " (tree, coherent) " << visibleBrute << " (brute force)" << std::endl;
+
+    Bounds3 queryBounds{vec3{-25}, vec3{25}};
+    size_t overlapping = 0;
+    benchmark("overlap query (tree)", 1000, [&](){
+        overlapping = 0;
+        tree.query(queryBounds, [&](int proxyId){
+            if (bounds[(intptr_t)tree.userData(proxyId)].intersect(queryBounds)){
+                overlapping++;
+            }
+            return true;
+        });
+    });
+    benchmark("overlap query (brute force)", 100, [&](){
+        overlapping = 0;
+        for (auto & b : bounds){
+            if (b.intersect(queryBounds)){
+                overlapping++;
+            }
+        }
+    });
+
+    Ray ray{vec3{-600, 0, 0}, vec3{1, 0.01f, 0.02f}};
+    size_t hits = 0;
+    benchmark("ray cast (tree)", 1000, [&](){
+        hits = 0;
+        tree.rayCast(ray, [&](int proxyId, float distance){
+            float exactDistance;
+            if (ray.intersectAabb(bounds[(intptr_t)tree.userData(proxyId)], exactDistance)){
+                hits++;
+            }
+            return true;
+        });
+    });
+    benchmark("ray cast (brute force)", 100, [&](){
+        hits = 0;
+        for (auto & b : bounds){
+            float distance;
+            if (ray.intersectAabb(b, distance)){
+                hits++;
+            }
+        }
+    });
+}
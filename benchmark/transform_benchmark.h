@@ -0,0 +1,63 @@
+//
+//  transform_benchmark.h
+//  KickCPP
+//
+//  Benchmark of transform invalidation and global matrix updates in deep and wide hierarchies
+//
+
+#pragma once
+
+#include "benchmark.h"
+#include "kick/scene/transform.h"
+#include <memory>
+#include <vector>
+
+void TransformBenchmark(int transformCount = 5000, int frames = 100){
+    using namespace kick;
+    using namespace glm;
+    // transforms without a gameobject (not part of a scene)
+    auto createTransforms = [&](bool deep){
+        std::vector<std::shared_ptr<Transform>> transforms;
+        for (int i = 0; i < transformCount; i++){
+            transforms.push_back(std::make_shared<Transform>(nullptr));
+            if (i > 0){
+                transforms[i]->setParent(deep ? transforms[i - 1] : transforms[0]);
+            }
+        }
+        return transforms;
+    };
+    float checksum = 0;
+    for (int deep = 1; deep >= 0; deep--){
+        printBenchmarkHeader(deep ? "Transform (deep hierarchy)" : "Transform (wide hierarchy)", transformCount);
+        auto transforms = createTransforms(deep == 1);
+        // the root moves several times per frame, but only the last transform is read
+        benchmark("move root 3x, read one", frames, [&](){
+            for (int i = 0; i < 3; i++){
+                transforms[0]->setLocalPosition(vec3(i, 0, 0));
+            }
+            checksum += transforms.back()->globalMatrix()[3][0];
+        });
+        // the root moves several times per frame, and all transforms are read
+        benchmark("move root 3x, read all", frames, [&](){
+            for (int i = 0; i < 3; i++){
+                transforms[0]->setLocalPosition(vec3(i, 0, 0));
+            }
+            for (auto & t : transforms){
+                checksum += t->globalMatrix()[3][0];
+            }
+        });
+        // every transform moves once per frame, and all transforms are read
+        benchmark("move all, read all", frames, [&](){
+            for (auto & t : transforms){
+                t->setLocalPosition(t->localPosition());
+            }
+            for (auto & t : transforms){
+                checksum += t->globalMatrix()[3][0];
+            }
+        });
+        for (auto & t : transforms){
+            t->setParent(nullptr);
+        }
+    }
+    std::cout << "  (" << checksum << ")" << std::endl;
+}
@@ -74,12 +74,12 @@ namespace kick{
         vector<vec3> position;
         vector<vec2> textureCoords;
         vector<vec4> colors;
-        vector<GLushort> indices;
+        vector<GLuint> indices;
         sort(sprites.begin(), sprites.end(), [](Sprite* s1, Sprite* s2){
             return s1->order() < s2->order();
         });
-        unsigned short index = 0;
-        for (unsigned short i=0;i<sprites.size();i++){
+        GLuint index = 0;
+        for (size_t i=0;i<sprites.size();i++){
             auto sprite = sprites[i];
             auto transform = sprite->transform();
 
@@ -173,14 +173,15 @@ namespace kick{
 
         auto mat = replacementMaterial ? replacementMaterial : mMaterial;
         if (!replacementMaterial ){
+            static const UniformName mainTexture{"mainTexture"};
             mMaterial->setShader(sprites[0]->textureAtlas()->shader());
-            mMaterial->setUniform("mainTexture", sprites[0]->textureAtlas()->texture());
+            mMaterial->setUniform(mainTexture, sprites[0]->textureAtlas()->texture());
         }
         auto shader = mat->shader();
         assert(shader);
         mMesh->bind(shader.get());
 
-        shader->bind_uniforms(mMaterial, engineUniforms, transform().get());
+        shader->bind_uniforms(mat, engineUniforms, transform().get());
 
         mMesh->render(0);
 
@@ -44,6 +44,10 @@ namespace kick {
         template <typename C, typename... T>
         std::shared_ptr<C> addComponent(T... t);
 
+        // Add a 2D component to an existing gameobject in the hierarchy of the canvas
+        template <typename C, typename... T>
+        std::shared_ptr<C> addComponentTo(GameObject *gameObject, T... t);
+
         //
         std::shared_ptr<ToggleButton> createToggleButton(std::string text = "");
 
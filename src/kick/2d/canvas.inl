@@ -3,7 +3,12 @@ namespace kick{
     inline std::shared_ptr<C> Canvas::addComponent(T... t){
         auto go = createGameObject();
         go->transform()->setParent(transform());
-        auto c = go->addComponent<C>(std::dynamic_pointer_cast<Canvas>(shared_from_this()), t...);
+        return addComponentTo<C>(go, t...);
+    }
+
+    template <typename C, typename... T>
+    inline std::shared_ptr<C> Canvas::addComponentTo(GameObject *gameObject, T... t){
+        auto c = gameObject->addComponent<C>(std::dynamic_pointer_cast<Canvas>(shared_from_this()), t...);
 
         registerComponent2D(c);
 
@@ -17,6 +17,7 @@ namespace kick {
               mBounds{vec2{0,0},vec2{0,0}} {
         mMesh = new Mesh();
         mMeshData = make_shared<MeshData>();
+        mMeshData->setMeshUsage(MeshUsage::DynamicDraw);
         mMaterial = new Material();
         mMesh->setMeshData(mMeshData);
     }
@@ -65,7 +66,7 @@ namespace kick {
         }
         vector<vec3> position;
         vector<vec2> textureCoords;
-        vector<GLushort> indices;
+        vector<GLuint> indices;
         vec2 caret{-mFont->width(mText) * mAnchor.x, -mFont->height() * mAnchor.y};
 
         if (mText.length()>0){ // if first char is x-offset, then undo offset to fix horizontal alignment
@@ -75,7 +76,7 @@ namespace kick {
 
         mBounds.max = vec2{-FLT_MAX};
         mBounds.min = vec2{FLT_MAX};
-        GLushort vertexCount = 0;
+        GLuint vertexCount = 0;
         int lastChar = -1;
         for (unsigned short i=0;i< mText.length();i++){
             const FontChar fc = mFont->getChar(mText[i]);
@@ -101,10 +102,10 @@ namespace kick {
 
                 // push two triangles
                 indices.push_back(vertexCount);
-                indices.push_back(vertexCount + (GLushort)1);
-                indices.push_back(vertexCount + (GLushort)2);
-                indices.push_back(vertexCount + (GLushort)2);
-                indices.push_back(vertexCount + (GLushort)3);
+                indices.push_back(vertexCount + (GLuint)1);
+                indices.push_back(vertexCount + (GLuint)2);
+                indices.push_back(vertexCount + (GLuint)2);
+                indices.push_back(vertexCount + (GLuint)3);
                 indices.push_back(vertexCount);
 
                 vertexCount += 4;
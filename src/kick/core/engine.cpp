@@ -9,7 +9,10 @@
 #include "kick/core/engine.h"
 #include "kick/core/time.h"
 #include "kick/core/debug.h"
+#include "kick/core/render_stats.h"
+#include "kick/scene/engine_uniform_blocks.h"
 #include "kick/context/sdl2_context.h"
+#include <chrono>
 #include <iostream>
 
 using namespace std;
@@ -18,8 +21,8 @@ namespace kick {
 
     Engine* Engine::instance = nullptr;
 
-    Engine::Engine(int &argc, char **argv,const WindowConfig& config)
-    : mContext(new SDL2Context()), tickStartTime{Time::total()} {
+    Engine::Engine(int &argc, char **argv,const WindowConfig& config, const EngineConfig& engineConfig)
+    : mConfig(engineConfig), mJobSystem(new JobSystem(engineConfig.workerThreads)), mContext(new SDL2Context()), tickStartTime{Time::total()} {
         instance = this;
         mContext->init(argc, argv);
         mContext->showWindow(config);
@@ -46,12 +49,17 @@ namespace kick {
         Time::frame++;
 
         instance->eventQueue.run();
+        instance->mJobSystem->runMainThreadJobs();
+        instance->updateSceneLoads();
 
         instance->mDefaultKeyHandler.handleKeyPress(instance);
         instance->mActiveScene->update();
     }
     
     void Engine::render(){
+        RenderStats::startFrame();
+        instance->engineUniforms.time = Time::total();
+        EngineUniformBlocks::updateFrame(&instance->engineUniforms);
         instance->mActiveScene->render(&instance->engineUniforms);
         instance->mContext->swapBuffer();
 #ifdef DEBUG
@@ -68,6 +76,28 @@ namespace kick {
         return scene;
     }
     
+    std::shared_ptr<SceneLoadOperation> Engine::loadSceneAsync(const std::string &filename, Scene *scene, const SceneAssets &assets){
+        auto operation = make_shared<SceneLoadOperation>(scene ? scene : instance->mActiveScene, filename, instance->mJobSystem.get(), assets);
+        instance->mSceneLoads.push_back(operation);
+        return operation;
+    }
+
+    void Engine::updateSceneLoads(){
+        // the loads share the frame budget in the order they were started
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < mSceneLoads.size(); ){
+            float elapsed = chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+            if (i > 0 && elapsed >= mConfig.sceneLoadBudget){
+                break;
+            }
+            if (mSceneLoads[i]->update(mConfig.sceneLoadBudget - elapsed)){
+                mSceneLoads.erase(mSceneLoads.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
     std::vector<Scene>::const_iterator Engine::begin()  {
         return instance->scenes.begin();
     }
@@ -89,11 +119,11 @@ namespace kick {
         return instance->mDefaultKeyHandler;
     }
 
-    void Engine::init(int &argc, char **argv, WindowConfig const &config) {
+    void Engine::init(int &argc, char **argv, WindowConfig const &config, EngineConfig const &engineConfig) {
         cout << "kick "<< headerVersion()<<" (lib "<< libVersion()<<")"<<endl;
 
         assert(instance == nullptr);
-        new Engine(argc, argv, config);
+        new Engine(argc, argv, config, engineConfig);
     }
 
     EventQueue &Engine::getEventQueue() {
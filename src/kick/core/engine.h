@@ -21,25 +21,39 @@
 #include "kick/core/touch_input.h"
 #include "kick/core/default_key_handler.h"
 #include "kick/core/event_queue.h"
+#include "kick/core/job_system.h"
+#include "kick/scene/scene_serializer.h"
+#include <memory>
 
 namespace kick {
     
     struct EngineConfig {
         bool shadows = false;
         int maxNumerOfLights = 3;
+        // number of job system worker threads (in addition to the main thread). -1 means one per hardware thread
+        int workerThreads = -1;
+        // milliseconds per frame used for creating the gameobjects of asynchronously loaded scenes
+        float sceneLoadBudget = 4;
+        // render mesh renderers sharing mesh and materials using hardware instancing (if supported)
+        bool instancing = true;
     };
 
     class Engine {
         friend class Project;
     public:
-        static void init(int &argc, char **argv, const WindowConfig& config = WindowConfig::plain);
+        static void init(int &argc, char **argv, const WindowConfig& config = WindowConfig::plain, const EngineConfig& engineConfig = EngineConfig{});
         static Scene *activeScene() { return instance->mActiveScene; }
         static void setActiveScene(Scene *scene) { instance->mActiveScene = scene; }
         static Scene * createScene(const std::string &name);
         static std::vector<Scene>::const_iterator begin();
         static std::vector<Scene>::const_iterator end();
+        // Load a binary scene in the background and add its gameobjects to the scene (the active scene if nullptr).
+        // The load progresses during update() within EngineConfig::sceneLoadBudget
+        static std::shared_ptr<SceneLoadOperation> loadSceneAsync(const std::string &filename, Scene *scene = nullptr,
+                const SceneAssets &assets = SceneAssets{});
 
         static const EngineConfig& config(){ return instance->mConfig; }
+        static JobSystem* jobSystem(){ return instance->mJobSystem.get(); }
         static Context* context();
         static DefaultKeyHandler &defaultKeyHandler();
         static void startMainLoop();
@@ -66,9 +80,12 @@ namespace kick {
     private:
         static Engine* instance;
         EngineConfig mConfig;
+        std::unique_ptr<JobSystem> mJobSystem;
         EventQueue eventQueue;
-        Engine(int &argc, char **argv, const WindowConfig& config = WindowConfig::plain);
+        Engine(int &argc, char **argv, const WindowConfig& config, const EngineConfig& engineConfig);
         float tickStartTime;
+        void updateSceneLoads();
+        std::vector<std::shared_ptr<SceneLoadOperation>> mSceneLoads;
 
         Project project;
         std::vector<Scene> scenes;
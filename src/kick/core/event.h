@@ -9,35 +9,102 @@
 #pragma once
 
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <new>
+#include <type_traits>
 #include "event_listener.h"
 #include <vector>
 #include <utility>
 
-#define GET_LISTENER_FN(x) std::get<0>(x)
-#define GET_LISTENER_ID(x) std::get<1>(x)
-#define GET_LISTENER_SORTKEY(x) std::get<2>(x)
-
 namespace kick {
     class AbstractEvent{
     public:
-        virtual bool removeListener(int id) = 0;
+        virtual bool removeListener(int64_t id) = 0;
     };
-    
+
+    namespace detail {
+        // Type erased callable invoked with const E&. Callables of up to four pointers in size (such as lambdas
+        // with a few captures or a std::function) are stored inline without heap allocation.
+        template <typename E>
+        class EventFunction {
+        public:
+            EventFunction(){}
+            template <typename F>
+            explicit EventFunction(F &&function);
+            EventFunction(EventFunction &&other);
+            EventFunction& operator=(EventFunction &&other);
+            ~EventFunction();
+
+            void operator()(const E &e) { mInvoke(&mStorage, e); }
+            explicit operator bool() const { return mInvoke != nullptr; }
+        private:
+            EventFunction(const EventFunction&) = delete;
+            EventFunction& operator=(const EventFunction&) = delete;
+            typedef typename std::aligned_storage<4 * sizeof(void*), alignof(std::max_align_t)>::type Storage;
+            template <typename F>
+            void init(F &&function, std::true_type inlineStorage);
+            template <typename F>
+            void init(F &&function, std::false_type inlineStorage);
+            void reset();
+
+            Storage mStorage;
+            void (*mInvoke)(void *storage, const E &e) = nullptr;
+            // moves the callable from src to dest and destroys src (or only destroys src if dest is nullptr)
+            void (*mManage)(void *dest, void *src) = nullptr;
+        };
+    }
+
+    /// Listeners are invoked in order of sortPriority (and in creation order for equal priorities).
+    /// Listeners are stored in a dense array and found using a slot table, so removal is O(1) (removed entries are
+    /// compacted lazily). Listeners may be added and removed during notification: a removed listener is not invoked
+    /// after removal and an added listener is first invoked by the next notification.
     template <typename E>
     class Event : public AbstractEvent{
     public:
-        EventListener<E> createListener(std::function<void (E)> listener, int sortPriority = 0);
-        
+        template <typename F>
+        EventListener<E> createListener(F &&listener, int sortPriority = 0);
+
         void registerSyncValue(SyncValue<E>& syncValue);
-        
-        void notifyListeners(E e);
-        
-        bool removeListener(int id);
+
+        void notifyListeners(const E &e);
+
+        bool removeListener(int64_t id);
+
+        size_t listenerCount() const;
     protected:
-        std::vector<std::tuple<std::function< void (E)>, int, int>> listeners;
+        struct Listener {
+            detail::EventFunction<E> function;
+            int sortPriority;
+            uint32_t sequence; // creation order
+            uint32_t slot;     // or Removed
+        };
+        struct Slot {
+            uint32_t index;      // index in listeners (or in pendingListeners if the Pending bit is set)
+            uint32_t generation;
+        };
+        static const uint32_t Removed = 0xffffffff;
+        static const uint32_t Pending = 0x80000000;
+        // listener ids are the slot index (lower 32 bits) and the slot generation. A slot is retired when its
+        // generation reaches MaxGeneration, so a stale id never matches a later listener
+        static const int SlotBits = 32;
+        static const uint32_t MaxGeneration = 0x7fffffff;
+
+        int64_t addListener(detail::EventFunction<E> &&function, int sortPriority);
+        Listener *findListener(int64_t id);
+        void compact();
+
+        std::vector<Listener> listeners;
+        // listeners added during notification
+        std::vector<Listener> pendingListeners;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        uint32_t nextSequence = 0;
+        size_t removedCount = 0;
+        int notifyDepth = 0;
+        bool unsorted = false;
         friend class EventListener<E>;
-        int eventListenerId = 0;
     };
 }
 
@@ -1,16 +1,89 @@
+#include <algorithm>
+#include <cassert>
+
 namespace kick{
+namespace detail {
+template <typename E>
+template <typename F>
+inline EventFunction<E>::EventFunction(F &&function){
+    typedef typename std::decay<F>::type Function;
+    init(std::forward<F>(function), std::integral_constant<bool,
+            sizeof(Function) <= sizeof(Storage) && alignof(Function) <= alignof(Storage)>{});
+}
+
+template <typename E>
+template <typename F>
+inline void EventFunction<E>::init(F &&function, std::true_type){
+    typedef typename std::decay<F>::type Function;
+    new (&mStorage) Function(std::forward<F>(function));
+    mInvoke = [](void *storage, const E &e){
+        (*static_cast<Function*>(storage))(e);
+    };
+    mManage = [](void *dest, void *src){
+        if (dest){
+            new (dest) Function(std::move(*static_cast<Function*>(src)));
+        }
+        static_cast<Function*>(src)->~Function();
+    };
+}
+
+template <typename E>
+template <typename F>
+inline void EventFunction<E>::init(F &&function, std::false_type){
+    typedef typename std::decay<F>::type Function;
+    *reinterpret_cast<Function**>(&mStorage) = new Function(std::forward<F>(function));
+    mInvoke = [](void *storage, const E &e){
+        (**static_cast<Function**>(storage))(e);
+    };
+    mManage = [](void *dest, void *src){
+        if (dest){
+            *static_cast<Function**>(dest) = *static_cast<Function**>(src);
+        } else {
+            delete *static_cast<Function**>(src);
+        }
+    };
+}
+
+template <typename E>
+inline EventFunction<E>::EventFunction(EventFunction &&other){
+    *this = std::move(other);
+}
+
 template <typename E>
-inline EventListener<E> Event<E>::createListener(std::function<void (E)> listener, int sortPriority){
-    auto insertPos = listeners.begin();
-    int v = 0;
-    while (insertPos != listeners.end() && GET_LISTENER_SORTKEY(*insertPos) < sortPriority){
-        insertPos++;
-        v++;
+inline EventFunction<E>& EventFunction<E>::operator=(EventFunction &&other){
+    if (this != &other){
+        reset();
+        if (other.mManage){
+            other.mManage(&mStorage, &other.mStorage);
+            mInvoke = other.mInvoke;
+            mManage = other.mManage;
+            other.mInvoke = nullptr;
+            other.mManage = nullptr;
+        }
     }
-    listeners.emplace(insertPos, listener, eventListenerId, sortPriority);
-    
-    eventListenerId++;
-    return EventListener<E>(this, eventListenerId-1);
+    return *this;
+}
+
+template <typename E>
+inline EventFunction<E>::~EventFunction(){
+    reset();
+}
+
+template <typename E>
+inline void EventFunction<E>::reset(){
+    if (mManage){
+        mManage(nullptr, &mStorage);
+        mInvoke = nullptr;
+        mManage = nullptr;
+    }
+}
+}
+
+template <typename E>
+template <typename F>
+inline EventListener<E> Event<E>::createListener(F &&listener, int sortPriority){
+    int64_t id = addListener(detail::EventFunction<E>(std::forward<F>(listener)), sortPriority);
+    return EventListener<E>(this, id);
 }
 
 template <typename E>
@@ -18,33 +91,121 @@ inline void Event<E>::registerSyncValue(SyncValue<E>& syncValue){
     if (syncValue.listenerId > -1){
         removeListener(syncValue.listenerId);
     }
-    std::function<void (E)> updateFunction = [&](E e){
-        syncValue.value = e;
-    };
-    listeners.emplace_back(updateFunction, eventListenerId, 0);
-    syncValue.listenerId = eventListenerId;
+    SyncValue<E> *value = &syncValue;
+    syncValue.listenerId = addListener(detail::EventFunction<E>([value](const E &e){
+        value->value = e;
+    }), 0);
     syncValue.ae = this;
-    eventListenerId++;
 }
 
 template <typename E>
-inline void Event<E>::notifyListeners(E e){
-    for (auto & l : listeners){
-        auto& func = GET_LISTENER_FN(l);
-        func(e);
+inline void Event<E>::notifyListeners(const E &e){
+    if (notifyDepth == 0 && (removedCount > 0 || unsorted)){
+        compact();
+    }
+    notifyDepth++;
+    // listeners added during notification are stored in pendingListeners, so the array is not reallocated
+    size_t count = listeners.size();
+    for (size_t i = 0; i < count; i++){
+        if (listeners[i].slot != Removed){
+            listeners[i].function(e);
+        }
+    }
+    notifyDepth--;
+    if (notifyDepth == 0 && (!pendingListeners.empty() || removedCount > 0)){
+        compact();
+    }
+}
+
+template <typename E>
+inline bool Event<E>::removeListener(int64_t id){
+    Listener *listener = findListener(id);
+    if (!listener){
+        return false;
+    }
+    uint32_t slotIndex = listener->slot;
+    Slot &slot = slots[slotIndex];
+    slot.generation++;
+    if (slot.generation < MaxGeneration){
+        freeSlots.push_back(slotIndex);
+    }
+    // the listener may be executing, so the callable is destroyed when compacted
+    listener->slot = Removed;
+    removedCount++;
+    if (notifyDepth == 0 && removedCount * 2 > listeners.size() + pendingListeners.size()){
+        compact();
+    }
+    return true;
+}
+
+template <typename E>
+inline size_t Event<E>::listenerCount() const {
+    return listeners.size() + pendingListeners.size() - removedCount;
+}
+
+template <typename E>
+inline int64_t Event<E>::addListener(detail::EventFunction<E> &&function, int sortPriority){
+    uint32_t slotIndex;
+    if (freeSlots.empty()){
+        slotIndex = (uint32_t)slots.size();
+        slots.push_back(Slot{0, 0});
+    } else {
+        slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    std::vector<Listener> &target = notifyDepth > 0 ? pendingListeners : listeners;
+    if (!target.empty() && target.back().sortPriority > sortPriority){
+        unsorted = true;
     }
+    Slot &slot = slots[slotIndex];
+    slot.index = (uint32_t)target.size() | (notifyDepth > 0 ? Pending : 0);
+    target.push_back(Listener{std::move(function), sortPriority, nextSequence++, slotIndex});
+    return (int64_t)(((uint64_t)slot.generation << SlotBits) | slotIndex);
 }
 
 template <typename E>
-inline bool Event<E>::removeListener(int id){
-    auto iter = listeners.begin();
-    while (iter != listeners.end()){
-        if (GET_LISTENER_ID(*iter) == id){
-            listeners.erase(iter);
-            return true;
+inline typename Event<E>::Listener *Event<E>::findListener(int64_t id){
+    if (id < 0){
+        return nullptr;
+    }
+    uint32_t slotIndex = (uint32_t)id;
+    uint32_t generation = (uint32_t)((uint64_t)id >> SlotBits);
+    if (slotIndex >= slots.size()){
+        return nullptr;
+    }
+    const Slot &slot = slots[slotIndex];
+    if (slot.generation != generation){
+        return nullptr;
+    }
+    Listener &listener = (slot.index & Pending) ? pendingListeners[slot.index & ~Pending] : listeners[slot.index];
+    return listener.slot == slotIndex ? &listener : nullptr;
+}
+
+template <typename E>
+inline void Event<E>::compact(){
+    if (!pendingListeners.empty()){
+        if (!listeners.empty() && listeners.back().sortPriority > pendingListeners.front().sortPriority){
+            unsorted = true;
         }
-        iter++;
+        for (auto & listener : pendingListeners){
+            listeners.push_back(std::move(listener));
+        }
+        pendingListeners.clear();
+    }
+    if (removedCount > 0){
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](const Listener &l){
+            return l.slot == Removed;
+        }), listeners.end());
+        removedCount = 0;
     }
-    return false;
+    if (unsorted){
+        std::sort(listeners.begin(), listeners.end(), [](const Listener &a, const Listener &b){
+            return a.sortPriority < b.sortPriority || (a.sortPriority == b.sortPriority && a.sequence < b.sequence);
+        });
+        unsorted = false;
+    }
+    for (uint32_t i = 0; i < listeners.size(); i++){
+        slots[listeners[i].slot].index = i;
+    }
+}
 }
-}
\ No newline at end of file
@@ -11,7 +11,7 @@
 
 namespace kick {
     
-    AbstractEventListener::AbstractEventListener(AbstractEvent *ae, int listenerId)
+    AbstractEventListener::AbstractEventListener(AbstractEvent *ae, int64_t listenerId)
     :ae(ae), listenerId(listenerId){
     }
     
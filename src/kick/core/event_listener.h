@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 
 namespace kick {
@@ -16,7 +17,7 @@ namespace kick {
     class AbstractEventListener{
     public:
         AbstractEventListener(){};
-        AbstractEventListener(AbstractEvent *ae, int listenerId);
+        AbstractEventListener(AbstractEvent *ae, int64_t listenerId);
         AbstractEventListener(const AbstractEventListener&) = delete;
         AbstractEventListener& operator=( const AbstractEventListener& rhs ) = delete;
         
@@ -24,7 +25,7 @@ namespace kick {
         friend class AbstractEvent;
     protected:
         void destroyListener();
-        int listenerId = -1;
+        int64_t listenerId = -1;
         AbstractEvent *ae = nullptr;
     };
     
@@ -36,7 +37,7 @@ namespace kick {
     public:
         EventListener();
 
-        EventListener(Event<E> *e, int listenerId);
+        EventListener(Event<E> *e, int64_t listenerId);
         
         EventListener(const EventListener&) = delete;
         EventListener& operator=( const EventListener& rhs ) = delete;
@@ -4,7 +4,7 @@ namespace kick{
     };
 
     template <typename E>
-    inline EventListener<E>::EventListener(Event<E> *e, int listenerId)
+    inline EventListener<E>::EventListener(Event<E> *e, int64_t listenerId)
     :AbstractEventListener(e, listenerId)
     {
     }
@@ -0,0 +1,247 @@
+//
+//  job_system.cpp
+//  KickCPP
+//
+
+#include "kick/core/job_system.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+namespace kick {
+
+    namespace {
+        // the job system and queue index of the current thread
+        thread_local JobSystem *threadJobSystem = nullptr;
+        thread_local int threadQueueIndex = 0;
+    }
+
+    Job::Job(std::function<void()> &&function, std::shared_ptr<Job> parent, JobAffinity affinity)
+    : mFunction(move(function)), mParent(move(parent)), mUnfinishedJobs(1), mAffinity(affinity)
+    {
+    }
+
+    bool Job::completed() const {
+        return mUnfinishedJobs.load() == 0;
+    }
+
+    JobAffinity Job::affinity() const {
+        return mAffinity;
+    }
+
+    JobSystem::JobSystem(int workerThreads)
+    : mMainThreadId(this_thread::get_id())
+    {
+#ifdef EMSCRIPTEN
+        workerThreads = 0;
+#else
+        if (workerThreads < 0){
+            workerThreads = max(0, (int)thread::hardware_concurrency() - 1);
+        }
+#endif
+        for (int i = 0; i <= workerThreads; i++){
+            mQueues.emplace_back(new WorkQueue());
+        }
+        threadJobSystem = this;
+        threadQueueIndex = 0;
+        for (int i = 1; i <= workerThreads; i++){
+            mThreads.emplace_back(&JobSystem::workerMain, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            lock_guard<mutex> lock(mWakeMutex);
+            mRunning = false;
+        }
+        mWakeCondition.notify_all();
+        for (auto & thread : mThreads){
+            thread.join();
+        }
+        if (threadJobSystem == this){
+            threadJobSystem = nullptr;
+        }
+    }
+
+    std::shared_ptr<Job> JobSystem::createJob(std::function<void()> function, std::shared_ptr<Job> parent, JobAffinity affinity) {
+        if (parent){
+            assert(!parent->completed());
+            parent->mUnfinishedJobs++;
+        }
+        return make_shared<Job>(move(function), move(parent), affinity);
+    }
+
+    void JobSystem::run(std::shared_ptr<Job> job) {
+        if (job->mAffinity == JobAffinity::MainThread){
+            lock_guard<mutex> lock(mMainThreadQueue.mutex);
+            mMainThreadQueue.jobs.push_back(move(job));
+            return;
+        }
+        WorkQueue &queue = *mQueues[queueIndex()];
+        {
+            lock_guard<mutex> lock(queue.mutex);
+            queue.jobs.push_back(move(job));
+        }
+        mPendingJobs++;
+        if (!mThreads.empty()){
+            // lock to avoid a lost wakeup between a worker's test of mPendingJobs and its wait
+            { lock_guard<mutex> lock(mWakeMutex); }
+            mWakeCondition.notify_one();
+        }
+    }
+
+    void JobSystem::wait(const std::shared_ptr<Job> &job) {
+        int index = queueIndex();
+        while (!job->completed()){
+            if (!executeNext(index)){
+                this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::execute(std::function<void()> function, JobAffinity affinity) {
+        auto job = createJob(move(function), nullptr, affinity);
+        run(job);
+        wait(job);
+    }
+
+    void JobSystem::parallelFor(int begin, int end, std::function<void(int, int)> function, int batchSize) {
+        if (end <= begin){
+            return;
+        }
+        if (mThreads.empty()){
+            function(begin, end);
+            return;
+        }
+        // avoid creating many more batches than threads
+        int threadCount = (int)mThreads.size() + 1;
+        int count = end - begin;
+        batchSize = max(max(batchSize, 1), (count + threadCount * 4 - 1) / (threadCount * 4));
+        auto root = createJob([]{});
+        for (int batchBegin = begin; batchBegin < end; batchBegin += batchSize){
+            int batchEnd = min(end, batchBegin + batchSize);
+            run(createJob([&function, batchBegin, batchEnd]{
+                function(batchBegin, batchEnd);
+            }, root));
+        }
+        run(root);
+        wait(root);
+    }
+
+    void JobSystem::runMainThreadJobs() {
+        assert(isMainThread());
+        while (true){
+            shared_ptr<Job> job;
+            {
+                lock_guard<mutex> lock(mMainThreadQueue.mutex);
+                if (mMainThreadQueue.jobs.empty()){
+                    return;
+                }
+                job = move(mMainThreadQueue.jobs.front());
+                mMainThreadQueue.jobs.pop_front();
+            }
+            execute(job);
+        }
+    }
+
+    int JobSystem::workerThreadCount() const {
+        return (int)mThreads.size();
+    }
+
+    bool JobSystem::isMainThread() const {
+        return this_thread::get_id() == mMainThreadId;
+    }
+
+    void JobSystem::workerMain(int queueIndex) {
+        threadJobSystem = this;
+        threadQueueIndex = queueIndex;
+        while (mRunning){
+            if (executeNext(queueIndex)){
+                continue;
+            }
+            unique_lock<mutex> lock(mWakeMutex);
+            mWakeCondition.wait(lock, [&]{
+                return mPendingJobs.load() > 0 || !mRunning;
+            });
+        }
+    }
+
+    std::shared_ptr<Job> JobSystem::nextJob(int queueIndex) {
+        // pop from the back of own queue (most recently pushed)
+        {
+            WorkQueue &queue = *mQueues[queueIndex];
+            lock_guard<mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()){
+                auto job = move(queue.jobs.back());
+                queue.jobs.pop_back();
+                mPendingJobs--;
+                return job;
+            }
+        }
+        // steal from the front of the other queues (oldest jobs)
+        int queueCount = (int)mQueues.size();
+        for (int i = 1; i < queueCount; i++){
+            WorkQueue &queue = *mQueues[(queueIndex + i) % queueCount];
+            lock_guard<mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()){
+                auto job = move(queue.jobs.front());
+                queue.jobs.pop_front();
+                mPendingJobs--;
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool JobSystem::executeNext(int queueIndex) {
+        if (queueIndex == 0 && isMainThread()){
+            shared_ptr<Job> job;
+            {
+                lock_guard<mutex> lock(mMainThreadQueue.mutex);
+                if (!mMainThreadQueue.jobs.empty()){
+                    job = move(mMainThreadQueue.jobs.front());
+                    mMainThreadQueue.jobs.pop_front();
+                }
+            }
+            if (job){
+                execute(job);
+                return true;
+            }
+        }
+        auto job = nextJob(queueIndex);
+        if (!job){
+            return false;
+        }
+        execute(job);
+        return true;
+    }
+
+    void JobSystem::execute(const std::shared_ptr<Job> &job) {
+        if (job->mFunction){
+            job->mFunction();
+        }
+        finish(job);
+    }
+
+    void JobSystem::finish(const std::shared_ptr<Job> &job) {
+        if (--job->mUnfinishedJobs == 0){
+            auto parent = move(job->mParent);
+            if (parent){
+                finish(parent);
+            }
+        }
+    }
+
+    int JobSystem::threadIndex() const {
+        return queueIndex();
+    }
+
+    int JobSystem::queueIndex() const {
+        if (threadJobSystem == this){
+            return threadQueueIndex;
+        }
+        // threads not owned by the job system use the main thread queue
+        return 0;
+    }
+}
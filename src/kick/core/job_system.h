@@ -0,0 +1,96 @@
+//
+//  job_system.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace kick {
+
+    enum class JobAffinity {
+        Any,        // the job may run on any thread
+        MainThread  // the job must run on the main thread (such as OpenGL calls)
+    };
+
+    class JobSystem;
+
+    /// A unit of work scheduled on the JobSystem. A job is not completed before all its child jobs are completed.
+    class Job {
+    public:
+        Job(std::function<void()> &&function, std::shared_ptr<Job> parent, JobAffinity affinity);
+        bool completed() const;
+        JobAffinity affinity() const;
+    private:
+        friend class JobSystem;
+        std::function<void()> mFunction;
+        std::shared_ptr<Job> mParent;
+        // the job itself + the number of unfinished children
+        std::atomic<int> mUnfinishedJobs;
+        JobAffinity mAffinity;
+    };
+
+    /// Work stealing task scheduler. Each thread (the main thread and the worker threads) has its own deque of jobs.
+    /// A thread pushes and pops jobs at the back of its own deque, and steals from the front of the other deques
+    /// when its own deque is empty. Jobs with main thread affinity are only executed on the main thread (the thread
+    /// that created the JobSystem), either when the main thread waits for a job or in runMainThreadJobs().
+    /// With zero worker threads all jobs are executed on the main thread when waited for.
+    class JobSystem {
+    public:
+        // workerThreads < 0 means one worker per hardware thread (minus the main thread)
+        explicit JobSystem(int workerThreads = -1);
+        ~JobSystem();
+
+        // Create a job. If a parent is specified, the parent will not complete before the job has completed.
+        // The job is not executed before run() is called
+        std::shared_ptr<Job> createJob(std::function<void()> function, std::shared_ptr<Job> parent = nullptr, JobAffinity affinity = JobAffinity::Any);
+        // Schedule the job for execution
+        void run(std::shared_ptr<Job> job);
+        // Wait for the job (and its children) to complete. The calling thread executes other jobs while waiting
+        void wait(const std::shared_ptr<Job> &job);
+        // Create, run and wait for a job
+        void execute(std::function<void()> function, JobAffinity affinity = JobAffinity::Any);
+
+        // Split the range [begin;end) into batches of at least batchSize elements and invoke function(begin, end)
+        // for each batch in parallel. Returns when all batches are processed.
+        void parallelFor(int begin, int end, std::function<void(int,int)> function, int batchSize = 64);
+
+        // Execute pending main thread jobs. Must be called from the main thread
+        void runMainThreadJobs();
+
+        int workerThreadCount() const;
+        bool isMainThread() const;
+        // 0 on the main thread (and threads not owned by the job system), 1 to workerThreadCount() on the workers
+        int threadIndex() const;
+    private:
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<std::shared_ptr<Job>> jobs;
+        };
+        JobSystem(const JobSystem&) = delete;
+        void workerMain(int queueIndex);
+        std::shared_ptr<Job> nextJob(int queueIndex);
+        bool executeNext(int queueIndex);
+        void execute(const std::shared_ptr<Job> &job);
+        void finish(const std::shared_ptr<Job> &job);
+        int queueIndex() const;
+
+        // queue 0 is the main thread
+        std::vector<std::unique_ptr<WorkQueue>> mQueues;
+        WorkQueue mMainThreadQueue;
+        std::vector<std::thread> mThreads;
+        std::thread::id mMainThreadId;
+        std::mutex mWakeMutex;
+        std::condition_variable mWakeCondition;
+        std::atomic<int> mPendingJobs{0};
+        std::atomic<bool> mRunning{true};
+    };
+}
@@ -7,6 +7,7 @@
 //
 
 #include "kick/core/kickgl.h"
+#include "kick/core/render_stats.h"
 
 #include <iostream>
 
@@ -56,4 +57,250 @@ namespace kick {
         }
         return retCode;
     }
-}
\ No newline at end of file
+
+    namespace {
+        const GLuint unknown = 0xffffffff;
+        const int maxTextureUnits = 32;
+
+        enum Capability {
+            Blend,
+            CullFace,
+            DepthTest,
+            ScissorTest,
+            LineSmooth,
+            CapabilityCount
+        };
+
+        struct TextureUnit {
+            GLenum target;
+            GLuint texture;
+        };
+
+        struct ShadowState {
+            GLuint program;
+            GLuint vertexArray;
+            GLuint arrayBuffer;
+            GLuint elementArrayBuffer;
+            int activeTexture;
+            TextureUnit textureUnits[maxTextureUnits];
+            // 0 = disabled, 1 = enabled, -1 = unknown
+            int capabilities[CapabilityCount];
+            GLenum cullFace;
+            GLenum depthFunc;
+            int depthMask;
+            GLenum blendFunc[4];
+            GLint viewport[4];
+            GLint scissor[4];
+            bool viewportKnown;
+            bool scissorKnown;
+
+            ShadowState(){
+                invalidate();
+            }
+
+            void invalidate(){
+                program = vertexArray = arrayBuffer = elementArrayBuffer = unknown;
+                activeTexture = -1;
+                for (auto & unit : textureUnits){
+                    unit = TextureUnit{0, unknown};
+                }
+                for (auto & capability : capabilities){
+                    capability = -1;
+                }
+                cullFace = depthFunc = unknown;
+                depthMask = -1;
+                for (auto & factor : blendFunc){
+                    factor = unknown;
+                }
+                viewportKnown = scissorKnown = false;
+            }
+        };
+
+        ShadowState state;
+
+        int capabilityIndex(GLenum capability){
+            switch (capability){
+                case GL_BLEND: return Blend;
+                case GL_CULL_FACE: return CullFace;
+                case GL_DEPTH_TEST: return DepthTest;
+                case GL_SCISSOR_TEST: return ScissorTest;
+#ifndef KICK_CONTEXT_ES2
+                case GL_LINE_SMOOTH: return LineSmooth;
+#endif
+                default: return -1;
+            }
+        }
+
+        bool setRect(GLint *rect, bool &known, GLint x, GLint y, GLsizei width, GLsizei height){
+            if (known && rect[0] == x && rect[1] == y && rect[2] == width && rect[3] == height){
+                return false;
+            }
+            rect[0] = x;
+            rect[1] = y;
+            rect[2] = width;
+            rect[3] = height;
+            known = true;
+            return true;
+        }
+    }
+
+    void GLState::invalidate() {
+        state.invalidate();
+    }
+
+    void GLState::useProgram(GLuint program) {
+        if (state.program != program){
+            state.program = program;
+            glUseProgram(program);
+            RenderStats::current.programSwitches++;
+        }
+    }
+
+    void GLState::bindVertexArray(GLuint vertexArray) {
+#ifndef GL_ES_VERSION_2_0
+        if (state.vertexArray != vertexArray){
+            state.vertexArray = vertexArray;
+            // the element array buffer binding is stored in the vertex array
+            state.elementArrayBuffer = unknown;
+            glBindVertexArray(vertexArray);
+            RenderStats::current.vertexArraySwitches++;
+        }
+#endif
+    }
+
+    void GLState::bindBuffer(GLenum target, GLuint buffer) {
+        GLuint *bound = target == GL_ARRAY_BUFFER ? &state.arrayBuffer :
+                (target == GL_ELEMENT_ARRAY_BUFFER ? &state.elementArrayBuffer : nullptr);
+        if (!bound){
+            glBindBuffer(target, buffer);
+        } else if (*bound != buffer){
+            *bound = buffer;
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    void GLState::activeTexture(int unit) {
+        if (state.activeTexture != unit){
+            state.activeTexture = unit;
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+
+    void GLState::bindTexture(int unit, GLenum target, GLuint texture) {
+        if (unit >= 0 && unit < maxTextureUnits){
+            TextureUnit &bound = state.textureUnits[unit];
+            if (bound.texture == texture && bound.target == target){
+                return;
+            }
+            bound = TextureUnit{target, texture};
+        }
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        RenderStats::current.textureSwitches++;
+    }
+
+    void GLState::bindTexture(GLenum target, GLuint texture) {
+        bindTexture(state.activeTexture < 0 ? 0 : state.activeTexture, target, texture);
+    }
+
+    void GLState::setEnabled(GLenum capability, bool enabled) {
+        int index = capabilityIndex(capability);
+        if (index >= 0){
+            if (state.capabilities[index] == (int)enabled){
+                return;
+            }
+            state.capabilities[index] = enabled;
+        }
+        if (enabled){
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+
+    void GLState::cullFace(GLenum mode) {
+        if (state.cullFace != mode){
+            state.cullFace = mode;
+            glCullFace(mode);
+        }
+    }
+
+    void GLState::depthFunc(GLenum func) {
+        if (state.depthFunc != func){
+            state.depthFunc = func;
+            glDepthFunc(func);
+        }
+    }
+
+    void GLState::depthMask(bool write) {
+        if (state.depthMask != (int)write){
+            state.depthMask = write;
+            glDepthMask(write ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    void GLState::blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+        GLenum *f = state.blendFunc;
+        if (f[0] != srcRGB || f[1] != dstRGB || f[2] != srcAlpha || f[3] != dstAlpha){
+            f[0] = srcRGB;
+            f[1] = dstRGB;
+            f[2] = srcAlpha;
+            f[3] = dstAlpha;
+            glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+        }
+    }
+
+    void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (setRect(state.viewport, state.viewportKnown, x, y, width, height)){
+            glViewport(x, y, width, height);
+        }
+    }
+
+    void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (setRect(state.scissor, state.scissorKnown, x, y, width, height)){
+            glScissor(x, y, width, height);
+        }
+    }
+
+    void GLState::deleteProgram(GLuint program) {
+        if (state.program == program){
+            state.program = unknown;
+        }
+        glDeleteProgram(program);
+    }
+
+    void GLState::deleteVertexArrays(GLsizei count, const GLuint *vertexArrays) {
+#ifndef GL_ES_VERSION_2_0
+        for (GLsizei i = 0; i < count; i++){
+            if (state.vertexArray == vertexArrays[i]){
+                state.vertexArray = unknown;
+                state.elementArrayBuffer = unknown;
+            }
+        }
+        glDeleteVertexArrays(count, vertexArrays);
+#endif
+    }
+
+    void GLState::deleteBuffers(GLsizei count, const GLuint *buffers) {
+        for (GLsizei i = 0; i < count; i++){
+            if (state.arrayBuffer == buffers[i]){
+                state.arrayBuffer = unknown;
+            }
+            if (state.elementArrayBuffer == buffers[i]){
+                state.elementArrayBuffer = unknown;
+            }
+        }
+        glDeleteBuffers(count, buffers);
+    }
+
+    void GLState::deleteTextures(GLsizei count, const GLuint *textures) {
+        for (GLsizei i = 0; i < count; i++){
+            for (auto & unit : state.textureUnits){
+                if (unit.texture == textures[i]){
+                    unit.texture = unknown;
+                }
+            }
+        }
+        glDeleteTextures(count, textures);
+    }
+}
@@ -33,4 +33,38 @@ namespace kick {
     const char * GLErrorString(GLenum errorCode);
 
     int printOglError(const char *file, int line);
+
+    /// Shadow copy of the GL state changed by kick. Calls that do not change the state are skipped.
+    /// Tracks the program, vertex array, array and element array buffers, texture units, the blend, depth and
+    /// face culling state and the viewport and scissor box. Code that changes this state without using GLState
+    /// (such as third party GL code) must call invalidate() afterwards. Must only be used on the GL thread.
+    class GLState {
+    public:
+        // forget the shadowed state, so the next call of each function is passed on to GL
+        static void invalidate();
+
+        static void useProgram(GLuint program);
+        static void bindVertexArray(GLuint vertexArray);
+        // the element array buffer binding is part of the vertex array state
+        static void bindBuffer(GLenum target, GLuint buffer);
+        static void activeTexture(int unit);
+        static void bindTexture(int unit, GLenum target, GLuint texture);
+        // bind to the active texture unit
+        static void bindTexture(GLenum target, GLuint texture);
+
+        // GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST and GL_LINE_SMOOTH are tracked
+        static void setEnabled(GLenum capability, bool enabled);
+        static void cullFace(GLenum mode);
+        static void depthFunc(GLenum func);
+        static void depthMask(bool write);
+        static void blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+        static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+        static void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        // delete the objects and remove them from the shadowed state (since the names may be reused)
+        static void deleteProgram(GLuint program);
+        static void deleteVertexArrays(GLsizei count, const GLuint *vertexArrays);
+        static void deleteBuffers(GLsizei count, const GLuint *buffers);
+        static void deleteTextures(GLsizei count, const GLuint *textures);
+    };
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+//
+//  pool_allocator.cpp
+//  KickCPP
+//
+
+#include "kick/core/pool_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+using namespace std;
+
+namespace kick {
+
+    PoolAllocator::PoolAllocator(size_t blockSize, size_t blockAlignment, size_t blocksPerSlab)
+    : mBlocksPerSlab(max<size_t>(blocksPerSlab, 1))
+    {
+        // slabs are allocated using operator new, which is aligned for any fundamental type
+        assert(blockAlignment <= alignof(max_align_t));
+        blockAlignment = max(blockAlignment, alignof(FreeBlock));
+        blockSize = max(blockSize, sizeof(FreeBlock));
+        mBlockSize = (blockSize + blockAlignment - 1) / blockAlignment * blockAlignment;
+    }
+
+    PoolAllocator::~PoolAllocator() {
+        for (auto slab : mSlabs){
+            ::operator delete(slab);
+        }
+    }
+
+    void *PoolAllocator::allocate() {
+        lock_guard<mutex> lock(mMutex);
+        if (!mFreeList){
+            allocateSlab(mBlocksPerSlab);
+        }
+        FreeBlock *block = mFreeList;
+        mFreeList = block->next;
+        mAllocationCount++;
+        mLiveCount++;
+        return block;
+    }
+
+    void PoolAllocator::deallocate(void *block) {
+        if (!block){
+            return;
+        }
+        lock_guard<mutex> lock(mMutex);
+        FreeBlock *freeBlock = static_cast<FreeBlock*>(block);
+        freeBlock->next = mFreeList;
+        mFreeList = freeBlock;
+        mLiveCount--;
+    }
+
+    void PoolAllocator::reserve(size_t count) {
+        lock_guard<mutex> lock(mMutex);
+        size_t freeCount = mCapacity - mLiveCount;
+        if (freeCount < count){
+            allocateSlab(count - freeCount);
+        }
+    }
+
+    size_t PoolAllocator::blockSize() const {
+        return mBlockSize;
+    }
+
+    size_t PoolAllocator::slabCount() const {
+        lock_guard<mutex> lock(mMutex);
+        return mSlabs.size();
+    }
+
+    size_t PoolAllocator::allocationCount() const {
+        lock_guard<mutex> lock(mMutex);
+        return mAllocationCount;
+    }
+
+    size_t PoolAllocator::liveCount() const {
+        lock_guard<mutex> lock(mMutex);
+        return mLiveCount;
+    }
+
+    void PoolAllocator::allocateSlab(size_t blockCount) {
+        char *slab = static_cast<char*>(::operator new(mBlockSize * blockCount));
+        mSlabs.push_back(slab);
+        mCapacity += blockCount;
+        // link the blocks in address order
+        for (size_t i = blockCount; i > 0; i--){
+            FreeBlock *block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * mBlockSize);
+            block->next = mFreeList;
+            mFreeList = block;
+        }
+    }
+
+    int createPoolTypeId(){
+        static atomic<int> counter{0};
+        return counter++;
+    }
+
+    size_t PoolAllocators::slabCount() const {
+        lock_guard<mutex> lock(mMutex);
+        size_t res = 0;
+        for (auto & pool : mPools){
+            if (pool){
+                res += pool->slabCount();
+            }
+        }
+        return res;
+    }
+
+    size_t PoolAllocators::allocationCount() const {
+        lock_guard<mutex> lock(mMutex);
+        size_t res = 0;
+        for (auto & pool : mPools){
+            if (pool){
+                res += pool->allocationCount();
+            }
+        }
+        return res;
+    }
+
+    size_t PoolAllocators::liveCount() const {
+        lock_guard<mutex> lock(mMutex);
+        size_t res = 0;
+        for (auto & pool : mPools){
+            if (pool){
+                res += pool->liveCount();
+            }
+        }
+        return res;
+    }
+}
@@ -0,0 +1,138 @@
+//
+//  pool_allocator.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace kick {
+
+    /// Fixed size block allocator. Blocks are allocated from slabs of blocksPerSlab blocks, so objects in the same
+    /// pool are stored contiguously. Freed blocks are reused and slabs are not returned to the heap before the pool
+    /// is destroyed.
+    class PoolAllocator {
+    public:
+        PoolAllocator(size_t blockSize, size_t blockAlignment, size_t blocksPerSlab = 64);
+        ~PoolAllocator();
+        void *allocate();
+        void deallocate(void *block);
+        // Make sure that at least count blocks can be allocated without allocating from the heap (the missing blocks
+        // are allocated in a single slab)
+        void reserve(size_t count);
+
+        size_t blockSize() const;
+        // number of slabs allocated from the heap
+        size_t slabCount() const;
+        // total number of blocks allocated
+        size_t allocationCount() const;
+        // number of blocks currently allocated
+        size_t liveCount() const;
+    private:
+        PoolAllocator(const PoolAllocator&) = delete;
+        PoolAllocator& operator=(const PoolAllocator&) = delete;
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+        void allocateSlab(size_t blockCount);
+
+        size_t mBlockSize;
+        size_t mBlocksPerSlab;
+        size_t mCapacity = 0;
+        std::vector<void*> mSlabs;
+        FreeBlock *mFreeList = nullptr;
+        size_t mAllocationCount = 0;
+        size_t mLiveCount = 0;
+        // blocks may be freed on other threads when the last shared_ptr is released there
+        mutable std::mutex mMutex;
+    };
+
+    // Returns a new pool type id. Use poolTypeId<T>() instead
+    int createPoolTypeId();
+
+    template <typename T>
+    inline int poolTypeId(){
+        static const int id = createPoolTypeId();
+        return id;
+    }
+
+    /// A set of pools, one for each type allocated
+    class PoolAllocators {
+    public:
+        // Return the pool for objects of type T (the pool is created on first use). Thread safe, since allocators are
+        // rebound (and look up their pool) on any thread, such as in allocate_shared on a worker thread.
+        template <typename T>
+        PoolAllocator *pool(){
+            int id = poolTypeId<T>();
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (id >= (int)mPools.size()){
+                mPools.resize(id + 1);
+            }
+            if (!mPools[id]){
+                mPools[id].reset(new PoolAllocator(sizeof(T), alignof(T)));
+            }
+            return mPools[id].get();
+        }
+
+        // Sums of the counters of all pools
+        size_t slabCount() const;
+        size_t allocationCount() const;
+        size_t liveCount() const;
+    private:
+        std::vector<std::unique_ptr<PoolAllocator>> mPools;
+        mutable std::mutex mMutex;
+    };
+
+    /// STL allocator for single objects using PoolAllocators. Used with std::allocate_shared, which allocates the
+    /// object and the reference count in a single block. The allocator keeps the pools alive, so shared pointers may
+    /// outlive the owner of the pools. Array allocations are forwarded to the heap.
+    template <typename T>
+    class PoolStlAllocator {
+    public:
+        typedef T value_type;
+
+        explicit PoolStlAllocator(std::shared_ptr<PoolAllocators> pools)
+        : mPools(std::move(pools)), mPool(mPools->template pool<T>())
+        {}
+
+        template <typename U>
+        PoolStlAllocator(const PoolStlAllocator<U> &other)
+        : mPools(other.mPools), mPool(mPools->template pool<T>())
+        {}
+
+        T *allocate(size_t n){
+            if (n == 1){
+                return static_cast<T*>(mPool->allocate());
+            }
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t n){
+            if (n == 1){
+                mPool->deallocate(p);
+            } else {
+                ::operator delete(p);
+            }
+        }
+
+        template <typename U>
+        struct rebind {
+            typedef PoolStlAllocator<U> other;
+        };
+
+        template <typename U>
+        bool operator==(const PoolStlAllocator<U> &other) const { return mPools == other.mPools; }
+        template <typename U>
+        bool operator!=(const PoolStlAllocator<U> &other) const { return mPools != other.mPools; }
+    private:
+        template <typename U>
+        friend class PoolStlAllocator;
+        std::shared_ptr<PoolAllocators> mPools;
+        PoolAllocator *mPool;
+    };
+}
@@ -8,11 +8,13 @@
 
 #include "kick/core/project_asset.h"
 #include "kick/core/project.h"
+#include <atomic>
 
 namespace kick {
     ProjectAsset::ProjectAsset()
     {
-        
+        static std::atomic<int> counter{0};
+        mUid = ++counter;
     }
     
     ProjectAsset::~ProjectAsset(){
@@ -20,6 +22,10 @@ namespace kick {
     }
     
     void ProjectAsset::destroy(){
-        uid = 0;
+        mUid = 0;
+    }
+
+    int ProjectAsset::uid() const {
+        return mUid;
     }
 }
\ No newline at end of file
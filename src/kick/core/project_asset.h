@@ -18,11 +18,13 @@ namespace kick {
         ProjectAsset();
         ~ProjectAsset();
         virtual void destroy();
+        // unique id of the asset (0 when destroyed)
+        int uid() const;
         friend class Project;
     protected:
 
     private:
         ProjectAsset(const ProjectAsset&) = delete;
-        int uid;
+        int mUid;
     };
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+//
+//  render_stats.cpp
+//  KickCPP
+//
+
+#include "kick/core/render_stats.h"
+
+namespace kick {
+    RenderStats RenderStats::current;
+    RenderStats RenderStats::lastFrame;
+
+    void RenderStats::startFrame() {
+        lastFrame = current;
+        current = RenderStats{};
+    }
+
+    void RenderStats::drawCall() {
+        current.drawCalls++;
+    }
+}
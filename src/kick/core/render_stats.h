@@ -0,0 +1,27 @@
+//
+//  render_stats.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace kick {
+    /// Counts the draw calls and the GL state switches per frame. The switches are counted by GLState, so binds that
+    /// do not change the bound object are not counted. The counters are reset by Engine::render.
+    struct RenderStats {
+        int drawCalls = 0;
+        int programSwitches = 0;
+        int textureSwitches = 0;
+        int vertexArraySwitches = 0;
+
+        // counters of the frame being rendered
+        static RenderStats current;
+        // counters of the previous frame
+        static RenderStats lastFrame;
+
+        static void startFrame();
+        static void drawCall();
+    };
+}
@@ -3,16 +3,21 @@
 #include "kick/context/context.h"
 #include "kick/core/engine.h"
 #include "kick/core/event.h"
+#include "kick/core/job_system.h"
+#include "kick/core/render_stats.h"
 #include "kick/core/key_input.h"
 #include "kick/core/mouse_input.h"
+#include "kick/core/pool_allocator.h"
 #include "kick/core/project.h"
 #include "kick/core/project_asset.h"
 #include "kick/core/time.h"
 #include "kick/core/debug.h"
 #include "kick/material/material.h"
 #include "kick/material/shader.h"
+#include "kick/material/uniform_name.h"
 #include "kick/math/aabb.h"
 #include "kick/math/frustum.h"
+#include "kick/math/dynamic_aabb_tree.h"
 #include "kick/math/bounds2.h"
 #include "kick/math/bounds3.h"
 #include "kick/math/random.h"
@@ -28,16 +33,23 @@
 #include "kick/scene/camera_perspective.h"
 #include "kick/scene/camera_orthographic.h"
 #include "kick/scene/component.h"
+#include "kick/scene/component_registry.h"
 #include "kick/scene/skybox.h"
 #include "kick/scene/updatable.h"
 #include "kick/scene/component_renderable.h"
 #include "kick/scene/engine_uniforms.h"
+#include "kick/scene/engine_uniform_blocks.h"
 #include "kick/scene/game_object.h"
 #include "kick/scene/light.h"
 #include "kick/scene/mesh_renderer.h"
 #include "kick/scene/line_renderer.h"
 #include "kick/scene/scene.h"
+#include "kick/scene/scene_serializer.h"
+#include "kick/scene/render_queue.h"
+#include "kick/scene/instance_buffer.h"
+#include "kick/scene/static_batch.h"
 #include "kick/scene/transform.h"
+#include "kick/scene/transform_hierarchy.h"
 #include "kick/texture/texture2d.h"
 #include "kick/texture/texture_cube.h"
 #include "kick/texture/texture_render_target.h"
@@ -8,6 +8,8 @@
 
 #include "kick/material/material.h"
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <utility>
 #include <string>
@@ -36,9 +38,28 @@ namespace kick {
         return *this;
     }
 
-    void MaterialData::setValue(MaterialValueType val) {
-        for (int i=0;i<16;i++){
-            value.floatValue[i] = val.floatValue[i];
+    void MaterialData::setValue(const MaterialValueType& val) {
+        value = val;
+    }
+
+    namespace {
+        // size of a parameter value in floats
+        uint32_t parameterSize(int glType){
+            switch (glType){
+                case GL_INT:
+                case GL_FLOAT:
+                    return 1;
+                case GL_FLOAT_VEC4:
+                    return 4;
+                case GL_FLOAT_MAT3:
+                    return 9;
+                default:
+                    return 16;
+            }
+        }
+
+        bool isSampler(int glType){
+            return glType == GL_SAMPLER_2D || glType == GL_SAMPLER_CUBE;
         }
     }
     
@@ -48,22 +69,32 @@ namespace kick {
     }
 
     Material::Material(const Material& copy)
-            :currentUniformData(copy.currentUniformData),
+            :mParameters(copy.mParameters),
+             mParameterData(copy.mParameterData),
+             mTextures(copy.mTextures),
              mShader(nullptr),
              shaderChangedListener(),
-             mRenderOrder(copy.mRenderOrder),
-             texture2DRef(copy.texture2DRef),
-             textureCubeRef(copy.textureCubeRef)
+             mRenderOrder(copy.mRenderOrder)
     {
         setShader(copy.mShader);
     }
 
 
     Material::~Material(){
+        releaseShaderUniforms();
+    }
+
+    void Material::releaseShaderUniforms(){
+        for (Shader* shader : {mShader.get(), mShader ? mShader->mInstancedShader.get() : nullptr}){
+            if (shader && shader->mUniformsMaterial == this){
+                shader->mUniformsMaterial = nullptr;
+            }
+        }
     }
     
     void Material::setShader(std::shared_ptr<Shader> shader){
         if (this->mShader == shader) return;
+        releaseShaderUniforms();
         this->mShader = shader;
         if (shader){
             using namespace std::placeholders;
@@ -82,9 +113,11 @@ namespace kick {
         
     void Material::shaderChanged(ShaderEvent se){
         if (se.eventType == ShaderEventType::all || se.eventType == ShaderEventType::shader) {
-            for (auto &pair : currentUniformData) {
-                updateShaderLocation(pair.first, pair.second);
+            for (auto &parameter : mParameters) {
+                updateShaderLocation(parameter);
             }
+            // texture units may have changed
+            markAllDirty();
             mRenderOrder = mShader ? mShader->getRenderOrder() : 0;
         }
         if (se.eventType == ShaderEventType::all || se.eventType == ShaderEventType::defaultUniform) {
@@ -92,101 +125,159 @@ namespace kick {
         }
     }
     
-    void Material::updateShaderLocation(std::string name, MaterialData& value){
+    void Material::updateShaderLocation(MaterialParameter& parameter){
+        parameter.shaderLocation = -1;
+        parameter.instancedShaderLocation = -1;
         if (mShader == nullptr){
-            value.shaderLocation = -1;
             return;
         }
-        auto descriptor = mShader->getShaderUniform(name);
-        if (descriptor == nullptr){
-            value.shaderLocation = -1;
-        } else {
-            value.shaderLocation = descriptor->index;
+        auto descriptor = mShader->getShaderUniform(parameter.name.name());
+        if (descriptor){
+            parameter.shaderLocation = descriptor->index;
+        }
+        if (mShader->mInstancedShader){
+            descriptor = mShader->mInstancedShader->getShaderUniform(parameter.name.name());
+            if (descriptor){
+                parameter.instancedShaderLocation = descriptor->index;
+            }
         }
     }
-    
-    void Material::setUniformData(std::string name, MaterialData&& value){
-        auto pos = currentUniformData.find(name);
-        if (pos != currentUniformData.end()){
-            pos->second.setValue(value.value);
-            if (pos->second.glType != value.glType){
-                pos->second.glType = value.glType;
-                updateShaderLocation(name, pos->second);
+
+    void Material::markAllDirty(){
+        for (auto &parameter : mParameters) {
+            parameter.dirty = true;
+            parameter.instancedDirty = true;
+        }
+    }
+
+    MaterialParameter& Material::parameter(const UniformName& name, int glType){
+        for (auto &parameter : mParameters) {
+            if (parameter.name == name){
+                if (parameter.glType != glType){
+                    // reallocate if the value no longer fits
+                    if (isSampler(glType) != isSampler(parameter.glType) || parameterSize(glType) > parameterSize(parameter.glType)){
+                        parameter.offset = (uint32_t)(isSampler(glType) ? mTextures.size() : mParameterData.size());
+                        if (isSampler(glType)){
+                            mTextures.push_back(MaterialTexture{nullptr, nullptr, {}});
+                        } else {
+                            mParameterData.resize(mParameterData.size() + parameterSize(glType));
+                        }
+                    }
+                    parameter.glType = glType;
+                    updateShaderLocation(parameter);
+                    markAllDirty();
+                }
+                return parameter;
             }
+        }
+        // not found insert new
+        MaterialParameter parameter{name, glType, -1, -1, 0, false, true, true};
+        if (isSampler(glType)){
+            parameter.offset = (uint32_t)mTextures.size();
+            mTextures.push_back(MaterialTexture{nullptr, nullptr, {}});
         } else {
-            // not found insert new
-            auto insertedElement = currentUniformData.emplace(make_pair(name, move(value)));
-            bool didInsert = insertedElement.second;
-            assert(didInsert);
-            auto insertedIterator = insertedElement.first;
-            updateShaderLocation(name, insertedIterator->second);
+            parameter.offset = (uint32_t)mParameterData.size();
+            mParameterData.resize(mParameterData.size() + parameterSize(glType));
+        }
+        updateShaderLocation(parameter);
+        mParameters.push_back(parameter);
+        // texture units may have changed
+        markAllDirty();
+        return mParameters.back();
+    }
+
+    void Material::setParameter(const UniformName& name, int glType, const void* value, bool defaultUniform){
+        MaterialParameter& p = parameter(name, glType);
+        p.defaultUniform = defaultUniform;
+        float* data = &mParameterData[p.offset];
+        size_t size = parameterSize(glType) * sizeof(float);
+        if (memcmp(data, value, size) != 0){
+            memcpy(data, value, size);
+            p.dirty = true;
+            p.instancedDirty = true;
+        }
+    }
+
+    void Material::setParameter(const UniformName& name, const MaterialData& data, bool defaultUniform){
+        switch (data.glType){
+            case GL_SAMPLER_2D:
+                setTexture(name, data.glType, MaterialTexture{data.value.texture2D, nullptr, {}}, defaultUniform);
+                break;
+            case GL_SAMPLER_CUBE:
+                setTexture(name, data.glType, MaterialTexture{nullptr, data.value.textureCube, {}}, defaultUniform);
+                break;
+            default:
+                setParameter(name, data.glType, &data.value, defaultUniform);
+                break;
         }
     }
+
+    void Material::setTexture(const UniformName& name, int glType, MaterialTexture&& texture, bool defaultUniform){
+        MaterialParameter& p = parameter(name, glType);
+        p.defaultUniform = defaultUniform;
+        // textures are bound every time, so only the texture unit needs to be uploaded
+        mTextures[p.offset] = move(texture);
+    }
     
-    int Material::bind(){
+    int Material::bind(bool instanced){
         int currentTexture = 0;
-        for (auto & uniform : currentUniformData) {
-            auto & materialData = uniform.second;
-            if (materialData.shaderLocation == -1){
+        Shader* shader = mShader.get();
+        if (shader && instanced){
+            shader = shader->mInstancedShader.get();
+        }
+        // uniform values are part of the program state, so unchanged values are still present if this material
+        // was the last material bound to the program
+        bool uploadAll = true;
+        if (shader){
+            uploadAll = shader->mUniformsMaterial != this;
+            shader->mUniformsMaterial = this;
+        }
+        for (auto & parameter : mParameters) {
+            GLint location = instanced ? parameter.instancedShaderLocation : parameter.shaderLocation;
+            if (location == -1){
+                continue;
+            }
+            bool& dirty = instanced ? parameter.instancedDirty : parameter.dirty;
+            bool upload = uploadAll || dirty;
+            dirty = false;
+            if (isSampler(parameter.glType)){
+                auto & texture = mTextures[parameter.offset];
+                if (parameter.glType == GL_SAMPLER_CUBE){
+                    texture.textureCube->bind(currentTexture);
+                } else {
+                    texture.texture2D->bind(currentTexture);
+                }
+                if (upload){
+                    glUniform1i(location, currentTexture);
+                }
+                currentTexture++;
                 continue;
             }
-            GLint location = materialData.shaderLocation;
-            auto & value = materialData.value;
-            switch (materialData.glType) {
+            if (!upload){
+                continue;
+            }
+            const float* value = &mParameterData[parameter.offset];
+            switch (parameter.glType) {
                 case GL_FLOAT:
-                    glUniform1f(location, value.floatValue[0]);
-                    break;
-                case GL_FLOAT_MAT2:
-                    //glUniformMatrix2fv(location, false, value.mat2Value);
-//                    throw invalid_argument();
-                    logError("GL_FLOAT_MAT2 is currently unsupported");
+                    glUniform1f(location, value[0]);
                     break;
                 case GL_FLOAT_MAT3:
-                    glUniformMatrix3fv(location, 1, GL_FALSE, value.floatValue);
+                    glUniformMatrix3fv(location, 1, GL_FALSE, value);
                     break;
                 case GL_FLOAT_MAT4:
-                    glUniformMatrix4fv(location, 1, GL_FALSE, value.floatValue);
-                    break;
-                case GL_FLOAT_VEC2:
-                    //glUniform2fv(location, value.vec4Value);
-//                    throw invalid_argument("GL_FLOAT_VEC2 is currently unsupported");
-                    logError("GL_FLOAT_VEC2 is currently unsupported");
-                    break;
-                case GL_FLOAT_VEC3:
-//                    throw invalid_argument("GL_FLOAT_VEC3 is currently unsupported");
-                    logError("GL_FLOAT_VEC3 is currently unsupported");
+                    glUniformMatrix4fv(location, 1, GL_FALSE, value);
                     break;
                 case GL_FLOAT_VEC4:
-                    glUniform4fv(location, 1, value.floatValue);
-                    break;
-                case GL_INT:
-                    glUniform1i(location, value.intValue);
+                    glUniform4fv(location, 1, value);
                     break;
-                case GL_INT_VEC2:
-//                    throw invalid_argument("GL_INT_VEC2 is currently unsupported");
-                    logError("GL_INT_VEC2 is currently unsupported");
-                    break;
-                case GL_INT_VEC3:
-//                    throw invalid_argument("GL_INT_VEC3 is currently unsupported");
-                    logError("GL_INT_VEC3 is currently unsupported");
-                    break;
-                case GL_INT_VEC4:
-//                    throw invalid_argument("GL_INT_VEC4 is currently unsupported");
-                    logError("GL_INT_VEC4 is currently unsupported");
-                    break;
-                case GL_SAMPLER_CUBE:
-                    value.textureCube->bind(currentTexture);
-                    glUniform1i(location, currentTexture);
-                    currentTexture++;
-                    break;
-                case GL_SAMPLER_2D:
-                    value.texture2D->bind(currentTexture);
-                    glUniform1i(location, currentTexture);
-                    currentTexture++;
+                case GL_INT: {
+                    GLint intValue;
+                    memcpy(&intValue, value, sizeof(GLint));
+                    glUniform1i(location, intValue);
                     break;
+                }
                 default:
-//                    throw invalid_argument("Unhandled type");
-                    logError("Unhandled type");
+                    logError(std::string{"Unsupported material parameter type "}+std::to_string(parameter.glType));
             }
         }
         return currentTexture;
@@ -233,16 +324,19 @@ namespace kick {
             if (isAutoMapped){
                 continue;
             }
-            auto currentValue = currentUniformData.find(u.name);
-            bool isUnmapped = currentValue == currentUniformData.end();
-            if (isUnmapped || currentValue->second.defaultUniform){
+            UniformName name{u.name};
+            auto currentValue = find_if(mParameters.begin(), mParameters.end(), [&](const MaterialParameter& p){
+                return p.name == name;
+            });
+            bool isUnmapped = currentValue == mParameters.end();
+            if (isUnmapped || currentValue->defaultUniform){
                 unmappedOrDefaultUniforms.push_back(u.name);
             }
         }
         for (auto & name : unmappedOrDefaultUniforms){
             MaterialData mat{0};
             if (mShader->tryGetDefaultUniform(name, mat)){
-                setUniformData(name, move(mat));
+                setParameter(name, mat, true);
             }
         }
     }
@@ -251,33 +345,31 @@ namespace kick {
         return mRenderOrder;
     }
 
-    void Material::setUniform(std::string name, int value) {
-        setUniformInternal(name, value);
+    void Material::setUniform(const UniformName& name, int value) {
+        setParameter(name, GL_INT, &value, false);
     }
 
-    void Material::setUniform(std::string name, float value) {
-        setUniformInternal(name, value);
+    void Material::setUniform(const UniformName& name, float value) {
+        setParameter(name, GL_FLOAT, &value, false);
     }
 
-    void Material::setUniform(std::string name, glm::vec4 value) {
-        setUniformInternal(name, value);
+    void Material::setUniform(const UniformName& name, glm::vec4 value) {
+        setParameter(name, GL_FLOAT_VEC4, glm::value_ptr(value), false);
     }
 
-    void Material::setUniform(std::string name, glm::mat3 value) {
-        setUniformInternal(name, value);
+    void Material::setUniform(const UniformName& name, glm::mat3 value) {
+        setParameter(name, GL_FLOAT_MAT3, glm::value_ptr(value), false);
     }
 
-    void Material::setUniform(std::string name, glm::mat4 value) {
-        setUniformInternal(name, value);
+    void Material::setUniform(const UniformName& name, glm::mat4 value) {
+        setParameter(name, GL_FLOAT_MAT4, glm::value_ptr(value), false);
     }
 
-    void Material::setUniform(std::string name, std::shared_ptr<Texture2D> value) {
-        texture2DRef[name] = value;
-        setUniformInternal(name, value.get());
+    void Material::setUniform(const UniformName& name, std::shared_ptr<Texture2D> value) {
+        setTexture(name, GL_SAMPLER_2D, MaterialTexture{value.get(), nullptr, value}, false);
     }
 
-    void Material::setUniform(std::string name, std::shared_ptr<TextureCube> value) {
-        textureCubeRef[name] = value;
-        setUniformInternal(name, value.get());
+    void Material::setUniform(const UniformName& name, std::shared_ptr<TextureCube> value) {
+        setTexture(name, GL_SAMPLER_CUBE, MaterialTexture{nullptr, value.get(), value}, false);
     }
-}
\ No newline at end of file
+}
@@ -14,6 +14,7 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <map>
+#include <cstdint>
 #include <glm/gtc/type_ptr.hpp>
 #include "kick/core/project_asset.h"
 #include "kick/core/event_listener.h"
@@ -21,6 +22,7 @@
 #include "kick/texture/texture2d.h"
 #include "kick/texture/texture_cube.h"
 #include "shader_enums.h"
+#include "uniform_name.h"
 
 namespace kick {
     
@@ -55,7 +57,7 @@ namespace kick {
             TextureCube* textureCube;
         } value;
 
-        void setValue(MaterialValueType val);
+        void setValue(const MaterialValueType& val);
 
         int shaderLocation;
         int glType;
@@ -63,6 +65,25 @@ namespace kick {
         bool defaultUniform = false;
     };
     
+    // A material parameter compiled against the current shader (the shader location is resolved when the shader
+    // changes). The value is stored at offset in the parameter block of the material (for samplers offset is the
+    // index of the texture).
+    struct MaterialParameter {
+        UniformName name;
+        int glType;
+        int shaderLocation;
+        // location in the instanced variant of the shader
+        int instancedShaderLocation;
+        uint32_t offset;
+        // is the value inherited from the default uniform value in the shader
+        bool defaultUniform;
+        // the value has changed since it was last uploaded (to the shader and to the instanced variant)
+        bool dirty;
+        bool instancedDirty;
+    };
+
+    /// Material parameters are stored in a flat parameter block. Material::bind() only uploads the parameters that
+    /// has changed, if the material was the last material bound to the shader program.
     class Material : public ProjectAsset {
     public:
         explicit Material(std::shared_ptr<Shader> shader = {});
@@ -70,37 +91,44 @@ namespace kick {
         ~Material();
         void setShader(std::shared_ptr<Shader> shader);
         std::shared_ptr<Shader> shader();
-        void setUniform(std::string name, int value);
-        void setUniform(std::string name, float value);
-        void setUniform(std::string name, glm::vec4 value);
-        void setUniform(std::string name, glm::mat3 value);
-        void setUniform(std::string name, glm::mat4 value);
-        void setUniform(std::string name, std::shared_ptr<Texture2D> value);
-        void setUniform(std::string name, std::shared_ptr<TextureCube> value);
+        void setUniform(const UniformName& name, int value);
+        void setUniform(const UniformName& name, float value);
+        void setUniform(const UniformName& name, glm::vec4 value);
+        void setUniform(const UniformName& name, glm::mat3 value);
+        void setUniform(const UniformName& name, glm::mat4 value);
+        void setUniform(const UniformName& name, std::shared_ptr<Texture2D> value);
+        void setUniform(const UniformName& name, std::shared_ptr<TextureCube> value);
 
-        int bind();
+        /// Uploads the parameters to the shader (or to the instanced variant of the shader). Returns the number of
+        /// texture units used
+        int bind(bool instanced = false);
         int renderOrder();
+        const std::vector<MaterialParameter>& parameters() const { return mParameters; }
     private:
-        template <class E>
-        void setUniformInternal(std::string name, E value);
+        struct MaterialTexture {
+            Texture2D* texture2D;
+            TextureCube* textureCube;
+            // keeps the texture alive (empty for default uniforms owned by the shader)
+            std::shared_ptr<void> ref;
+        };
         void shaderChanged(ShaderEvent se);
         void setDefaultUniforms();
-        void updateShaderLocation(std::string name, MaterialData& value);
-        void setUniformData(std::string name, MaterialData&& value);
-        // current data (may misfit with current shader)
-        std::map<std::string, MaterialData> currentUniformData;
+        void updateShaderLocation(MaterialParameter& parameter);
+        MaterialParameter& parameter(const UniformName& name, int glType);
+        void setParameter(const UniformName& name, int glType, const void* value, bool defaultUniform);
+        void setParameter(const UniformName& name, const MaterialData& data, bool defaultUniform);
+        void setTexture(const UniformName& name, int glType, MaterialTexture&& texture, bool defaultUniform);
+        void markAllDirty();
+        // forget the uniforms uploaded to the shader (so the next material bound to the shader uploads all)
+        void releaseShaderUniforms();
+        std::vector<MaterialParameter> mParameters;
+        // values of int and float parameters (may misfit with current shader)
+        std::vector<float> mParameterData;
+        std::vector<MaterialTexture> mTextures;
         std::shared_ptr<Shader> mShader;
         EventListener<ShaderEvent> shaderChangedListener;
         int mRenderOrder = 1000;
-        std::map<std::string, std::shared_ptr<Texture2D>> texture2DRef;
-        std::map<std::string, std::shared_ptr<TextureCube>> textureCubeRef;
     };
     
     std::string to_string(MaterialData & data);
-
-    template <class E>
-    void Material::setUniformInternal(std::string name, E value){
-        MaterialData data{value};
-        setUniformData(name, std::move(data));
-    }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "kick/material/shader.h"
 #include "kick/material/material.h"
+#include "kick/scene/instance_buffer.h"
 #include "kick/core/Project.h"
 #include "kick/core/engine.h"
 #include "kick/core/time.h"
@@ -26,6 +27,7 @@
 #include "kick/scene/transform.h"
 #include "kick/scene/light.h"
 #include "kick/core/debug.h"
+#include "kick/scene/engine_uniform_blocks.h"
 using namespace std;
 
 namespace kick {
@@ -158,6 +160,7 @@ break;
         swap(outputAttributeName, o.outputAttributeName);
         swap(mShaderAttributes, o.mShaderAttributes);
         swap(shaderUniforms, o.shaderUniforms);
+        swap(mEngineUniforms, o.mEngineUniforms);
         swap(mBlendDFactorAlpha, o.mBlendDFactorAlpha);
         swap(mBlendDFactorRGB, o.mBlendDFactorRGB);
         swap(mBlendSFactorAlpha, o.mBlendSFactorAlpha);
@@ -167,6 +170,16 @@ break;
         swap(mPolygonOffsetEnabled, o.mPolygonOffsetEnabled);
         swap(mPolygonOffsetFactorAndUnit, o.mPolygonOffsetFactorAndUnit);
         swap(mZTest, o.mZTest);
+        mUniformsMaterial = nullptr;
+        o.mUniformsMaterial = nullptr;
+        swap(mInstancedShader, o.mInstancedShader);
+        swap(mInstancedShaderFailed, o.mInstancedShaderFailed);
+        if (mInstancedShader){
+            mInstancedShader->mInstancedBase = this;
+        }
+        if (o.mInstancedShader){
+            o.mInstancedShader->mInstancedBase = &o;
+        }
         return *this;
     }
     
@@ -185,7 +198,7 @@ break;
     
     Shader::~Shader(){
         if (mShaderProgram != 0){
-            glDeleteProgram(mShaderProgram);
+            GLState::deleteProgram(mShaderProgram);
         }
     }
     
@@ -215,6 +228,8 @@ break;
                               &att.type,
                               buffer.data());
             att.name = buffer.data();
+            // the index of the active attribute is not the attribute location (matrix attributes use several)
+            att.index = (GLuint)glGetAttribLocation(programid, buffer.data());
             att.semantic = to_semantic(att.name);
             if (att.semantic == VertexAttributeSemantic::Unknown){
                 logWarning(string{"Invalid vertex attribute in shader source: "}+att.name);
@@ -280,6 +295,14 @@ break;
                                &uni.type,
                                buffer.data());
             uni.name = buffer.data();
+            uni.semantic = toUniformSemantic(uni.name);
+#ifndef GL_ES_VERSION_2_0
+            GLint blockIndex = -1;
+            glGetActiveUniformsiv(programid, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+            if (blockIndex != -1){
+                continue; // uniform block member (see EngineUniformBlocks)
+            }
+#endif
             int index = glGetUniformLocation(programid, buffer.data());
             if (index>=0){
                 uni.index = index;
@@ -292,7 +315,7 @@ break;
         return move(res);
     }
     
-    string Shader::getPrecompiledSource(string source, ShaderType type) {
+    string Shader::getPrecompiledSource(string source, ShaderType type, bool instanced) {
         if (source.find("#version") != 0){
 #ifdef GL_ES_VERSION_2_0
             string prefix = "#version 100\n";// context.getGLSLPrefix() // todo - get prefix from context
@@ -331,6 +354,9 @@ break;
             }
         }
 
+        // engine uniforms shared by all draws are moved to uniform blocks (if supported)
+        string uniformBlocks = EngineUniformBlocks::replaceDeclarations(source, Engine::config().maxNumerOfLights);
+
 #ifdef GL_ES_VERSION_2_0
         translateToGLSLES(source, type);
         if (type == ShaderType::FragmentShader){
@@ -347,6 +373,8 @@ break;
                 precisionSpecifier+
         "#define SHADOWS " + (Engine::config().shadows?"true":"false") + "\n" +
         "#define LIGHTS " + std::to_string((int) Engine::config().maxNumerOfLights) + "\n" +
+                (instanced ? "#define KICK_INSTANCED\n" : "") +
+                uniformBlocks +
         "#line " + std::to_string(2) + "\n" +
                 source;
 
@@ -364,7 +392,7 @@ break;
             auto shaderType = element.first;
             string & source = element.second;
             if (source.length()>0){
-                string precompiledSource = getPrecompiledSource(source, shaderType);
+                string precompiledSource = getPrecompiledSource(source, shaderType, mInstancedBase != nullptr);
                 
                 shaderObjects.push_back(compileShader(precompiledSource, shaderType));
                 // remove element from vector
@@ -382,13 +410,28 @@ break;
             return false;
         }
         // shaderObjects deleted when goes out of scope (which is ok as long as program is not deleted)
-        glUseProgram(mShaderProgram);
+        GLState::useProgram(mShaderProgram);
+        // a new program has no uniform values
+        mUniformsMaterial = nullptr;
 
         mShaderAttributes = getActiveShaderAttributes(mShaderProgram);
+        EngineUniformBlocks::bindBlocks(mShaderProgram);
         shaderUniforms = getActiveShaderUniforms(mShaderProgram);
+        mEngineUniforms.clear();
+        for (auto & uniform : shaderUniforms){
+            if (uniform.semantic != UniformSemantic::None){
+                mEngineUniforms.push_back(uniform);
+            }
+        }
 
         updateDefaultShaderLocation();
 
+        // the instanced variant follows the source of the shader
+        mInstancedShaderFailed = false;
+        if (mInstancedShader){
+            updateInstancedShader();
+        }
+
         shaderChanged.notifyListeners({this, ShaderEventType::shader });
 
         // clean up
@@ -422,41 +465,72 @@ break;
     
     void updateFaceCulling(FaceCullingType faceCulling){
         if (faceCulling == FaceCullingType::None){
-            glDisable(GL_CULL_FACE);
+            GLState::setEnabled(GL_CULL_FACE, false);
         } else {
-            glEnable(GL_CULL_FACE);
-            glCullFace(static_cast<GLuint>(faceCulling));
+            GLState::setEnabled(GL_CULL_FACE, true);
+            GLState::cullFace(static_cast<GLuint>(faceCulling));
         }
     }
     
     void updateDepthProperties(ZTestType zTest, bool depthWrite){
-        if (zTest == ZTestType::Never){
-            glDisable(GL_DEPTH_TEST);
-        } else {
-            glEnable(GL_DEPTH_TEST);
-        }
-        glDepthFunc(static_cast<GLuint>(zTest));
-        glDepthMask(depthWrite ? GL_TRUE : GL_FALSE);
+        GLState::setEnabled(GL_DEPTH_TEST, zTest != ZTestType::Never);
+        GLState::depthFunc(static_cast<GLuint>(zTest));
+        GLState::depthMask(depthWrite);
     }
     
     void updateBlending(bool blend, BlendType blendDFactorAlpha,BlendType blendDFactorRGB, BlendType blendSFactorAlpha, BlendType blendSFactorRGB){
         if (blend){
-            glEnable(GL_BLEND);
+            GLState::setEnabled(GL_BLEND, true);
             GLenum sfactorRGB = static_cast<GLenum>(blendSFactorRGB);
             GLenum dfactorRGB = static_cast<GLenum>(blendDFactorRGB);
             GLenum sfactorAlpha = static_cast<GLenum>(blendSFactorAlpha);
             GLenum dfactorAlpha = static_cast<GLenum>(blendDFactorAlpha);;
-            glBlendFuncSeparate(sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha);
+            GLState::blendFuncSeparate(sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha);
         } else {
-            glDisable(GL_BLEND);
+            GLState::setEnabled(GL_BLEND, false);
         }
     }
     
     void Shader::bind(){
-        glUseProgram(mShaderProgram);
-        updateFaceCulling(mFaceCulling);
-        updateDepthProperties(mZTest, mDepthBufferWrite);
-        updateBlending(mBlend, mBlendDFactorAlpha, mBlendDFactorRGB, mBlendSFactorAlpha, mBlendSFactorRGB);
+        GLState::useProgram(mShaderProgram);
+        // instanced variants use the render state of the shader they were created from
+        const Shader& state = mInstancedBase ? *mInstancedBase : *this;
+        updateFaceCulling(state.mFaceCulling);
+        updateDepthProperties(state.mZTest, state.mDepthBufferWrite);
+        updateBlending(state.mBlend, state.mBlendDFactorAlpha, state.mBlendDFactorRGB, state.mBlendSFactorAlpha, state.mBlendSFactorRGB);
+    }
+
+    Shader* Shader::instancedShader(){
+        if (!mInstancedShader && !mInstancedShaderFailed && mInstancedBase == nullptr){
+            mInstancedShaderFailed = true;
+            bool hasInstancedPath = false;
+            for (auto & element : shaderSources){
+                hasInstancedPath |= element.second.find("KICK_INSTANCED") != string::npos;
+            }
+            if (hasInstancedPath && InstanceBuffer::supported()){
+                mInstancedShader.reset(new Shader());
+                mInstancedShader->mInstancedBase = this;
+                if (updateInstancedShader()){
+                    mInstancedShaderFailed = false;
+                    // let materials resolve the uniform locations of the variant
+                    shaderChanged.notifyListeners({this, ShaderEventType::shader });
+                }
+            }
+        }
+        return mInstancedShader.get();
+    }
+
+    bool Shader::updateInstancedShader(){
+        mInstancedShader->shaderSources = shaderSources;
+        mInstancedShader->outputAttributeName = outputAttributeName;
+        bool applied = mInstancedShader->apply();
+        if (!applied || mInstancedShader->getShaderAttribute(VertexAttributeSemantic::InstanceModel) == nullptr){
+            logWarning("Cannot create instanced variant of shader");
+            mInstancedShader.reset();
+            mInstancedShaderFailed = true;
+            return false;
+        }
+        return true;
     }
     
     ShaderObj Shader::compileShader(std::string source, ShaderType type){
@@ -589,66 +663,101 @@ break;
     ZTestType Shader::zTest() { return mZTest; }
 
     void Shader::bind_uniforms(Material *material, EngineUniforms *engineUniforms, Transform* transform){
-        material->bind();
+        material->bind(mInstancedBase != nullptr);
         SceneLights * sceneLights = engineUniforms->sceneLights;
-        for (auto& uniform : shaderUniforms){
-            if (uniform.name == UniformNames::modelMatrix){
-                auto globalMatrix = transform->globalMatrix();
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(globalMatrix));
-            } else if (uniform.name == UniformNames::mv){
-                auto modelView = engineUniforms->viewMatrix * transform->globalMatrix();
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(modelView));
-            } else if (uniform.name == UniformNames::norm) {
-                auto modelView = engineUniforms->viewMatrix * transform->globalMatrix();
-                auto normal = glm::inverseTranspose(glm::mat3(modelView));
-                glUniformMatrix3fv(uniform.index, 1, GL_FALSE, glm::value_ptr(normal));
-            } else if (uniform.name == UniformNames::v) {
-                auto viewMatrix = engineUniforms->viewMatrix;
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-            } else if (uniform.name == UniformNames::proj){
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(engineUniforms->projectionMatrix));
-            } else if (uniform.name == UniformNames::worldCamPos){
-                auto cameraPos = engineUniforms->currentCameraTransform->position();
-                glUniform3fv(uniform.index, 1, glm::value_ptr(cameraPos));
-            } else if (uniform.name == UniformNames::world2object){
-                auto world2object = transform->globalTRSInverse();
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(world2object));
-            } else if (uniform.name == UniformNames::mvProj){
-                auto mvProj = engineUniforms->viewProjectionMatrix * transform->globalMatrix();
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(mvProj));
-            } else if (uniform.name == UniformNames::gameObjectUID){
-                int32_t uid = transform->gameObject()->uniqueId();
-                glm::vec4 packedInt = uint32ToVec4(uid);
-                glUniform4fv(uniform.index, 1, glm::value_ptr(packedInt ));
-            } else if (uniform.name == UniformNames::shadowMapTexture) {
-                //throw invalid_argument("shadowMapTexture not yet implemented"); // todo
-                cout <<"shadowMapTexture not yet implemented\n"; // todo
-                logWarning("\"shadowMapTexture not yet implemented");
-            } else if (uniform.name == UniformNames::lightMat){
-                auto lightMatrix = engineUniforms->lightMatrix * transform->globalMatrix();
-                glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(lightMatrix));
-            } else if (uniform.name == UniformNames::ambient){
-                glm::vec3 ambientLight = sceneLights->ambientLight ? sceneLights->ambientLight->colorIntensity() : glm::vec3{0};
-                glUniform3fv(uniform.index, 1, glm::value_ptr(ambientLight));
-            } else if (uniform.name == UniformNames::pointLight){
-                glUniformMatrix3fv(uniform.index, KICK_MAX_POINT_LIGHTS, GL_FALSE, glm::value_ptr(sceneLights->pointLightData[0]));
-            } else if (uniform.name == UniformNames::directionalLight){
-                glUniformMatrix3fv(uniform.index, 1, GL_FALSE, glm::value_ptr(sceneLights->directionalLightData));
-            } else if (uniform.name == UniformNames::directionalLightWorld){
-                glUniform3fv(uniform.index, 1, glm::value_ptr(sceneLights->directionalLightWorld));
-            } else if (uniform.name == UniformNames::time){
-                float time = Time::total();
-                glUniform1f(uniform.index, time);
-            } else if (uniform.name == UniformNames::viewport){
-                glm::vec2 viewportSize = (glm::vec2)engineUniforms->viewportDimension.getValue();
-                glUniform2fv(uniform.index, 1, glm::value_ptr(viewportSize));
+        // the derived matrices are computed at most once per draw
+        glm::mat4 model;
+        glm::mat4 modelView;
+        bool modelComputed = false;
+        bool modelViewComputed = false;
+        auto getModel = [&]() -> const glm::mat4& {
+            if (!modelComputed){
+                model = transform->globalMatrix();
+                modelComputed = true;
+            }
+            return model;
+        };
+        auto getModelView = [&]() -> const glm::mat4& {
+            if (!modelViewComputed){
+                modelView = engineUniforms->viewMatrix * getModel();
+                modelViewComputed = true;
+            }
+            return modelView;
+        };
+        for (auto& uniform : mEngineUniforms){
+            switch (uniform.semantic){
+                case UniformSemantic::ModelMatrix:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(getModel()));
+                    break;
+                case UniformSemantic::ModelView:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(getModelView()));
+                    break;
+                case UniformSemantic::Normal: {
+                    auto normal = glm::inverseTranspose(glm::mat3(getModelView()));
+                    glUniformMatrix3fv(uniform.index, 1, GL_FALSE, glm::value_ptr(normal));
+                    break;
+                }
+                case UniformSemantic::View:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(engineUniforms->viewMatrix));
+                    break;
+                case UniformSemantic::Projection:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(engineUniforms->projectionMatrix));
+                    break;
+                case UniformSemantic::WorldCameraPosition: {
+                    auto cameraPos = engineUniforms->currentCameraTransform->position();
+                    glUniform3fv(uniform.index, 1, glm::value_ptr(cameraPos));
+                    break;
+                }
+                case UniformSemantic::World2Object:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(transform->globalTRSInverse()));
+                    break;
+                case UniformSemantic::ModelViewProjection: {
+                    auto mvProj = engineUniforms->viewProjectionMatrix * getModel();
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(mvProj));
+                    break;
+                }
+                case UniformSemantic::GameObjectUID: {
+                    int32_t uid = transform->gameObject()->uniqueId();
+                    glm::vec4 packedInt = uint32ToVec4(uid);
+                    glUniform4fv(uniform.index, 1, glm::value_ptr(packedInt));
+                    break;
+                }
+                case UniformSemantic::ShadowMapTexture:
+                    logWarning("shadowMapTexture not yet implemented"); // todo
+                    break;
+                case UniformSemantic::LightMatrix: {
+                    auto lightMatrix = engineUniforms->lightMatrix * getModel();
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(lightMatrix));
+                    break;
+                }
+                case UniformSemantic::Ambient: {
+                    glm::vec3 ambientLight = sceneLights->ambientLight ? sceneLights->ambientLight->colorIntensity() : glm::vec3{0};
+                    glUniform3fv(uniform.index, 1, glm::value_ptr(ambientLight));
+                    break;
+                }
+                case UniformSemantic::PointLight:
+                    glUniformMatrix3fv(uniform.index, KICK_MAX_POINT_LIGHTS, GL_FALSE, glm::value_ptr(sceneLights->pointLightData[0]));
+                    break;
+                case UniformSemantic::DirectionalLight:
+                    glUniformMatrix3fv(uniform.index, 1, GL_FALSE, glm::value_ptr(sceneLights->directionalLightData));
+                    break;
+                case UniformSemantic::DirectionalLightWorld:
+                    glUniform3fv(uniform.index, 1, glm::value_ptr(sceneLights->directionalLightWorld));
+                    break;
+                case UniformSemantic::Time:
+                    glUniform1f(uniform.index, engineUniforms->time);
+                    break;
+                case UniformSemantic::WorldLightMatrix:
+                    glUniformMatrix4fv(uniform.index, 1, GL_FALSE, glm::value_ptr(engineUniforms->lightMatrix));
+                    break;
+                case UniformSemantic::Viewport: {
+                    glm::vec2 viewportSize = (glm::vec2)engineUniforms->viewportDimension.getValue();
+                    glUniform2fv(uniform.index, 1, glm::value_ptr(viewportSize));
+                    break;
+                }
+                case UniformSemantic::None:
+                    break;
             }
-
-            // debug output
-            //else {
-            //    continue;
-            //}
-            //cout << to_string(uniform)<<"\n";
         }
     }
 
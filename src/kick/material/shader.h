@@ -11,6 +11,7 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -82,7 +83,11 @@ namespace kick {
         void setDefaultUniform(std::string name, std::shared_ptr<TextureCube> value);
 
         bool tryGetDefaultUniform(std::string name, MaterialData& value);
-        static std::string getPrecompiledSource(std::string source, ShaderType type);
+        static std::string getPrecompiledSource(std::string source, ShaderType type, bool instanced = false);
+        /// Returns the variant of the shader used for hardware instanced draws (see InstanceBuffer), or nullptr if
+        /// instancing is unsupported or the shader source has no KICK_INSTANCED code path. The variant is compiled on
+        /// first use and is rendered using the render state (blending, depth test, etc) of this shader.
+        Shader* instancedShader();
 
         int getRenderOrder() const;
         void setRenderOrder(int renderOrder);
@@ -94,6 +99,7 @@ namespace kick {
         void updateShaderLocation(std::string name, MaterialData& value);
         void setDefaultUniformData(std::string name, MaterialData&& value);
         void updateDefaultShaderLocation();
+        bool updateInstancedShader();
         /// throws ShaderBuildException if unsuccessfull
         bool linkProgram();
         /// throws ShaderBuildException if unsuccessfull
@@ -103,6 +109,8 @@ namespace kick {
         std::string outputAttributeName = "fragColor";
         std::vector<AttributeDescriptor> mShaderAttributes;
         std::vector<UniformDescriptor> shaderUniforms;
+        // the engine uniforms used by the shader (set in bind_uniforms)
+        std::vector<UniformDescriptor> mEngineUniforms;
         bool mBlend{false};
         BlendType mBlendDFactorAlpha{BlendType::OneMinusSrcAlpha};
         BlendType mBlendDFactorRGB{BlendType::OneMinusSrcAlpha};
@@ -117,6 +125,14 @@ namespace kick {
         int mDenderOrder = 1000;
         std::map<std::string, std::shared_ptr<Texture2D>> texture2DRef;
         std::map<std::string, std::shared_ptr<TextureCube>> textureCubeRef;
+        // the material whose parameters were last uploaded to the program
+        Material* mUniformsMaterial = nullptr;
+        // variant compiled with KICK_INSTANCED defined
+        std::unique_ptr<Shader> mInstancedShader;
+        // the shader the instanced variant was created from (nullptr if not an instanced variant)
+        Shader* mInstancedBase = nullptr;
+        bool mInstancedShaderFailed = false;
+        friend class Material;
     };
 
     template <class E>
@@ -23,4 +23,40 @@ namespace kick {
         res += " }";
         return res;
     }
-}
\ No newline at end of file
+
+    UniformSemantic toUniformSemantic(const std::string &name) {
+        // same order as UniformNames::list
+        static const UniformSemantic semantics[] = {
+                UniformSemantic::ModelMatrix,
+                UniformSemantic::ModelView,
+                UniformSemantic::Normal,
+                UniformSemantic::View,
+                UniformSemantic::WorldCameraPosition,
+                UniformSemantic::World2Object,
+                UniformSemantic::ModelViewProjection,
+                UniformSemantic::Projection,
+                UniformSemantic::GameObjectUID,
+                UniformSemantic::ShadowMapTexture,
+                UniformSemantic::LightMatrix,
+                UniformSemantic::Ambient,
+                UniformSemantic::PointLight,
+                UniformSemantic::DirectionalLight,
+                UniformSemantic::DirectionalLightWorld,
+                UniformSemantic::Time,
+                UniformSemantic::Viewport,
+                UniformSemantic::WorldLightMatrix
+        };
+        static_assert(sizeof(semantics) / sizeof(semantics[0]) == sizeof(UniformNames::list) / sizeof(UniformNames::list[0]),
+                "UniformNames::list and semantics must match");
+        // engine uniforms start with an underscore
+        if (name.empty() || name[0] != '_'){
+            return UniformSemantic::None;
+        }
+        for (size_t i = 0; i < sizeof(semantics) / sizeof(semantics[0]); i++){
+            if (name == UniformNames::list[i]){
+                return semantics[i];
+            }
+        }
+        return UniformSemantic::None;
+    }
+}
@@ -114,11 +114,35 @@ namespace kick {
         VertexAttributeSemantic semantic;
     };
 
+    // engine uniforms set by Shader::bind_uniforms (see UniformNames)
+    enum class UniformSemantic {
+        None,   // not an engine uniform
+        ModelMatrix,
+        ModelView,
+        Normal,
+        View,
+        WorldCameraPosition,
+        World2Object,
+        ModelViewProjection,
+        Projection,
+        GameObjectUID,
+        ShadowMapTexture,
+        LightMatrix,
+        Ambient,
+        PointLight,
+        DirectionalLight,
+        DirectionalLightWorld,
+        Time,
+        Viewport,
+        WorldLightMatrix    // light matrix without the model matrix (used by instanced shaders)
+    };
+
     struct UniformDescriptor  {
         GLuint index;
         GLint size;
         GLenum type;
         std::string name;
+        UniformSemantic semantic;
     };
 
     namespace UniformNames {
@@ -139,6 +163,7 @@ namespace kick {
         const std::string directionalLightWorld{"_dLightWorldDir"};
         const std::string time{"_time"};
         const std::string viewport{"_viewport"};
+        const std::string lightMatWorld{"_lightMatWorld"};
 
         const static std::string list[] = {
                 modelMatrix,
@@ -157,13 +182,17 @@ namespace kick {
                 directionalLight,
                 directionalLightWorld,
                 time,
-                viewport
+                viewport,
+                lightMatWorld
         };
     };
 
     std::string to_string(AttributeDescriptor attDesc);
 
     std::string to_string(UniformDescriptor uniformDesc);
+
+    // returns UniformSemantic::None if the name is not an engine uniform
+    UniformSemantic toUniformSemantic(const std::string &name);
 }
 
 
@@ -0,0 +1,44 @@
+//
+//  uniform_name.cpp
+//  KickCPP
+//
+
+#include "kick/material/uniform_name.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace kick {
+    namespace {
+        struct NameTable {
+            mutex lock;
+            unordered_map<string, int> ids;
+            // deque does not move elements, so the name pointers stay valid
+            deque<string> names;
+        };
+
+        NameTable& nameTable(){
+            static NameTable table;
+            return table;
+        }
+    }
+
+    UniformName::UniformName(const std::string& name) {
+        NameTable& table = nameTable();
+        lock_guard<mutex> guard(table.lock);
+        auto pos = table.ids.find(name);
+        if (pos == table.ids.end()){
+            pos = table.ids.emplace(name, (int)table.names.size()).first;
+            table.names.push_back(name);
+        }
+        mId = pos->second;
+        mName = &table.names[mId];
+    }
+
+    UniformName::UniformName(const char* name)
+    :UniformName(std::string{name})
+    {
+    }
+}
@@ -0,0 +1,36 @@
+//
+//  uniform_name.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace kick {
+
+    /// Interned uniform name. Names are interned once (when the UniformName is created), after which comparing and
+    /// hashing is a single int operation. Frequently used names should be kept in a static UniformName, e.g.:
+    /// static const UniformName mainColor{"mainColor"};
+    class UniformName {
+    public:
+        UniformName(const std::string& name);
+        UniformName(const char* name);
+        const std::string& name() const { return *mName; }
+        // unique id of the name (equal names share the same id)
+        int id() const { return mId; }
+        bool operator==(const UniformName& other) const { return mId == other.mId; }
+        bool operator!=(const UniformName& other) const { return mId != other.mId; }
+    private:
+        int mId;
+        const std::string* mName;
+    };
+}
+
+namespace std {
+    template <>
+    struct hash<kick::UniformName> {
+        size_t operator()(const kick::UniformName& name) const { return (size_t)name.id(); }
+    };
+}
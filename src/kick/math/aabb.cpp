@@ -18,22 +18,15 @@ namespace kick {
     }
     
     AABB AABB::transform(mat4 mat)  const{
-        glm::vec4 point(1,1,1,1);
-        AABB res;
-        float aabbIn[6] = {min.x, min.y, min.z, max.x, max.y, max.z};
-        
-        for (int i = 0; i < 2; i++) {
-            for (int j = 0; j < 2; j++) {
-                for (int k = 0; k < 2; k++) {
-                    point.x = aabbIn[i * 3];
-                    point.y = aabbIn[j * 3 + 1];
-                    point.z = aabbIn[k * 3 + 2];
-
-                    res.addPoint(vec3(mat * point));
-                }
-            }
+        if (*this == mUninitialized){
+            return AABB{};
         }
-        return res;
+        // center and extent form (Arvo): the extent is transformed by the absolute values of the upper 3x3 matrix
+        vec3 c = center();
+        vec3 e = diagonal() * 0.5f;
+        vec3 newCenter = vec3(mat[0]) * c.x + vec3(mat[1]) * c.y + vec3(mat[2]) * c.z + vec3(mat[3]);
+        vec3 newExtent = abs(vec3(mat[0])) * e.x + abs(vec3(mat[1])) * e.y + abs(vec3(mat[2])) * e.z;
+        return AABB{newCenter - newExtent, newCenter + newExtent};
     }
     
     void AABB::addPoint(glm::vec3 point){
@@ -17,7 +17,7 @@ namespace kick {
         AABB(glm::vec3 min = glm::vec3(FLT_MAX), glm::vec3 max = glm::vec3(-FLT_MAX));
         
         /**
-         * Transforms the eight points of the Axis-Aligned Bounding Box into a new AABB
+         * Returns the Axis-Aligned Bounding Box of the eight transformed points (computed from the center and extent)
          */
         AABB transform(glm::mat4 mat) const;
         
@@ -3,6 +3,7 @@
 //
 
 #include "bounds3.h"
+#include "kick/math/simd.h"
 
 namespace kick{
 
@@ -32,32 +33,44 @@ Bounds3 Bounds3::lerp(float f, Bounds3 b) {
 
 }
 
-bool Bounds3::contains(glm::vec3 point) {
+bool Bounds3::contains(glm::vec3 point) const {
     return min.x <= point.x && min.y <= point.y && min.z <= point.z &&
             max.x >= point.x && max.y >= point.y && max.z >= point.z
             ;
 }
 
-    glm::vec3 Bounds3::dimension() { return max-min; }
+bool Bounds3::contains(const Bounds3& b) const {
+    return min.x <= b.min.x && min.y <= b.min.y && min.z <= b.min.z &&
+            max.x >= b.max.x && max.y >= b.max.y && max.z >= b.max.z;
+}
+
+bool Bounds3::intersect(const Bounds3& b) const {
+    return min.x <= b.max.x && min.y <= b.max.y && min.z <= b.max.z &&
+            max.x >= b.min.x && max.y >= b.min.y && max.z >= b.min.z;
+}
+
+    bool Bounds3::uninitialized() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
 
-    glm::vec3 Bounds3::center() { return (max+min)*0.5f; }
+    glm::vec3 Bounds3::dimension() const { return max-min; }
 
-    glm::vec3 Bounds3::diagonal() { return (max-min); }
+    glm::vec3 Bounds3::center() const { return (max+min)*0.5f; }
 
-	Bounds3 Bounds3::transform(glm::mat4 trans){
-		glm::vec3 values[2] = {min, max};
-		Bounds3 res;
-		for (int x = 0; x < 2; x++){
-			for (int y = 0; y < 2; y++){
-				for (int z = 0; z < 2; z++){
-					glm::vec4 t = trans * glm::vec4(values[x].x, values[y].y, values[z].z, 1.0);
-					res.expand((glm::vec3)t);
-				}
-			}
-		}
-		return res;
+    glm::vec3 Bounds3::diagonal() const { return (max-min); }
 
-	}
+    Bounds3 Bounds3::transform(const glm::mat4 &trans) const {
+        if (uninitialized()){
+            return Bounds3{};
+        }
+        // Arvo: the extent of the transformed box is the extent multiplied by the absolute values of the rotation
+        // and scale part of the matrix
+        glm::vec3 c = center();
+        glm::vec3 e = (max - min) * 0.5f;
+        glm::vec3 newCenter = glm::vec3(trans[0]) * c.x + glm::vec3(trans[1]) * c.y + glm::vec3(trans[2]) * c.z + glm::vec3(trans[3]);
+        glm::vec3 newExtent = glm::abs(glm::vec3(trans[0])) * e.x + glm::abs(glm::vec3(trans[1])) * e.y + glm::abs(glm::vec3(trans[2])) * e.z;
+        return Bounds3{newCenter - newExtent, newCenter + newExtent};
+    }
 
     std::vector<glm::vec3> Bounds3::toLines() {
         std::vector<glm::vec3> res;
@@ -94,4 +107,78 @@ bool Bounds3::contains(glm::vec3 point) {
         res.push_back(glm::vec3(max.x,min.y,min.z));
         return res;
     }
-}
\ No newline at end of file
+
+    void Bounds3Array::resize(size_t size) {
+        for (auto v : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}){
+            v->resize(size);
+        }
+    }
+
+    void Bounds3Array::set(size_t index, const Bounds3 &bounds) {
+        glm::vec3 c{0};
+        glm::vec3 e{-1};
+        if (!bounds.uninitialized()){
+            c = bounds.center();
+            e = bounds.diagonal() * 0.5f;
+        }
+        centerX[index] = c.x;
+        centerY[index] = c.y;
+        centerZ[index] = c.z;
+        extentX[index] = e.x;
+        extentY[index] = e.y;
+        extentZ[index] = e.z;
+    }
+
+    Bounds3 Bounds3Array::get(size_t index) const {
+        glm::vec3 c{centerX[index], centerY[index], centerZ[index]};
+        glm::vec3 e{extentX[index], extentY[index], extentZ[index]};
+        return Bounds3{c - e, c + e};
+    }
+
+    void transformBounds(const Bounds3Array &bounds, const glm::mat4 *matrices, Bounds3Array &result) {
+        size_t count = bounds.size();
+        result.resize(count);
+        size_t i = 0;
+#ifdef KICK_SIMD
+        using namespace simd;
+        for (; i + 4 <= count; i += 4){
+            // m[c][r] is row r of column c of the four matrices
+            float4 m[4][4];
+            for (int c = 0; c < 4; c++){
+                m[c][0] = load4(&matrices[i][c][0]);
+                m[c][1] = load4(&matrices[i + 1][c][0]);
+                m[c][2] = load4(&matrices[i + 2][c][0]);
+                m[c][3] = load4(&matrices[i + 3][c][0]);
+                transpose4(m[c][0], m[c][1], m[c][2], m[c][3]);
+            }
+            float4 cx = load4(&bounds.centerX[i]);
+            float4 cy = load4(&bounds.centerY[i]);
+            float4 cz = load4(&bounds.centerZ[i]);
+            float4 ex = load4(&bounds.extentX[i]);
+            float4 ey = load4(&bounds.extentY[i]);
+            float4 ez = load4(&bounds.extentZ[i]);
+            float *centers[3] = {&result.centerX[i], &result.centerY[i], &result.centerZ[i]};
+            float *extents[3] = {&result.extentX[i], &result.extentY[i], &result.extentZ[i]};
+            for (int r = 0; r < 3; r++){
+                float4 center = add4(add4(add4(mul4(m[0][r], cx), mul4(m[1][r], cy)), mul4(m[2][r], cz)), m[3][r]);
+                float4 extent = add4(add4(mul4(abs4(m[0][r]), ex), mul4(abs4(m[1][r]), ey)), mul4(abs4(m[2][r]), ez));
+                store4(centers[r], center);
+                store4(extents[r], extent);
+            }
+        }
+#endif
+        for (; i < count; i++){
+            const glm::mat4 &m = matrices[i];
+            glm::vec3 c{bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]};
+            glm::vec3 e{bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]};
+            glm::vec3 newCenter = glm::vec3(m[0]) * c.x + glm::vec3(m[1]) * c.y + glm::vec3(m[2]) * c.z + glm::vec3(m[3]);
+            glm::vec3 newExtent = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y + glm::abs(glm::vec3(m[2])) * e.z;
+            result.centerX[i] = newCenter.x;
+            result.centerY[i] = newCenter.y;
+            result.centerZ[i] = newCenter.z;
+            result.extentX[i] = newExtent.x;
+            result.extentY[i] = newExtent.y;
+            result.extentZ[i] = newExtent.z;
+        }
+    }
+}
@@ -17,13 +17,14 @@ namespace kick {
         glm::vec3 min = glm::vec3{ std::numeric_limits<float>::max() };
         glm::vec3 max = glm::vec3{ std::numeric_limits<float>::lowest() };
 
-        glm::vec3 dimension();
+        glm::vec3 dimension() const;
 
-        glm::vec3 center();
+        glm::vec3 center() const;
 
-        glm::vec3 diagonal();
+        glm::vec3 diagonal() const;
 
-		Bounds3 transform(glm::mat4 trans);
+        // Bounds of the eight transformed corners (computed from the transformed center and extent)
+        Bounds3 transform(const glm::mat4 &trans) const;
 
         Bounds3();
 
@@ -37,11 +38,37 @@ namespace kick {
 
         Bounds3 lerp(float f, Bounds3 b);
 
-        bool contains(glm::vec3 point);
+        bool contains(glm::vec3 point) const;
+
+        // Returns true if the bounds b is fully inside
+        bool contains(const Bounds3& b) const;
+
+        bool intersect(const Bounds3& b) const;
+
+        // Returns true if no points has been added (min > max)
+        bool uninitialized() const;
 
         std::vector<glm::vec3> toLines();
     };
 
+    /// Structure of arrays of boxes stored as center and half extent, used by the batch culling kernels.
+    /// Uninitialized bounds are stored with a negative extent (which remains negative when transformed).
+    struct Bounds3Array {
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        size_t size() const { return centerX.size(); }
+
+        void resize(size_t size);
+
+        void set(size_t index, const Bounds3 &bounds);
+
+        Bounds3 get(size_t index) const;
+    };
+
+    /// Transforms bounds[i] by matrices[i] into result (resized to the size of bounds)
+    void transformBounds(const Bounds3Array &bounds, const glm::mat4 *matrices, Bounds3Array &result);
+
     inline std::ostream& operator<<(std::ostream& out, const Bounds3 & f){
         return out << "bounds{"<<glm::to_string(f.min) << ',' << glm::to_string(f.max) <<"}";
     }
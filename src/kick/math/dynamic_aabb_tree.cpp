@@ -0,0 +1,511 @@
+//
+//  dynamic_aabb_tree.cpp
+//  KickCPP
+//
+
+#include "kick/math/dynamic_aabb_tree.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace glm;
+
+namespace kick {
+
+    DynamicAABBTree::DynamicAABBTree(float margin)
+    :mMargin(margin){
+    }
+
+    int DynamicAABBTree::allocateNode() {
+        if (mFreeList == nullNode){
+            // grow the node pool and link the new nodes into the free list
+            int oldCapacity = (int)mNodes.size();
+            int newCapacity = std::max(16, oldCapacity * 2);
+            mNodes.resize(newCapacity);
+            for (int i = oldCapacity; i < newCapacity - 1; i++){
+                mNodes[i].next = i + 1;
+                mNodes[i].height = -1;
+            }
+            mNodes[newCapacity - 1].next = nullNode;
+            mNodes[newCapacity - 1].height = -1;
+            mFreeList = oldCapacity;
+        }
+        int nodeId = mFreeList;
+        Node &node = mNodes[nodeId];
+        mFreeList = node.next;
+        node.parent = nullNode;
+        node.child1 = nullNode;
+        node.child2 = nullNode;
+        node.height = 0;
+        node.userData = nullptr;
+        mNodeCount++;
+        return nodeId;
+    }
+
+    void DynamicAABBTree::freeNode(int nodeId) {
+        assert(0 <= nodeId && nodeId < (int)mNodes.size());
+        assert(0 < mNodeCount);
+        mNodes[nodeId].next = mFreeList;
+        mNodes[nodeId].height = -1;
+        mNodes[nodeId].userData = nullptr;
+        mFreeList = nodeId;
+        mNodeCount--;
+    }
+
+    int DynamicAABBTree::createProxy(const Bounds3 &bounds, void *userData) {
+        int proxyId = allocateNode();
+        Node &node = mNodes[proxyId];
+        node.bounds = Bounds3{bounds.min - vec3{mMargin}, bounds.max + vec3{mMargin}};
+        node.userData = userData;
+        node.height = 0;
+        insertLeaf(proxyId);
+        return proxyId;
+    }
+
+    void DynamicAABBTree::destroyProxy(int proxyId) {
+        assert(0 <= proxyId && proxyId < (int)mNodes.size());
+        assert(mNodes[proxyId].isLeaf());
+        removeLeaf(proxyId);
+        freeNode(proxyId);
+    }
+
+    bool DynamicAABBTree::moveProxy(int proxyId, const Bounds3 &bounds, glm::vec3 displacement) {
+        assert(0 <= proxyId && proxyId < (int)mNodes.size());
+        assert(mNodes[proxyId].isLeaf());
+
+        Bounds3 fatBounds{bounds.min - vec3{mMargin}, bounds.max + vec3{mMargin}};
+        // predict movement
+        const float displacementMultiplier = 2.0f;
+        vec3 d = displacementMultiplier * displacement;
+        for (int i = 0; i < 3; i++){
+            if (d[i] < 0){
+                fatBounds.min[i] += d[i];
+            } else {
+                fatBounds.max[i] += d[i];
+            }
+        }
+
+        const Bounds3 &treeBounds = mNodes[proxyId].bounds;
+        if (treeBounds.contains(bounds)){
+            // The tree bounds still contains the object, but it might be too large.
+            // Perhaps the object was moving fast but has since gone to sleep.
+            // The huge bounds is larger than the new fat bounds.
+            Bounds3 hugeBounds{fatBounds.min - vec3{4 * mMargin}, fatBounds.max + vec3{4 * mMargin}};
+            if (hugeBounds.contains(treeBounds)){
+                // The tree bounds contains the object bounds and the tree bounds is not too large.
+                // No tree update needed.
+                return false;
+            }
+        }
+        removeLeaf(proxyId);
+        mNodes[proxyId].bounds = fatBounds;
+        insertLeaf(proxyId);
+        return true;
+    }
+
+    void *DynamicAABBTree::userData(int proxyId) const {
+        assert(0 <= proxyId && proxyId < (int)mNodes.size());
+        return mNodes[proxyId].userData;
+    }
+
+    const Bounds3 &DynamicAABBTree::fatBounds(int proxyId) const {
+        assert(0 <= proxyId && proxyId < (int)mNodes.size());
+        return mNodes[proxyId].bounds;
+    }
+
+    void DynamicAABBTree::insertLeaf(int leaf) {
+        if (mRoot == nullNode){
+            mRoot = leaf;
+            mNodes[mRoot].parent = nullNode;
+            return;
+        }
+
+        // Find the best sibling for this node
+        Bounds3 leafBounds = mNodes[leaf].bounds;
+        int index = mRoot;
+        while (!mNodes[index].isLeaf()){
+            int child1 = mNodes[index].child1;
+            int child2 = mNodes[index].child2;
+
+            float nodeArea = area(mNodes[index].bounds);
+
+            Bounds3 combinedBounds = combine(mNodes[index].bounds, leafBounds);
+            float combinedArea = area(combinedBounds);
+
+            // Cost of creating a new parent for this node and the new leaf
+            float cost = 2.0f * combinedArea;
+
+            // Minimum cost of pushing the leaf further down the tree
+            float inheritanceCost = 2.0f * (combinedArea - nodeArea);
+
+            // Cost of descending into child1
+            float cost1 = area(combine(leafBounds, mNodes[child1].bounds)) + inheritanceCost;
+            if (!mNodes[child1].isLeaf()){
+                cost1 -= area(mNodes[child1].bounds);
+            }
+
+            // Cost of descending into child2
+            float cost2 = area(combine(leafBounds, mNodes[child2].bounds)) + inheritanceCost;
+            if (!mNodes[child2].isLeaf()){
+                cost2 -= area(mNodes[child2].bounds);
+            }
+
+            // Descend according to the minimum cost.
+            if (cost < cost1 && cost < cost2){
+                break;
+            }
+
+            index = cost1 < cost2 ? child1 : child2;
+        }
+
+        int sibling = index;
+
+        // Create a new parent.
+        int oldParent = mNodes[sibling].parent;
+        int newParent = allocateNode();
+        mNodes[newParent].parent = oldParent;
+        mNodes[newParent].userData = nullptr;
+        mNodes[newParent].bounds = combine(leafBounds, mNodes[sibling].bounds);
+        mNodes[newParent].height = mNodes[sibling].height + 1;
+
+        if (oldParent != nullNode){
+            // The sibling was not the root.
+            if (mNodes[oldParent].child1 == sibling){
+                mNodes[oldParent].child1 = newParent;
+            } else {
+                mNodes[oldParent].child2 = newParent;
+            }
+        } else {
+            // The sibling was the root.
+            mRoot = newParent;
+        }
+        mNodes[newParent].child1 = sibling;
+        mNodes[newParent].child2 = leaf;
+        mNodes[sibling].parent = newParent;
+        mNodes[leaf].parent = newParent;
+
+        // Walk back up the tree fixing heights and bounds
+        index = mNodes[leaf].parent;
+        while (index != nullNode){
+            index = balance(index);
+
+            int child1 = mNodes[index].child1;
+            int child2 = mNodes[index].child2;
+
+            assert(child1 != nullNode);
+            assert(child2 != nullNode);
+
+            mNodes[index].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+            mNodes[index].bounds = combine(mNodes[child1].bounds, mNodes[child2].bounds);
+
+            index = mNodes[index].parent;
+        }
+    }
+
+    void DynamicAABBTree::removeLeaf(int leaf) {
+        if (leaf == mRoot){
+            mRoot = nullNode;
+            return;
+        }
+
+        int parent = mNodes[leaf].parent;
+        int grandParent = mNodes[parent].parent;
+        int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+        if (grandParent != nullNode){
+            // Destroy parent and connect sibling to grandParent.
+            if (mNodes[grandParent].child1 == parent){
+                mNodes[grandParent].child1 = sibling;
+            } else {
+                mNodes[grandParent].child2 = sibling;
+            }
+            mNodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            // Adjust ancestor bounds.
+            int index = grandParent;
+            while (index != nullNode){
+                index = balance(index);
+
+                int child1 = mNodes[index].child1;
+                int child2 = mNodes[index].child2;
+
+                mNodes[index].bounds = combine(mNodes[child1].bounds, mNodes[child2].bounds);
+                mNodes[index].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+
+                index = mNodes[index].parent;
+            }
+        } else {
+            mRoot = sibling;
+            mNodes[sibling].parent = nullNode;
+            freeNode(parent);
+        }
+    }
+
+    // Perform a left or right rotation if node A is imbalanced.
+    // Returns the new root index.
+    int DynamicAABBTree::balance(int iA) {
+        assert(iA != nullNode);
+
+        Node &A = mNodes[iA];
+        if (A.isLeaf() || A.height < 2){
+            return iA;
+        }
+
+        int iB = A.child1;
+        int iC = A.child2;
+        Node &B = mNodes[iB];
+        Node &C = mNodes[iC];
+
+        int balance = C.height - B.height;
+
+        // Rotate C up
+        if (balance > 1){
+            int iF = C.child1;
+            int iG = C.child2;
+            Node &F = mNodes[iF];
+            Node &G = mNodes[iG];
+
+            // Swap A and C
+            C.child1 = iA;
+            C.parent = A.parent;
+            A.parent = iC;
+
+            // A's old parent should point to C
+            if (C.parent != nullNode){
+                if (mNodes[C.parent].child1 == iA){
+                    mNodes[C.parent].child1 = iC;
+                } else {
+                    assert(mNodes[C.parent].child2 == iA);
+                    mNodes[C.parent].child2 = iC;
+                }
+            } else {
+                mRoot = iC;
+            }
+
+            // Rotate
+            if (F.height > G.height){
+                C.child2 = iF;
+                A.child2 = iG;
+                G.parent = iA;
+                A.bounds = combine(B.bounds, G.bounds);
+                C.bounds = combine(A.bounds, F.bounds);
+
+                A.height = 1 + std::max(B.height, G.height);
+                C.height = 1 + std::max(A.height, F.height);
+            } else {
+                C.child2 = iG;
+                A.child2 = iF;
+                F.parent = iA;
+                A.bounds = combine(B.bounds, F.bounds);
+                C.bounds = combine(A.bounds, G.bounds);
+
+                A.height = 1 + std::max(B.height, F.height);
+                C.height = 1 + std::max(A.height, G.height);
+            }
+            return iC;
+        }
+
+        // Rotate B up
+        if (balance < -1){
+            int iD = B.child1;
+            int iE = B.child2;
+            Node &D = mNodes[iD];
+            Node &E = mNodes[iE];
+
+            // Swap A and B
+            B.child1 = iA;
+            B.parent = A.parent;
+            A.parent = iB;
+
+            // A's old parent should point to B
+            if (B.parent != nullNode){
+                if (mNodes[B.parent].child1 == iA){
+                    mNodes[B.parent].child1 = iB;
+                } else {
+                    assert(mNodes[B.parent].child2 == iA);
+                    mNodes[B.parent].child2 = iB;
+                }
+            } else {
+                mRoot = iB;
+            }
+
+            // Rotate
+            if (D.height > E.height){
+                B.child2 = iD;
+                A.child1 = iE;
+                E.parent = iA;
+                A.bounds = combine(C.bounds, E.bounds);
+                B.bounds = combine(A.bounds, D.bounds);
+
+                A.height = 1 + std::max(C.height, E.height);
+                B.height = 1 + std::max(A.height, D.height);
+            } else {
+                B.child2 = iE;
+                A.child1 = iD;
+                D.parent = iA;
+                A.bounds = combine(C.bounds, D.bounds);
+                B.bounds = combine(A.bounds, E.bounds);
+
+                A.height = 1 + std::max(C.height, D.height);
+                B.height = 1 + std::max(A.height, E.height);
+            }
+            return iB;
+        }
+        return iA;
+    }
+
+    void DynamicAABBTree::clear() {
+        mNodes.clear();
+        mRoot = nullNode;
+        mNodeCount = 0;
+        mFreeList = nullNode;
+    }
+
+    int DynamicAABBTree::height() const {
+        if (mRoot == nullNode){
+            return 0;
+        }
+        return mNodes[mRoot].height;
+    }
+
+    int DynamicAABBTree::proxyCount() const {
+        // a tree with n leafs has n-1 internal nodes
+        return mRoot == nullNode ? 0 : (mNodeCount + 1) / 2;
+    }
+
+    int DynamicAABBTree::nodeCapacity() const {
+        return (int)mNodes.size();
+    }
+
+    float DynamicAABBTree::areaRatio() const {
+        if (mRoot == nullNode){
+            return 0;
+        }
+        float rootArea = area(mNodes[mRoot].bounds);
+        float totalArea = 0;
+        for (auto & node : mNodes){
+            if (node.height < 0){
+                continue; // free node
+            }
+            totalArea += area(node.bounds);
+        }
+        return totalArea / rootArea;
+    }
+
+    int DynamicAABBTree::maxBalance() const {
+        int res = 0;
+        for (auto & node : mNodes){
+            if (node.height <= 1){
+                continue; // free node or leaf parent
+            }
+            res = std::max(res, std::abs(mNodes[node.child2].height - mNodes[node.child1].height));
+        }
+        return res;
+    }
+
+    int DynamicAABBTree::computeHeight(int nodeId) const {
+        const Node &node = mNodes[nodeId];
+        if (node.isLeaf()){
+            return 0;
+        }
+        return 1 + std::max(computeHeight(node.child1), computeHeight(node.child2));
+    }
+
+    bool DynamicAABBTree::validateStructure(int index) const {
+        if (index == nullNode){
+            return true;
+        }
+        if (index == mRoot && mNodes[index].parent != nullNode){
+            return false;
+        }
+        const Node &node = mNodes[index];
+        int child1 = node.child1;
+        int child2 = node.child2;
+        if (node.isLeaf()){
+            return child2 == nullNode && node.height == 0;
+        }
+        if (child1 < 0 || child1 >= (int)mNodes.size() || child2 < 0 || child2 >= (int)mNodes.size()){
+            return false;
+        }
+        if (mNodes[child1].parent != index || mNodes[child2].parent != index){
+            return false;
+        }
+        return validateStructure(child1) && validateStructure(child2);
+    }
+
+    bool DynamicAABBTree::validateMetrics(int index) const {
+        if (index == nullNode){
+            return true;
+        }
+        const Node &node = mNodes[index];
+        if (node.isLeaf()){
+            return true;
+        }
+        int child1 = node.child1;
+        int child2 = node.child2;
+        int height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+        if (node.height != height){
+            return false;
+        }
+        Bounds3 bounds = combine(mNodes[child1].bounds, mNodes[child2].bounds);
+        if (bounds.min != node.bounds.min || bounds.max != node.bounds.max){
+            return false;
+        }
+        return validateMetrics(child1) && validateMetrics(child2);
+    }
+
+    bool DynamicAABBTree::validate() const {
+        if (!validateStructure(mRoot) || !validateMetrics(mRoot)){
+            return false;
+        }
+        int freeCount = 0;
+        int freeIndex = mFreeList;
+        while (freeIndex != nullNode){
+            if (freeIndex < 0 || freeIndex >= (int)mNodes.size()){
+                return false;
+            }
+            freeIndex = mNodes[freeIndex].next;
+            freeCount++;
+        }
+        if (height() != (mRoot == nullNode ? 0 : computeHeight(mRoot))){
+            return false;
+        }
+        return mNodeCount + freeCount == (int)mNodes.size();
+    }
+
+    Bounds3 DynamicAABBTree::combine(const Bounds3 &a, const Bounds3 &b) {
+        return Bounds3{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+    }
+
+    float DynamicAABBTree::area(const Bounds3 &b) {
+        vec3 d = b.max - b.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool DynamicAABBTree::intersectRay(const Bounds3 &b, glm::vec3 origin, glm::vec3 invDirection, float maxDistance, float &distance) {
+        float tNear = 0;
+        float tFar = maxDistance;
+        for (int i = 0; i < 3; i++){
+            if (std::isinf(invDirection[i])){
+                // ray is parallel to the slab
+                if (origin[i] < b.min[i] || origin[i] > b.max[i]){
+                    return false;
+                }
+                continue;
+            }
+            float t1 = (b.min[i] - origin[i]) * invDirection[i];
+            float t2 = (b.max[i] - origin[i]) * invDirection[i];
+            if (t1 > t2){
+                std::swap(t1, t2);
+            }
+            tNear = std::max(tNear, t1);
+            tFar = std::min(tFar, t2);
+            if (tNear > tFar){
+                return false;
+            }
+        }
+        distance = tNear;
+        return true;
+    }
+}
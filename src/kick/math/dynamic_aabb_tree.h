@@ -0,0 +1,226 @@
+//
+//  dynamic_aabb_tree.h
+//  KickCPP
+//
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include "kick/math/bounds3.h"
+#include "kick/math/frustum.h"
+#include "kick/math/ray.h"
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+namespace kick {
+
+    /// Dynamic AABB tree (bounding volume hierarchy) for broad phase spatial queries.
+    /// Each proxy is stored in a leaf node using a fat AABB (the bounds enlarged by a margin), which allows the
+    /// proxy to move a bit without the tree being updated. Internal nodes are kept balanced using tree rotations.
+    /// The implementation is based on b2DynamicTree from Box2D by Erin Catto (http://box2d.org)
+    class DynamicAABBTree {
+    public:
+        static const int nullNode = -1;
+
+        DynamicAABBTree(float margin = 0.1f);
+
+        /// Create a proxy in the tree. Returns the proxy id
+        int createProxy(const Bounds3 &bounds, void *userData);
+
+        void destroyProxy(int proxyId);
+
+        /// Move a proxy. If the new bounds is inside the current fat AABB then the tree is not updated.
+        /// The displacement is used for predicting the movement (enlarging the fat AABB in the direction of the movement)
+        /// Returns true if the proxy was reinserted
+        bool moveProxy(int proxyId, const Bounds3 &bounds, glm::vec3 displacement = glm::vec3{0});
+
+        void *userData(int proxyId) const;
+
+        const Bounds3 &fatBounds(int proxyId) const;
+
+        /// Query the proxies overlapping the bounds. The callback (bool(int proxyId)) returns false to terminate the query
+        template <typename F>
+        void query(const Bounds3 &bounds, F callback) const;
+
+        /// Query the proxies inside the frustum. The callback (bool(int proxyId, FrustumIntersection intersection,
+        /// uint32_t planeMask)) returns false to terminate the query. planeMask contains the planes the fat bounds of
+        /// the proxy intersects. Subtrees fully inside the frustum are reported without being tested, and children
+        /// are only tested against the planes their parent intersects.
+        /// If lastPlanes is not null it stores the plane which rejected each node (indexed by node id) between
+        /// queries, which is tested first in the next query. Use a cache for each view for temporal coherence.
+        template <typename F>
+        void queryFrustum(const Frustum &frustum, F callback, std::vector<uint8_t> *lastPlanes = nullptr) const;
+
+        /// Query the proxies hit by the ray (within maxDistance). The callback (bool(int proxyId, float distance))
+        /// returns false to terminate the query. The proxies are not sorted by distance.
+        template <typename F>
+        void rayCast(const Ray &ray, F callback, float maxDistance = std::numeric_limits<float>::max()) const;
+
+        void clear();
+
+        /// Height of the tree (0 if empty or a single leaf)
+        int height() const;
+
+        int proxyCount() const;
+
+        /// Ratio of the sum of the node areas to the root area (a measure of the tree quality)
+        float areaRatio() const;
+
+        /// Maximum height difference between the children of a node (the rotations keep the tree roughly, but
+        /// not strictly, balanced)
+        int maxBalance() const;
+
+        /// Validates the tree structure. Returns false if the tree is invalid.
+        bool validate() const;
+
+        /// The node capacity. Node ids are always less than the capacity
+        int nodeCapacity() const;
+    private:
+        struct Node {
+            bool isLeaf() const { return child1 == nullNode; }
+
+            Bounds3 bounds;
+            void *userData = nullptr;
+            union {
+                int parent;
+                int next;
+            };
+            int child1 = nullNode;
+            int child2 = nullNode;
+            // leaf = 0, free node = -1
+            int height = -1;
+        };
+
+        // Stack used for tree traversal. Uses a fixed size array and only allocates for very deep trees.
+        template <typename T, int N>
+        class GrowableStack {
+        public:
+            void push(const T &element){
+                if (mCount < N){
+                    mStack[mCount] = element;
+                } else {
+                    mHeapStack.push_back(element);
+                }
+                mCount++;
+            }
+            T pop(){
+                mCount--;
+                if (mCount < N){
+                    return mStack[mCount];
+                }
+                T res = mHeapStack.back();
+                mHeapStack.pop_back();
+                return res;
+            }
+            bool empty() const { return mCount == 0; }
+        private:
+            T mStack[N];
+            std::vector<T> mHeapStack;
+            int mCount = 0;
+        };
+
+        int allocateNode();
+        void freeNode(int nodeId);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int index);
+        int computeHeight(int nodeId) const;
+        bool validateStructure(int index) const;
+        bool validateMetrics(int index) const;
+        static Bounds3 combine(const Bounds3 &a, const Bounds3 &b);
+        static float area(const Bounds3 &b);
+        static bool intersectRay(const Bounds3 &b, glm::vec3 origin, glm::vec3 invDirection, float maxDistance, float &distance);
+
+        int mRoot = nullNode;
+        std::vector<Node> mNodes;
+        int mNodeCount = 0;
+        int mFreeList = nullNode;
+        float mMargin;
+    };
+
+    template <typename F>
+    inline void DynamicAABBTree::query(const Bounds3 &bounds, F callback) const {
+        GrowableStack<int, 256> stack;
+        stack.push(mRoot);
+        while (!stack.empty()){
+            int nodeId = stack.pop();
+            if (nodeId == nullNode){
+                continue;
+            }
+            const Node &node = mNodes[nodeId];
+            if (node.bounds.intersect(bounds)){
+                if (node.isLeaf()){
+                    if (!callback(nodeId)){
+                        return;
+                    }
+                } else {
+                    stack.push(node.child1);
+                    stack.push(node.child2);
+                }
+            }
+        }
+    }
+
+    template <typename F>
+    inline void DynamicAABBTree::queryFrustum(const Frustum &frustum, F callback, std::vector<uint8_t> *lastPlanes) const {
+        struct Entry {
+            int nodeId;
+            uint32_t planeMask;
+        };
+        if (lastPlanes && lastPlanes->size() < mNodes.size()){
+            lastPlanes->resize(mNodes.size(), 0);
+        }
+        GrowableStack<Entry, 256> stack;
+        stack.push({mRoot, Frustum::allPlanes});
+        while (!stack.empty()){
+            Entry entry = stack.pop();
+            if (entry.nodeId == nullNode){
+                continue;
+            }
+            const Node &node = mNodes[entry.nodeId];
+            uint8_t lastPlane = lastPlanes ? (*lastPlanes)[entry.nodeId] : 0;
+            FrustumIntersection intersection = frustum.intersectAabb(node.bounds, entry.planeMask, lastPlane);
+            if (intersection == FrustumIntersection::Outside){
+                if (lastPlanes){
+                    (*lastPlanes)[entry.nodeId] = lastPlane;
+                }
+                continue;
+            }
+            if (node.isLeaf()){
+                if (!callback(entry.nodeId, intersection, entry.planeMask)){
+                    return;
+                }
+            } else {
+                stack.push({node.child1, entry.planeMask});
+                stack.push({node.child2, entry.planeMask});
+            }
+        }
+    }
+
+    template <typename F>
+    inline void DynamicAABBTree::rayCast(const Ray &ray, F callback, float maxDistance) const {
+        glm::vec3 invDirection = 1.0f / ray.direction();
+        GrowableStack<int, 256> stack;
+        stack.push(mRoot);
+        while (!stack.empty()){
+            int nodeId = stack.pop();
+            if (nodeId == nullNode){
+                continue;
+            }
+            const Node &node = mNodes[nodeId];
+            float distance;
+            if (!intersectRay(node.bounds, ray.origin(), invDirection, maxDistance, distance)){
+                continue;
+            }
+            if (node.isLeaf()){
+                if (!callback(nodeId, distance)){
+                    return;
+                }
+            } else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+}
@@ -7,12 +7,14 @@
 //
 
 #include "kick/math/frustum.h"
+#include "kick/math/simd.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 
 using namespace glm;
 
 namespace kick {
-    FrustumIntersection Frustum::intersectAabb(Bounds3 aabb){
+    FrustumIntersection Frustum::intersectAabb(const Bounds3 &aabb) const {
         vec3 center = aabb.center();
         vec3 halfVector = aabb.diagonal() * 0.5f;
         FrustumIntersection result = FrustumIntersection::Inside;
@@ -33,6 +35,99 @@ namespace kick {
         return result;
     }
 
+    FrustumIntersection Frustum::intersectAabb(const Bounds3 &aabb, uint32_t &planeMask, uint8_t &lastPlane) const {
+        if (planeMask == 0){
+            return FrustumIntersection::Inside;
+        }
+        vec3 center = aabb.center();
+        vec3 halfVector = aabb.diagonal() * 0.5f;
+        int first = lastPlane < 6 ? lastPlane : 0;
+        for (int j = 0; j < 6; j++) {
+            int i = j == 0 ? first : (j == first ? 0 : j);
+            uint32_t planeBit = 1u << i;
+            if ((planeMask & planeBit) == 0){
+                continue;
+            }
+            vec3 planeNormal = vec3(planes[i]);
+            float e = dot(halfVector, abs(planeNormal));
+            float s = dot(center, planeNormal) + planes[i].w;
+
+            if (s - e > 0) { // inside
+                planeMask &= ~planeBit;
+            } else if (s + e < 0) { // outside
+                lastPlane = (uint8_t)i;
+                return FrustumIntersection::Outside;
+            }
+        }
+        return planeMask == 0 ? FrustumIntersection::Inside : FrustumIntersection::Intersecting;
+    }
+
+    void Frustum::intersectAabbs(const Bounds3Array &bounds, uint32_t *visibleMask, uint32_t *insideMask) const {
+        size_t count = bounds.size();
+        size_t words = (count + 31) / 32;
+        std::fill(visibleMask, visibleMask + words, 0u);
+        if (insideMask){
+            std::fill(insideMask, insideMask + words, 0u);
+        }
+        size_t i = 0;
+#ifdef KICK_SIMD
+        using namespace simd;
+        float4 planeN[6][3], planeAbsN[6][3], planeD[6];
+        for (int p = 0; p < 6; p++){
+            for (int j = 0; j < 3; j++){
+                planeN[p][j] = splat4(planes[p][j]);
+                planeAbsN[p][j] = splat4(std::abs(planes[p][j]));
+            }
+            planeD[p] = splat4(planes[p].w);
+        }
+        const float4 zero = splat4(0);
+        // four boxes at a time (groups never span two mask words)
+        for (; i + 4 <= count; i += 4){
+            float4 cx = load4(&bounds.centerX[i]);
+            float4 cy = load4(&bounds.centerY[i]);
+            float4 cz = load4(&bounds.centerZ[i]);
+            float4 ex = load4(&bounds.extentX[i]);
+            float4 ey = load4(&bounds.extentY[i]);
+            float4 ez = load4(&bounds.extentZ[i]);
+            // uninitialized bounds have a negative extent
+            mask4 outside = less4(ex, zero);
+            mask4 intersecting = maskFalse4();
+            for (int p = 0; p < 6; p++){
+                float4 s = add4(add4(add4(mul4(cx, planeN[p][0]), mul4(cy, planeN[p][1])), mul4(cz, planeN[p][2])), planeD[p]);
+                float4 e = add4(add4(mul4(ex, planeAbsN[p][0]), mul4(ey, planeAbsN[p][1])), mul4(ez, planeAbsN[p][2]));
+                outside = or4(outside, less4(add4(s, e), zero));
+                intersecting = or4(intersecting, lessEqual4(sub4(s, e), zero));
+            }
+            uint32_t outsideBits = moveMask4(outside);
+            uint32_t shift = i & 31;
+            visibleMask[i / 32] |= (~outsideBits & 0xfu) << shift;
+            if (insideMask){
+                insideMask[i / 32] |= (~(outsideBits | moveMask4(intersecting)) & 0xfu) << shift;
+            }
+        }
+#endif
+        for (; i < count; i++){
+            vec3 center{bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]};
+            vec3 halfVector{bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]};
+            bool outside = halfVector.x < 0;
+            bool intersecting = false;
+            for (int p = 0; p < 6; p++){
+                vec3 planeNormal = vec3(planes[p]);
+                float e = dot(halfVector, abs(planeNormal));
+                float s = dot(center, planeNormal) + planes[p].w;
+                outside |= s + e < 0;
+                intersecting |= s - e <= 0;
+            }
+            uint32_t bit = 1u << (i & 31);
+            if (!outside){
+                visibleMask[i / 32] |= bit;
+                if (insideMask && !intersecting){
+                    insideMask[i / 32] |= bit;
+                }
+            }
+        }
+    }
+
     void Frustum::extractPlanes(glm::mat4 viewProjectionMatrix, bool normalizePlaneNormals){
         float* _viewProjectionMatrix = value_ptr(viewProjectionMatrix);
         auto _11 = _viewProjectionMatrix[0], _21 = _viewProjectionMatrix[1], _31 = _viewProjectionMatrix[2], _41 = _viewProjectionMatrix[3],
@@ -10,6 +10,7 @@
 
 #include "glm/glm.hpp"
 #include "kick/math/bounds3.h"
+#include <cstdint>
 
 namespace kick {
     enum class FrustumIntersection {
@@ -26,7 +27,19 @@ namespace kick {
     /// http://www.cs.otago.ac.nz/postgrads/alexis/planeExtraction.pdf
     class Frustum {
     public:
-        FrustumIntersection intersectAabb(Bounds3 bounds);
+        /// Plane mask with a bit set for each of the 6 planes
+        static const uint32_t allPlanes = 0x3f;
+
+        FrustumIntersection intersectAabb(const Bounds3 &bounds) const;
+        /// Tests the bounds against the planes in planeMask, starting with lastPlane (the plane which rejected the
+        /// bounds the last time it was tested). If the bounds is outside, lastPlane is set to the rejecting plane.
+        /// Otherwise the planes the bounds is fully inside are removed from planeMask, so the mask can be used for
+        /// testing bounds contained in the bounds (such as the children in a bounding volume hierarchy).
+        FrustumIntersection intersectAabb(const Bounds3 &bounds, uint32_t &planeMask, uint8_t &lastPlane) const;
+        /// Tests all bounds against the frustum. Bit i of visibleMask is set if bounds i is not outside and bit i of
+        /// insideMask (optional) is set if bounds i is fully inside. Uninitialized bounds are outside. The masks must have room for (size + 31) / 32
+        /// words.
+        void intersectAabbs(const Bounds3Array &bounds, uint32_t *visibleMask, uint32_t *insideMask = nullptr) const;
         void extractPlanes(glm::mat4 viewProjectionMatrix, bool normalizePlaneNormals = false);
     private:
         glm::vec4 planes[6];
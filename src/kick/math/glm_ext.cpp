@@ -8,124 +8,152 @@
 
 #include "kick/math/glm_ext.h"
 
-
+#include "kick/math/simd.h"
 
 using namespace glm;
 
 namespace kick {
+    namespace {
+        using namespace simd;
+
+        // columns of the rotation matrix of a unit quaternion
+        inline void rotationColumns(const glm::quat &q, float r[3][3]){
+            float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+            float xx = q.x * x2, xy = q.x * y2, xz = q.x * z2;
+            float yy = q.y * y2, yz = q.y * z2, zz = q.z * z2;
+            float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+            r[0][0] = 1 - (yy + zz); r[0][1] = xy + wz;       r[0][2] = xz - wy;
+            r[1][0] = xy - wz;       r[1][1] = 1 - (xx + zz); r[1][2] = yz + wx;
+            r[2][0] = xz + wy;       r[2][1] = yz - wx;       r[2][2] = 1 - (xx + yy);
+        }
+
+        inline void TRSScalar(const glm::vec3 &translate, const glm::quat &rotate, const glm::vec3 &scale, glm::mat4 &out){
+            float r[3][3];
+            rotationColumns(rotate, r);
+            for (int c = 0; c < 3; c++){
+                out[c] = vec4(r[c][0] * scale[c], r[c][1] * scale[c], r[c][2] * scale[c], 0);
+            }
+            out[3] = vec4(translate, 1);
+        }
+
+        // (T*R*S)^-1 = S^-1 * R^T * T^-1
+        inline void TRSInverseScalar(const glm::vec3 &translate, const glm::quat &rotate, const glm::vec3 &scale, glm::mat4 &out){
+            float r[3][3];
+            rotationColumns(rotate, r);
+            vec3 invScale = 1.0f / scale;
+            for (int c = 0; c < 3; c++){
+                out[c] = vec4(r[0][c] * invScale.x, r[1][c] * invScale.y, r[2][c] * invScale.z, 0);
+            }
+            out[3] = vec4(-(r[0][0] * translate.x + r[0][1] * translate.y + r[0][2] * translate.z) * invScale.x,
+                          -(r[1][0] * translate.x + r[1][1] * translate.y + r[1][2] * translate.z) * invScale.y,
+                          -(r[2][0] * translate.x + r[2][1] * translate.y + r[2][2] * translate.z) * invScale.z,
+                          1);
+        }
+
+#ifdef KICK_SIMD
+        // Four TRS inputs are transposed into registers with one component of all four inputs (structure of arrays),
+        // the matrices are computed lane-wise and transposed back into columns
+        struct TRSInput4 {
+            float4 tx, ty, tz, sx, sy, sz;
+            float4 r[3][3];
+        };
+
+        inline void loadTRS4(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, TRSInput4 &res){
+            res.tx = set4(translate[0].x, translate[1].x, translate[2].x, translate[3].x);
+            res.ty = set4(translate[0].y, translate[1].y, translate[2].y, translate[3].y);
+            res.tz = set4(translate[0].z, translate[1].z, translate[2].z, translate[3].z);
+            res.sx = set4(scale[0].x, scale[1].x, scale[2].x, scale[3].x);
+            res.sy = set4(scale[0].y, scale[1].y, scale[2].y, scale[3].y);
+            res.sz = set4(scale[0].z, scale[1].z, scale[2].z, scale[3].z);
+            // glm::quat is stored as x, y, z, w
+            float4 x = load4(&rotate[0].x);
+            float4 y = load4(&rotate[1].x);
+            float4 z = load4(&rotate[2].x);
+            float4 w = load4(&rotate[3].x);
+            transpose4(x, y, z, w);
+            float4 one = splat4(1);
+            float4 x2 = add4(x, x), y2 = add4(y, y), z2 = add4(z, z);
+            float4 xx = mul4(x, x2), xy = mul4(x, y2), xz = mul4(x, z2);
+            float4 yy = mul4(y, y2), yz = mul4(y, z2), zz = mul4(z, z2);
+            float4 wx = mul4(w, x2), wy = mul4(w, y2), wz = mul4(w, z2);
+            res.r[0][0] = sub4(one, add4(yy, zz)); res.r[0][1] = add4(xy, wz); res.r[0][2] = sub4(xz, wy);
+            res.r[1][0] = sub4(xy, wz); res.r[1][1] = sub4(one, add4(xx, zz)); res.r[1][2] = add4(yz, wx);
+            res.r[2][0] = add4(xz, wy); res.r[2][1] = sub4(yz, wx); res.r[2][2] = sub4(one, add4(xx, yy));
+        }
+
+        // store column c of four matrices, given as lane-wise rows
+        inline void storeColumn4(glm::mat4 *out, int c, float4 x, float4 y, float4 z, float4 w){
+            transpose4(x, y, z, w);
+            store4(&out[0][c][0], x);
+            store4(&out[1][c][0], y);
+            store4(&out[2][c][0], z);
+            store4(&out[3][c][0], w);
+        }
+
+        inline void TRS4(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out){
+            TRSInput4 in;
+            loadTRS4(translate, rotate, scale, in);
+            float4 zero = splat4(0);
+            float4 s[3] = {in.sx, in.sy, in.sz};
+            for (int c = 0; c < 3; c++){
+                storeColumn4(out, c, mul4(in.r[c][0], s[c]), mul4(in.r[c][1], s[c]), mul4(in.r[c][2], s[c]), zero);
+            }
+            storeColumn4(out, 3, in.tx, in.ty, in.tz, splat4(1));
+        }
+
+        inline void TRSInverse4(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out){
+            TRSInput4 in;
+            loadTRS4(translate, rotate, scale, in);
+            float4 one = splat4(1);
+            float4 invScale[3] = {div4(one, in.sx), div4(one, in.sy), div4(one, in.sz)};
+            float4 zero = splat4(0);
+            for (int c = 0; c < 3; c++){
+                storeColumn4(out, c, mul4(in.r[0][c], invScale[0]), mul4(in.r[1][c], invScale[1]), mul4(in.r[2][c], invScale[2]), zero);
+            }
+            float4 t[3];
+            for (int i = 0; i < 3; i++){
+                float4 dot = add4(add4(mul4(in.r[i][0], in.tx), mul4(in.r[i][1], in.ty)), mul4(in.r[i][2], in.tz));
+                t[i] = mul4(sub4(zero, dot), invScale[i]);
+            }
+            storeColumn4(out, 3, t[0], t[1], t[2], one);
+        }
+#endif
+    }
+
     glm::mat4 TRS(glm::vec3 translate, glm::quat rotateQuat, glm::vec3 scale){
-        return glm::translate(translate) * mat4_cast(rotateQuat) * glm::scale(scale);
-        /*glm::mat4 res;
-        float *out = &(res[0][0]);
-        // Quaternion math
-        float scaleX = scale[0], scaleY = scale[1], scaleZ = scale[2],
-        x = rotateQuat[1], y = rotateQuat[2], z = rotateQuat[3], w = rotateQuat[0],
-        x2 = x + x,
-        y2 = y + y,
-        z2 = z + z,
-        
-        xx = x * x2,
-        xy = x * y2,
-        xz = x * z2,
-        yy = y * y2,
-        yz = y * z2,
-        zz = z * z2,
-        wx = w * x2,
-        wy = w * y2,
-        wz = w * z2;
-        
-        out[0] = (1 - (yy + zz)) * scaleX;
-        out[1] = (xy + wz) * scaleX;
-        out[2] = (xz - wy) * scaleX;
-        out[3] = 0;
-        out[4] = (xy - wz) * scaleY;
-        out[5] = (1 - (xx + zz)) * scaleY;
-        out[6] = (yz + wx) * scaleY;
-        out[7] = 0;
-        out[8] = (xz + wy) * scaleZ;
-        out[9] = (yz - wx) * scaleZ;
-        out[10] = (1 - (xx + yy)) * scaleZ;
-        out[11] = 0;
-        out[12] = translate[0];
-        out[13] = translate[1];
-        out[14] = translate[2];
-        out[15] = 1;
-        
-        return res;       */
+        glm::mat4 res;
+        TRSScalar(translate, rotateQuat, scale, res);
+        return res;
     }
     
     glm::mat4 TRSInverse(glm::vec3 translate, glm::quat rotateQuat, glm::vec3 scale){
-        return inverse(TRS(translate, rotateQuat, scale));
-        /*
-        // Quaternion math
-        float scaleX = scale.x, scaleY = scale.y, scaleZ = scale.z,
-        x = rotateQuat.x, y = rotateQuat.y, z = rotateQuat.z, w = rotateQuat.w,
-        x2 = x + x,
-        y2 = y + y,
-        z2 = z + z,
-        
-        xx = x * x2,
-        xy = x * y2,
-        xz = x * z2,
-        yy = y * y2,
-        yz = y * z2,
-        zz = z * z2,
-        wx = w * x2,
-        wy = w * y2,
-        wz = w * z2,
-        
-        // compute trs
-        a00 = (1 - (yy + zz)) * scaleX,
-        a01 = (xy + wz) * scaleX,
-        a02 = (xz - wy) * scaleX,
-        a10 = (xy - wz) * scaleY,
-        a11 = (1 - (xx + zz)) * scaleY,
-        a12 = (yz + wx) * scaleY,
-        a20 = (xz + wy) * scaleZ,
-        a21 = (yz - wx) * scaleZ,
-        a22 = (1 - (xx + yy)) * scaleZ,
-        a30 = translate[0],
-        a31 = translate[1],
-        a32 = translate[2],
-        a33 = 1,
-        // compute inverse
-        b00 = a00 * a11 - a01 * a10,
-        b01 = a00 * a12 - a02 * a10,
-        b03 = a01 * a12 - a02 * a11,
-        b06 = a20 * a31 - a21 * a30,
-        b07 = a20 * a32 - a22 * a30,
-        b08 = a20 * a33,
-        b09 = a21 * a32 - a22 * a31,
-        b10 = a21 * a33,
-        b11 = a22 * a33,
-        
-        d = (b00 * b11 - b01 * b10 + b03 * b08),
-        invDet;
-        
-        mat4 res;
-        float *out = &(res[0][0]);
-        // Calculate the determinant
-        if (!d) { return res; }
-        invDet = 1 / d;
-        
-        out[0] = (a11 * b11 - a12 * b10) * invDet;
-        out[1] = (-a01 * b11 + a02 * b10) * invDet;
-        out[2] = (a33 * b03) * invDet;
-        out[3] = 0;
-        out[4] = (-a10 * b11 + a12 * b08) * invDet;
-        out[5] = (a00 * b11 - a02 * b08) * invDet;
-        out[6] = (-a33 * b01) * invDet;
-        out[7] = 0;
-        out[8] = (a10 * b10 - a11 * b08) * invDet;
-        out[9] = (-a00 * b10 + a01 * b08) * invDet;
-        out[10] = (a33 * b00) * invDet;
-        out[11] = 0;
-        out[12] = (-a10 * b09 + a11 * b07 - a12 * b06) * invDet;
-        out[13] = (a00 * b09 - a01 * b07 + a02 * b06) * invDet;
-        out[14] = (-a30 * b03 + a31 * b01 - a32 * b00) * invDet;
-        out[15] = (a20 * b03 - a21 * b01 + a22 * b00) * invDet;
-        
-        return res;   */
+        glm::mat4 res;
+        TRSInverseScalar(translate, rotateQuat, scale, res);
+        return res;
+    }
+
+    void TRS(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out, size_t count){
+        size_t i = 0;
+#ifdef KICK_SIMD
+        for (; i + 4 <= count; i += 4){
+            TRS4(translate + i, rotate + i, scale + i, out + i);
+        }
+#endif
+        for (; i < count; i++){
+            TRSScalar(translate[i], rotate[i], scale[i], out[i]);
+        }
+    }
+
+    void TRSInverse(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out, size_t count){
+        size_t i = 0;
+#ifdef KICK_SIMD
+        for (; i + 4 <= count; i += 4){
+            TRSInverse4(translate + i, rotate + i, scale + i, out + i);
+        }
+#endif
+        for (; i < count; i++){
+            TRSInverseScalar(translate[i], rotate[i], scale[i], out[i]);
+        }
     }
 
     glm::quat lookAt(glm::vec3 eyePosition, glm::vec3 lookAtPos, glm::vec3 up){
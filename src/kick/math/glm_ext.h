@@ -10,13 +10,22 @@
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <cstddef>
 
 namespace kick {
 
+    // translate * rotate * scale (closed form). The rotation must be a unit quaternion
     glm::mat4 TRS(glm::vec3 translate, glm::quat rotate, glm::vec3 scale);
 
+    // inverse of TRS(translate, rotate, scale) (closed form). The scale components must be non-zero
     glm::mat4 TRSInverse(glm::vec3 translate, glm::quat rotate, glm::vec3 scale);
 
+    // Batch versions computing out[i] for i in [0;count). Four matrices are computed at a time using SSE or NEON when
+    // available (with a scalar fallback)
+    void TRS(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out, size_t count);
+
+    void TRSInverse(const glm::vec3 *translate, const glm::quat *rotate, const glm::vec3 *scale, glm::mat4 *out, size_t count);
+
     glm::quat lookAt(glm::vec3 eyePosition, glm::vec3 lookAtPos, glm::vec3 up = glm::vec3(0,1,0));
 
 };
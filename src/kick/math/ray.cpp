@@ -7,6 +7,8 @@
 //
 
 #include "kick/math/ray.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace glm;
 
@@ -84,6 +86,34 @@ namespace kick {
         return mOrigin + mDirection * offset;
     }
 
+    bool Ray::intersectAabb(const Bounds3 &bounds, float &distance, float maxDistance) const {
+        // slab test
+        float tNear = 0;
+        float tFar = maxDistance;
+        for (int i = 0; i < 3; i++){
+            if (mDirection[i] == 0){
+                // ray is parallel to the slab
+                if (mOrigin[i] < bounds.min[i] || mOrigin[i] > bounds.max[i]){
+                    return false;
+                }
+                continue;
+            }
+            float invDirection = 1.0f / mDirection[i];
+            float t1 = (bounds.min[i] - mOrigin[i]) * invDirection;
+            float t2 = (bounds.max[i] - mOrigin[i]) * invDirection;
+            if (t1 > t2){
+                std::swap(t1, t2);
+            }
+            tNear = std::max(tNear, t1);
+            tFar = std::min(tFar, t2);
+            if (tNear > tFar){
+                return false;
+            }
+        }
+        distance = tNear;
+        return true;
+    }
+
     bool Ray::intersectTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, glm::vec3 &intersectionPoint, bool clampBackIntersections) const {
         // based on RTR 3ed page 750
         vec3 e1 = v1 - v0;
@@ -9,6 +9,8 @@
 #pragma once
 
 #include "glm/glm.hpp"
+#include "kick/math/bounds3.h"
+#include <limits>
 
 namespace kick {
     class Ray {
@@ -19,6 +21,8 @@ namespace kick {
         bool closestPoints(Ray otherRay, glm::vec3& outPoint1, glm::vec3& outPoint2) const;
         glm::vec3 closestPoint(glm::vec3 point) const;
         bool intersectTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, glm::vec3 &intersectionPoint, bool clampBackIntersections = true) const;
+        // Returns true if the ray hits the bounds within maxDistance. Distance is 0 if the origin is inside the bounds
+        bool intersectAabb(const Bounds3 &bounds, float &distance, float maxDistance = std::numeric_limits<float>::max()) const;
         glm::vec3 const &origin() const;
         void setOrigin(glm::vec3 const &origin);
         glm::vec3 const &direction() const;
@@ -0,0 +1,90 @@
+//
+//  simd.h
+//  KickCPP
+//
+//  Thin wrappers of SSE and NEON intrinsics used by the batch math kernels. KICK_SIMD is defined when a vector
+//  instruction set is available; otherwise the kernels use their scalar fallback.
+//
+
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KICK_SIMD
+#define KICK_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define KICK_SIMD
+#define KICK_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#include <cstdint>
+
+namespace kick {
+    namespace simd {
+#if defined(KICK_SIMD_SSE)
+        typedef __m128 float4;
+        typedef __m128 mask4;
+        inline float4 load4(const float *p){ return _mm_loadu_ps(p); }
+        inline void store4(float *p, float4 v){ _mm_storeu_ps(p, v); }
+        inline float4 set4(float a, float b, float c, float d){ return _mm_setr_ps(a, b, c, d); }
+        inline float4 splat4(float a){ return _mm_set1_ps(a); }
+        inline float4 add4(float4 a, float4 b){ return _mm_add_ps(a, b); }
+        inline float4 sub4(float4 a, float4 b){ return _mm_sub_ps(a, b); }
+        inline float4 mul4(float4 a, float4 b){ return _mm_mul_ps(a, b); }
+        inline float4 div4(float4 a, float4 b){ return _mm_div_ps(a, b); }
+        inline float4 abs4(float4 a){ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        inline float4 min4(float4 a, float4 b){ return _mm_min_ps(a, b); }
+        inline float4 max4(float4 a, float4 b){ return _mm_max_ps(a, b); }
+        inline mask4 less4(float4 a, float4 b){ return _mm_cmplt_ps(a, b); }
+        inline mask4 lessEqual4(float4 a, float4 b){ return _mm_cmple_ps(a, b); }
+        inline mask4 or4(mask4 a, mask4 b){ return _mm_or_ps(a, b); }
+        inline mask4 maskFalse4(){ return _mm_setzero_ps(); }
+        // bit i is set if lane i is true
+        inline uint32_t moveMask4(mask4 m){ return (uint32_t)_mm_movemask_ps(m); }
+        inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d){ _MM_TRANSPOSE4_PS(a, b, c, d); }
+#elif defined(KICK_SIMD_NEON)
+        typedef float32x4_t float4;
+        typedef uint32x4_t mask4;
+        inline float4 load4(const float *p){ return vld1q_f32(p); }
+        inline void store4(float *p, float4 v){ vst1q_f32(p, v); }
+        inline float4 set4(float a, float b, float c, float d){ float v[4] = {a, b, c, d}; return vld1q_f32(v); }
+        inline float4 splat4(float a){ return vdupq_n_f32(a); }
+        inline float4 add4(float4 a, float4 b){ return vaddq_f32(a, b); }
+        inline float4 sub4(float4 a, float4 b){ return vsubq_f32(a, b); }
+        inline float4 mul4(float4 a, float4 b){ return vmulq_f32(a, b); }
+        inline float4 div4(float4 a, float4 b){
+#if defined(__aarch64__)
+            return vdivq_f32(a, b);
+#else
+            // reciprocal estimate refined with two Newton-Raphson steps
+            float4 r = vrecpeq_f32(b);
+            r = vmulq_f32(vrecpsq_f32(b, r), r);
+            r = vmulq_f32(vrecpsq_f32(b, r), r);
+            return vmulq_f32(a, r);
+#endif
+        }
+        inline float4 abs4(float4 a){ return vabsq_f32(a); }
+        inline float4 min4(float4 a, float4 b){ return vminq_f32(a, b); }
+        inline float4 max4(float4 a, float4 b){ return vmaxq_f32(a, b); }
+        inline mask4 less4(float4 a, float4 b){ return vcltq_f32(a, b); }
+        inline mask4 lessEqual4(float4 a, float4 b){ return vcleq_f32(a, b); }
+        inline mask4 or4(mask4 a, mask4 b){ return vorrq_u32(a, b); }
+        inline mask4 maskFalse4(){ return vdupq_n_u32(0); }
+        inline uint32_t moveMask4(mask4 m){
+            static const uint32_t bits[4] = {1, 2, 4, 8};
+            uint32x4_t v = vandq_u32(m, vld1q_u32(bits));
+            uint32x2_t sum = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+            return vget_lane_u32(vpadd_u32(sum, sum), 0);
+        }
+        inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d){
+            float32x4x2_t ab = vtrnq_f32(a, b); // a0 b0 a2 b2, a1 b1 a3 b3
+            float32x4x2_t cd = vtrnq_f32(c, d); // c0 d0 c2 d2, c1 d1 c3 d3
+            a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+            b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+            c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+            d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+        }
+#endif
+    }
+}
@@ -9,12 +9,123 @@
 #include "kick/mesh/mesh.h"
 #include "kick/mesh/mesh_data.h"
 #include "kick/core/debug.h"
+#include "kick/core/render_stats.h"
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <cstring>
+
+#if defined(GL_MAP_PERSISTENT_BIT) && !defined(GL_ES_VERSION_2_0)
+#define KICK_BUFFER_STORAGE 1
+#endif
 
 using namespace std;
 
 namespace kick {
+    namespace {
+        bool bufferStorageSupported(){
+#ifdef KICK_BUFFER_STORAGE
+            // persistently mapped buffers are core in OpenGL 4.4 (or GL_ARB_buffer_storage)
+            static int res = -1;
+            if (res == -1){
+                GLint major = 0;
+                GLint minor = 0;
+                glGetIntegerv(GL_MAJOR_VERSION, &major);
+                glGetIntegerv(GL_MINOR_VERSION, &minor);
+                res = major > 4 || (major == 4 && minor >= 4);
+                GLint extensions = 0;
+                glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+                for (GLint i = 0; i < extensions && !res; i++){
+                    const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+                    res = name && strcmp(name, "GL_ARB_buffer_storage") == 0;
+                }
+            }
+            return res == 1;
+#else
+            return false;
+#endif
+        }
+
+        bool equalFormat(const vector<InterleavedRecord> &a, const vector<InterleavedRecord> &b){
+            if (a.size() != b.size()){
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); i++){
+                if (a[i].semantic != b[i].semantic || a[i].offset != b[i].offset || a[i].size != b[i].size ||
+                        a[i].normalized != b[i].normalized || a[i].type != b[i].type || a[i].stride != b[i].stride){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool elementIndexUintSupported(){
+#ifdef GL_ES_VERSION_2_0
+            // 32 bit indices are only core in OpenGL ES 3.0
+            static int res = -1;
+            if (res == -1){
+                const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+                res = extensions && strstr(extensions, "GL_OES_element_index_uint") != nullptr;
+            }
+            return res == 1;
+#else
+            return true;
+#endif
+        }
+    }
+
+    // Persistently mapped vertex buffer divided into regions. Each update writes the next region, so the GPU can
+    // read the previous regions while the CPU writes. A fence per region prevents overwriting data in use.
+    struct Mesh::StreamRing {
+        static const int regionCount = 3;
+        GLuint buffer = 0;
+        char *data = nullptr;
+        GLsizeiptr stride = 0;
+        GLint vertexCapacity = 0;
+        int region = 0;
+#ifdef KICK_BUFFER_STORAGE
+        GLsync fences[regionCount] = {nullptr, nullptr, nullptr};
+
+        StreamRing(GLsizeiptr stride, GLint vertexCapacity)
+        : stride(stride), vertexCapacity(vertexCapacity)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLsizeiptr size = stride * vertexCapacity * regionCount;
+            glGenBuffers(1, &buffer);
+            GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+            data = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        }
+
+        ~StreamRing(){
+            for (auto fence : fences){
+                if (fence){
+                    glDeleteSync(fence);
+                }
+            }
+            // deleting the buffer also unmaps it
+            GLState::deleteBuffers(1, &buffer);
+        }
+
+        // writes the vertices to the next region and returns the index of its first vertex
+        GLint write(const vector<float> &vertices){
+            // fence the draw calls reading the current region
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            region = (region + 1) % regionCount;
+            if (fences[region]){
+                GLenum res;
+                do {
+                    res = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                } while (res == GL_TIMEOUT_EXPIRED);
+                glDeleteSync(fences[region]);
+                fences[region] = nullptr;
+            }
+            memcpy(data + region * stride * vertexCapacity, vertices.data(), vertices.size() * sizeof(float));
+            return region * vertexCapacity;
+        }
+#endif
+    };
+
     Mesh::Mesh()
     {
         glGenBuffers(1, &mVertexBufferId);
@@ -22,19 +133,9 @@ namespace kick {
     }
     
     Mesh::~Mesh(){
-        if (mVertexArrayObject.size()>0){
-            vector<GLuint> array(mVertexArrayObject.size());
-            for (auto keyValue : mVertexArrayObject){
-                array.push_back(keyValue.second);
-            }
-#ifndef GL_ES_VERSION_2_0
-            if (openglUsingVao()) {
-                glDeleteVertexArrays((GLsizei) array.size(), array.data());
-            }
-#endif
-        }
-        glDeleteBuffers(1, &mVertexBufferId);
-        glDeleteBuffers(1, &mElementBufferId);
+        deleteVertexArrays();
+        GLState::deleteBuffers(1, &mVertexBufferId);
+        GLState::deleteBuffers(1, &mElementBufferId);
     }
     
     void Mesh::bind(Shader * shader){
@@ -48,12 +149,12 @@ namespace kick {
                 GLuint vertexArrayObjectIdx;
 
                 glGenVertexArrays(1, &vertexArrayObjectIdx);
-                glBindVertexArray(vertexArrayObjectIdx);
+                GLState::bindVertexArray(vertexArrayObjectIdx);
                 updateArrayBufferStructure(shader);
                 mVertexArrayObject[shader] = vertexArrayObjectIdx;
             } else {
                 GLuint vertexArrayObject = iter->second;
-                glBindVertexArray(vertexArrayObject);
+                GLState::bindVertexArray(vertexArrayObject);
             }
         } else
 #endif
@@ -61,11 +162,26 @@ namespace kick {
             updateArrayBufferStructure(shader);
         }
         // reassign buffers
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferId);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferId);
     }
     
+    void Mesh::deleteVertexArrays(){
+        if (mVertexArrayObject.size()>0){
+            vector<GLuint> array;
+            for (auto keyValue : mVertexArrayObject){
+                array.push_back(keyValue.second);
+            }
+#ifndef GL_ES_VERSION_2_0
+            if (openglUsingVao()) {
+                GLState::deleteVertexArrays((GLsizei) array.size(), array.data());
+            }
+#endif
+            mVertexArrayObject.clear();
+        }
+    }
+
     void Mesh::updateArrayBufferStructure(Shader *shader){
-        glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferId);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, mStreamRing ? mStreamRing->buffer : mVertexBufferId);
         static int maxAtrrSizes = -1;
         if (maxAtrrSizes == -1){
             glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAtrrSizes);
@@ -92,6 +208,10 @@ namespace kick {
     }
     
     void Mesh::render(unsigned int submeshIndex){
+        if (mSubmeshData.empty() && mMeshData != nullptr){
+            // mesh data that could not be uploaded (see setMeshData)
+            return;
+        }
         if (submeshIndex >= mSubmeshData.size()){
             logWarning("submesh not found");
             return;
@@ -103,10 +223,38 @@ namespace kick {
         const GLvoid * offset = data.dataOffset;
 
         if (count < 0) {
-            glDrawArrays(mode, 0, -count);
+            glDrawArrays(mode, mBaseVertex, -count);
+            RenderStats::drawCall();
         } else if (count > 0) {
-            glDrawElements(mode, count, type, offset);
+#ifndef GL_ES_VERSION_2_0
+            if (mBaseVertex != 0){
+                glDrawElementsBaseVertex(mode, count, type, (GLvoid*)offset, mBaseVertex);
+            } else
+#endif
+            {
+                glDrawElements(mode, count, type, offset);
+            }
+            RenderStats::drawCall();
+        }
+    }
+    
+    void Mesh::renderInstanced(unsigned int submeshIndex, int instanceCount){
+#ifndef GL_ES_VERSION_2_0
+        if (submeshIndex >= mSubmeshData.size()){
+            logWarning("submesh not found");
+            return;
+        }
+        auto data = mSubmeshData[submeshIndex];
+        GLsizei count = data.indexCount;
+
+        if (count < 0) {
+            glDrawArraysInstanced(data.mode, mBaseVertex, -count, instanceCount);
+            RenderStats::drawCall();
+        } else if (count > 0) {
+            glDrawElementsInstancedBaseVertex(data.mode, count, data.type, (GLvoid*)data.dataOffset, instanceCount, mBaseVertex);
+            RenderStats::drawCall();
         }
+#endif
     }
     
     std::string Mesh::name(){
@@ -117,15 +265,54 @@ namespace kick {
         mName = n;
     }
 
-    void Mesh::setMeshData(shared_ptr<MeshData> m){
+    bool Mesh::setMeshData(shared_ptr<MeshData> m){
+        if (m != nullptr && m->indexType() == GL_UNSIGNED_INT && !elementIndexUintSupported()){
+            auto submeshes = m->indicesFormat();
+            bool indexed = any_of(submeshes.begin(), submeshes.end(), [](const SubMeshData &s){
+                return s.indexCount > 0;
+            });
+            if (indexed){
+                logError("32 bit indices not supported (GL_OES_element_index_uint). The mesh is not rendered.");
+                mInterleavedFormat.clear();
+                mSubmeshData.clear();
+                deleteVertexArrays();
+                // force a full upload when the mesh data is assigned again
+                mMeshDataVersion = 0;
+                mMeshData = m;
+                meshDataChanged.notifyListeners(this);
+                return false;
+            }
+        }
         if (m != nullptr){
-            mInterleavedFormat = m->interleavedFormat();
+            auto interleavedFormat = m->interleavedFormat();
+            if (!equalFormat(interleavedFormat, mInterleavedFormat)){
+                // the vertex array objects store the attribute layout
+                deleteVertexArrays();
+            }
+            mInterleavedFormat = move(interleavedFormat);
             mSubmeshData = m->indicesFormat();
-            updateMeshData(m.get());
+            // the dirty state of the mesh data only describes the changes since this mesh uploaded it, if no other
+            // mesh sharing the mesh data has uploaded (and cleared the dirty state) in between
+            bool fullUpdate = m != mMeshData || (mMeshDataVersion != m->cleanVersion() && mMeshDataVersion != m->version());
+            if (mStreamRing && m->meshUsage() != MeshUsage::StreamDraw){
+                mStreamRing.reset();
+                mBaseVertex = 0;
+                deleteVertexArrays();
+                fullUpdate = true;
+            }
+            if (m->meshUsage() == MeshUsage::DynamicDraw || m->meshUsage() == MeshUsage::StreamDraw){
+                updateDynamicMeshData(m.get(), fullUpdate);
+            } else {
+                updateMeshData(m.get());
+            }
+            mMeshDataVersion = m->version();
+            m->clearDirty();
         } else {
             mInterleavedFormat.clear();
         }
         mMeshData = m;
+        meshDataChanged.notifyListeners(this);
+        return true;
     }
     
     void Mesh::updateMeshData(MeshData *mesh_data){
@@ -133,15 +320,101 @@ namespace kick {
 
         if (data.size()){
             GLsizeiptr vertexDataSize =data.size()*sizeof(float);
-            glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferId);
+            GLState::bindBuffer(GL_ARRAY_BUFFER, mVertexBufferId);
             glBufferData(GL_ARRAY_BUFFER, vertexDataSize, data.data(), mesh_data->meshUsageVal());
+            mVertexBufferSize = vertexDataSize;
+        }
+        updateIndices(mesh_data, false);
+    }
+
+    void Mesh::updateDynamicMeshData(MeshData *mesh_data, bool fullUpdate){
+        if (fullUpdate || mesh_data->layoutDirty() || mesh_data->indicesDirty()){
+            updateIndices(mesh_data, true);
+        }
+        size_t vertexCount = mesh_data->position().size();
+        if (vertexCount == 0 || mInterleavedFormat.empty()){
+            return;
+        }
+        GLsizeiptr stride = mInterleavedFormat[0].stride;
+#ifdef KICK_BUFFER_STORAGE
+        if (mesh_data->meshUsage() == MeshUsage::StreamDraw && bufferStorageSupported()){
+            if (!mStreamRing || mStreamRing->stride != stride || mStreamRing->vertexCapacity < (GLint)vertexCount){
+                // leave room for growth, since the storage of the ring cannot be resized
+                mStreamRing.reset(new StreamRing(stride, (GLint)(vertexCount + vertexCount / 2)));
+                deleteVertexArrays();
+            }
+            mBaseVertex = mStreamRing->write(mesh_data->interleavedData());
+            return;
+        }
+#endif
+        bool full = fullUpdate || mesh_data->layoutDirty();
+        size_t begin = full ? 0 : mesh_data->dirtyVertexBegin();
+        size_t end = full ? vertexCount : mesh_data->dirtyVertexEnd();
+        if (begin >= end){
+            return;
+        }
+        GLsizeiptr size = vertexCount * stride;
+        GLState::bindBuffer(GL_ARRAY_BUFFER, mVertexBufferId);
+        if (size > mVertexBufferSize){
+            // leave room for growth, so meshes growing a little on each update are not reallocated every time
+            mVertexBufferSize = size + size / 2;
+            glBufferData(GL_ARRAY_BUFFER, mVertexBufferSize, nullptr, mesh_data->meshUsageVal());
+            begin = 0;
+            end = vertexCount;
+        } else if ((end - begin) * 2 > vertexCount || mesh_data->meshUsage() == MeshUsage::StreamDraw){
+            // orphan the storage, so the driver does not wait for draw calls reading the previous content
+            glBufferData(GL_ARRAY_BUFFER, mVertexBufferSize, nullptr, mesh_data->meshUsageVal());
+            begin = 0;
+            end = vertexCount;
+        }
+        vector<float> data = mesh_data->interleavedData(begin, end - begin);
+        glBufferSubData(GL_ARRAY_BUFFER, begin * stride, data.size() * sizeof(float), data.data());
+    }
+
+    void Mesh::updateIndices(MeshData *mesh_data, bool dynamic){
+        vector<GLuint> indices = mesh_data->indicesConcat();
+        if (indices.empty()){
+            return;
+        }
+        vector<GLushort> shortIndices;
+        const GLvoid *data = indices.data();
+        GLsizeiptr size = indices.size()*sizeof(GLuint);
+        if (mesh_data->indexType() == GL_UNSIGNED_SHORT){
+            shortIndices.assign(indices.begin(), indices.end());
+            data = shortIndices.data();
+            size = shortIndices.size()*sizeof(GLushort);
+        }
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferId);
+        if (!dynamic){
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, mesh_data->meshUsageVal());
+            mElementBufferSize = size;
+        } else if (size > mElementBufferSize){
+            mElementBufferSize = size + size / 2;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mElementBufferSize, nullptr, mesh_data->meshUsageVal());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, data);
+        } else {
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, data);
         }
+    }
 
-        vector<GLushort> indices = mesh_data->indicesConcat();
-        if (indices.size()){
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferId);
-            GLsizeiptr indicesSize = indices.size()*sizeof(GLushort);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices.data(), mesh_data->meshUsageVal());
+    void Mesh::degenerateIndices(unsigned int submeshIndex, GLsizei firstIndex, GLsizei count){
+        if (submeshIndex >= mSubmeshData.size() || count <= 0){
+            return;
+        }
+        auto &data = mSubmeshData[submeshIndex];
+        if (firstIndex < 0 || firstIndex + count > data.indexCount){
+            logWarning("index range outside submesh");
+            return;
+        }
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferId);
+        if (data.type == GL_UNSIGNED_SHORT){
+            vector<GLushort> indices(count, 0);
+            GLintptr offset = (GLintptr)data.dataOffset + firstIndex * sizeof(GLushort);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, count * sizeof(GLushort), indices.data());
+        } else {
+            vector<GLuint> indices(count, 0);
+            GLintptr offset = (GLintptr)data.dataOffset + firstIndex * sizeof(GLuint);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, count * sizeof(GLuint), indices.data());
         }
     }
 
@@ -10,7 +10,9 @@
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include "kick/core/project_asset.h"
+#include "kick/core/event.h"
 #include "kick/math/aabb.h"
 #include "kick/material/shader.h"
 #include "kick/core/kickgl.h"
@@ -21,6 +23,11 @@ namespace kick {
      * Represents Mesh data on the GPU. Whenever mesh data is updated, then MeshData needs to
      * be reassigned (future update would be using observer pattern to make this update 
      * automatically).
+     * Meshes with MeshUsage::DynamicDraw or MeshUsage::StreamDraw reuse their buffers when the mesh data is
+     * reassigned: only the dirty vertex range is uploaded (or the buffer is orphaned when most vertices changed).
+     * Meshes sharing a MeshData upload all vertices when another mesh uploaded the changes first.
+     * StreamDraw meshes are written to a persistently mapped ring of three buffer regions when buffer storage is
+     * supported (OpenGL 4.4 or GL_ARB_buffer_storage).
      */
     class Mesh : public ProjectAsset {
     public:
@@ -28,13 +35,27 @@ namespace kick {
         ~Mesh();
         void bind(Shader * shader);
         void render(unsigned int submeshIndex);
+        // draws instanceCount instances of the submesh (see InstanceBuffer)
+        void renderInstanced(unsigned int submeshIndex, int instanceCount);
         std::string name();
         void setName(std::string n);
-        void setMeshData(std::shared_ptr<MeshData> m);
+        // returns false if the mesh data cannot be drawn (32 bit indices on OpenGL ES 2.0 without
+        // GL_OES_element_index_uint). The error is logged and the mesh is not rendered.
+        bool setMeshData(std::shared_ptr<MeshData> m);
         std::shared_ptr<MeshData> meshData();
+        // Overwrites count indices of the submesh (starting at firstIndex) in the element buffer with index 0, so the
+        // triangles are degenerate and not rasterized. The mesh data is not changed, so the geometry is
+        // restored when the mesh data is assigned again.
+        void degenerateIndices(unsigned int submeshIndex, GLsizei firstIndex, GLsizei count);
+        // notified when mesh data is assigned (the bounds of the mesh may have changed)
+        Event<Mesh*> meshDataChanged;
     private:
+        struct StreamRing;
         void updateArrayBufferStructure(Shader *shader);
         void updateMeshData(MeshData *mesh_data);
+        void updateDynamicMeshData(MeshData *mesh_data, bool fullUpdate);
+        void updateIndices(MeshData *mesh_data, bool dynamic);
+        void deleteVertexArrays();
         std::unordered_map<Shader*, GLuint> mVertexArrayObject;
         std::vector<InterleavedRecord> mInterleavedFormat;
         std::string mName;
@@ -42,5 +63,13 @@ namespace kick {
         std::vector<SubMeshData> mSubmeshData;
         GLuint mVertexBufferId;
         GLuint mElementBufferId;
+        // allocated buffer sizes in bytes
+        GLsizeiptr mVertexBufferSize = 0;
+        GLsizeiptr mElementBufferSize = 0;
+        // offset added to the vertex indices when drawing (the ring region of stream meshes)
+        GLint mBaseVertex = 0;
+        // the version of the mesh data uploaded (see MeshData::version())
+        uint32_t mMeshDataVersion = 0;
+        std::unique_ptr<StreamRing> mStreamRing;
     };
 };
\ No newline at end of file
@@ -56,7 +56,7 @@ namespace kick {
     }
     
     void MeshData::setPosition(const std::vector<glm::vec3> &p) {
-        mPosition = p;
+        setVertexData(mPosition, p);
     }
     
     const std::vector<glm::vec3>& MeshData::position() {
@@ -64,7 +64,7 @@ namespace kick {
     }
     
     void MeshData::setNormal(const std::vector<glm::vec3> &n) {
-        mNormal = n;
+        setVertexData(mNormal, n);
     }
     
     const std::vector<glm::vec3>& MeshData::normal() {
@@ -72,7 +72,7 @@ namespace kick {
     }
     
     void MeshData::setTexCoord0(const std::vector<glm::vec2> &u1) {
-        mTexCoord0 = u1;
+        setVertexData(mTexCoord0, u1);
     }
     
     const std::vector<glm::vec2>& MeshData::texCoord0() {
@@ -80,7 +80,7 @@ namespace kick {
     }
     
     void MeshData::setTexCoord1(const std::vector<glm::vec2> &u2) {
-        mTexCoord1 = u2;
+        setVertexData(mTexCoord1, u2);
     }
     
     const std::vector<glm::vec2>& MeshData::texCoord1() {
@@ -88,7 +88,7 @@ namespace kick {
     }
     
     void MeshData::setTangent(const std::vector<glm::vec3> &t) {
-        mTangent = t;
+        setVertexData(mTangent, t);
     }
     
     const std::vector<glm::vec3>& MeshData::tangent() {
@@ -96,7 +96,7 @@ namespace kick {
     }
     
     void MeshData::setColor(const std::vector<glm::vec4> &c) {
-        mColor = c;
+        setVertexData(mColor, c);
     }
     
     const std::vector<glm::vec4>& MeshData::color(){
@@ -111,8 +111,42 @@ namespace kick {
         return static_cast<unsigned int>(subMeshes.size());
     }
 
-    size_t MeshData::computeInterleavedDataSize(){
-        size_t numberOfElements = static_cast<int>(mPosition.size());
+    template<typename T>
+    void MeshData::setVertexData(std::vector<T> &dest, const std::vector<T> &src){
+        if (dest.size() != src.size()){
+            dest = src;
+            mLayoutDirty = true;
+            mVersion++;
+            return;
+        }
+        // only mark the changed vertices dirty
+        size_t begin = 0;
+        while (begin < src.size() && dest[begin] == src[begin]){
+            begin++;
+        }
+        size_t end = src.size();
+        while (end > begin && dest[end - 1] == src[end - 1]){
+            end--;
+        }
+        std::copy(src.begin() + begin, src.begin() + end, dest.begin() + begin);
+        markVerticesDirty(begin, end);
+    }
+
+    void MeshData::markVerticesDirty(size_t begin, size_t end){
+        if (begin >= end){
+            return;
+        }
+        mVersion++;
+        if (mDirtyVertexBegin == mDirtyVertexEnd){
+            mDirtyVertexBegin = begin;
+            mDirtyVertexEnd = end;
+        } else {
+            mDirtyVertexBegin = std::min(mDirtyVertexBegin, begin);
+            mDirtyVertexEnd = std::max(mDirtyVertexEnd, end);
+        }
+    }
+
+    size_t MeshData::interleavedVertexSize(){
         size_t vertexSize = 3;
         if (mNormal.size() > 0) {
             vertexSize += 3;
@@ -124,25 +158,25 @@ namespace kick {
             vertexSize += 2;
         }
         if (mTangent.size() > 0) {
-            vertexSize += 4;
+            vertexSize += 3;
         }
         if (mColor.size() > 0) {
             vertexSize += 4;
         }
-        return vertexSize * numberOfElements;
+        return vertexSize;
     }
     
     /**
      * Add data to interleaved data and return the new offset (in float elements)
      */
     template<typename T>
-    size_t add_data(const std::vector<T>& data, vector<float>& interleaved, size_t offset, int stride, int elements){
+    size_t add_data(const std::vector<T>& data, vector<float>& interleaved, size_t offset, int stride, size_t first, size_t elements){
         if (data.size() == 0){
             return offset;
         }
         size_t vectorLength = data[0].length();
         size_t index = offset;
-        for (int i=0;i<elements;i++){
+        for (size_t i=first;i<first+elements;i++){
             for (int j=0;j<vectorLength;j++){
                 if (i < data.size()){
                     interleaved[index+j] = data[i][j];
@@ -156,19 +190,21 @@ namespace kick {
     }
     
     vector<float> MeshData::interleavedData(){
-        const size_t floatElements = computeInterleavedDataSize();
-        vector<float> res(floatElements);
-        if (floatElements == 0){
+        return interleavedData(0, mPosition.size());
+    }
+
+    vector<float> MeshData::interleavedData(size_t firstVertex, size_t vertexCount){
+        const int stride = (int)interleavedVertexSize();
+        vector<float> res(stride * vertexCount);
+        if (vertexCount == 0){
             return res;
         }
-        int elements = mPosition.size();
-        const int stride = floatElements / elements;
-        size_t offset = add_data(mPosition, res, 0, stride, elements);
-        offset = add_data(mNormal, res, offset, stride, elements);
-        offset = add_data(mTexCoord0, res, offset, stride, elements);
-        offset = add_data(mTexCoord1, res, offset, stride, elements);
-        offset = add_data(mTangent, res, offset, stride, elements);
-        offset = add_data(mColor, res, offset, stride, elements);
+        size_t offset = add_data(mPosition, res, 0, stride, firstVertex, vertexCount);
+        offset = add_data(mNormal, res, offset, stride, firstVertex, vertexCount);
+        offset = add_data(mTexCoord0, res, offset, stride, firstVertex, vertexCount);
+        offset = add_data(mTexCoord1, res, offset, stride, firstVertex, vertexCount);
+        offset = add_data(mTangent, res, offset, stride, firstVertex, vertexCount);
+        offset = add_data(mColor, res, offset, stride, firstVertex, vertexCount);
         return res;
     }
 
@@ -188,16 +224,27 @@ namespace kick {
         return res;
     }
     
-    vector<GLushort> MeshData::indicesConcat(){
-        vector<GLushort> res;
+    vector<GLuint> MeshData::indicesConcat(){
+        vector<GLuint> res;
         for (auto & v : subMeshes){
             res.insert(res.end(), v.indices.begin(), v.indices.end());
         }
         return res;
     }
     
+    GLenum MeshData::indexType(){
+        // 16 bit indices address vertex 0 to 65535
+        return mPosition.size() <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    size_t MeshData::indexSize(){
+        return indexType() == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    }
+
     vector<SubMeshData> MeshData::indicesFormat(){
         vector<SubMeshData> res;
+        GLenum type = indexType();
+        size_t size = indexSize();
         size_t offset = 0;
         for (auto & v : subMeshes){
             int indexCount =v.indices.size();
@@ -208,24 +255,38 @@ namespace kick {
                 static_cast<GLsizei>(indexCount),
                 BUFFER_OFFSET(offset),
                 static_cast<GLenum>(v.meshType),
-                GL_UNSIGNED_SHORT
+                type
             };
             
             res.push_back(record);
-            offset += sizeof(GLushort) * v.indices.size();
+            offset += size * v.indices.size();
         }
         return res;
     }
     
-    void MeshData::setSubmesh(unsigned int index, const std::vector<GLushort> &indices, MeshType meshType){
+    void MeshData::setSubmesh(unsigned int index, const std::vector<GLuint> &indices, MeshType meshType){
         while (subMeshes.size() <= index){
             subMeshes.push_back({{}, MeshType::Triangles});
+            mIndicesDirty = true;
+            mVersion++;
+        }
+        if (subMeshes[index].indices != indices || subMeshes[index].meshType != meshType){
+            subMeshes[index].indices = indices;
+            subMeshes[index].meshType = meshType;
+            mIndicesDirty = true;
+            mVersion++;
         }
-        subMeshes[index].indices = indices;
-        subMeshes[index].meshType = meshType;
     }
     
-    const vector<GLushort>& MeshData::submeshIndices(unsigned int index) const {
+    void MeshData::setSubmesh(unsigned int index, const std::vector<GLushort> &indices, MeshType meshType){
+        setSubmesh(index, vector<GLuint>(indices.begin(), indices.end()), meshType);
+    }
+
+    void MeshData::setSubmesh(unsigned int index, std::initializer_list<GLuint> indices, MeshType meshType){
+        setSubmesh(index, vector<GLuint>(indices), meshType);
+    }
+
+    const vector<GLuint>& MeshData::submeshIndices(unsigned int index) const {
         return subMeshes.at(index).indices;
     }
     
@@ -235,6 +296,10 @@ namespace kick {
     
     void MeshData::recomputeNormals(){
         // empty
+        if (mNormal.size() != mPosition.size()){
+            mLayoutDirty = true;
+        }
+        markVerticesDirty(0, mPosition.size());
         mNormal.resize(mPosition.size());
         for (int i=0;i< mNormal.size();i++){
             mNormal[i] = vec3{0};
@@ -289,6 +354,8 @@ namespace kick {
         RETURN_IF_EQUAL(Uv2);
         RETURN_IF_EQUAL(Tangent);
         RETURN_IF_EQUAL(Color);
+        if (name == "_instanceModel") return VertexAttributeSemantic::InstanceModel;
+        if (name == "_instanceUID") return VertexAttributeSemantic::InstanceUID;
         return VertexAttributeSemantic::Unknown;
     }
 
@@ -306,6 +373,10 @@ namespace kick {
                 return "Tangent";
             case VertexAttributeSemantic::Color:
                 return "Color";
+            case VertexAttributeSemantic::InstanceModel:
+                return "InstanceModel";
+            case VertexAttributeSemantic::InstanceUID:
+                return "InstanceUID";
             case VertexAttributeSemantic::Unknown:
                 return "Unknown";
             default:
@@ -323,6 +394,38 @@ namespace kick {
         MeshData::mMeshUsage = meshUsage;
     }
 
+    bool MeshData::layoutDirty() const {
+        return mLayoutDirty;
+    }
+
+    size_t MeshData::dirtyVertexBegin() const {
+        return mDirtyVertexBegin;
+    }
+
+    size_t MeshData::dirtyVertexEnd() const {
+        return mDirtyVertexEnd;
+    }
+
+    bool MeshData::indicesDirty() const {
+        return mIndicesDirty;
+    }
+
+    void MeshData::clearDirty() {
+        mLayoutDirty = false;
+        mIndicesDirty = false;
+        mDirtyVertexBegin = 0;
+        mDirtyVertexEnd = 0;
+        mCleanVersion = mVersion;
+    }
+
+    uint32_t MeshData::version() const {
+        return mVersion;
+    }
+
+    uint32_t MeshData::cleanVersion() const {
+        return mCleanVersion;
+    }
+
     void MeshData::recomputeBounds() {
         mBounds.reset();
         for (auto p:mPosition){
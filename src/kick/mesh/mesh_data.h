@@ -11,6 +11,7 @@
 #include "kick/core/project_asset.h"
 #include "kick/math/bounds3.h"
 #include "kick/core/kickgl.h"
+#include <initializer_list>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -55,6 +56,8 @@ namespace kick {
         Uv2,
         Tangent,
         Color,
+        InstanceModel,  // per instance world matrix (see InstanceBuffer)
+        InstanceUID,    // per instance game object uid (see InstanceBuffer)
         Unknown
     };
     
@@ -79,6 +82,9 @@ namespace kick {
     
     /**
      * MeshData represent data on the CPU side.
+     * Changes are tracked since the last upload (see Mesh::setMeshData): vertex data assigned with the same number of
+     * vertices only marks the range of changed vertices dirty, which allows dynamic meshes to update the changed part
+     * of the vertex buffer.
      */
     class MeshData : public ProjectAsset {
     public:
@@ -102,8 +108,12 @@ namespace kick {
         const std::vector<glm::vec4>&color();
 
         // Note indices of size 0 means draw all vertices sequentially
+        void setSubmesh(unsigned int index, const std::vector<GLuint> &indices, MeshType meshType);
+        // 16 bit indices are widened (the upload width is decided by indexType())
         void setSubmesh(unsigned int index, const std::vector<GLushort> &indices, MeshType meshType);
-        const std::vector<GLushort>&submeshIndices(unsigned int index) const;
+        // resolves braced index lists, which would otherwise be ambiguous
+        void setSubmesh(unsigned int index, std::initializer_list<GLuint> indices, MeshType meshType);
+        const std::vector<GLuint>&submeshIndices(unsigned int index) const;
 
         const MeshType submeshType(unsigned int index) const;
         
@@ -111,9 +121,15 @@ namespace kick {
         GLsizei submeshSize(unsigned int index);
         
         std::vector<float> interleavedData();
+        // interleaved data of the vertices [firstVertex, firstVertex + vertexCount)
+        std::vector<float> interleavedData(size_t firstVertex, size_t vertexCount);
         std::vector<InterleavedRecord> interleavedFormat();
-        std::vector<GLushort> indicesConcat();
+        std::vector<GLuint> indicesConcat();
         std::vector<SubMeshData> indicesFormat();
+        /// GL_UNSIGNED_SHORT if all vertices can be indexed using 16 bit indices, otherwise GL_UNSIGNED_INT
+        GLenum indexType();
+        /// size in bytes of an index in the element buffer (see indexType())
+        size_t indexSize();
         
         // recomputing normals (using angle weighted normals)
         void recomputeNormals();
@@ -121,7 +137,25 @@ namespace kick {
         void recomputeBounds();
         MeshUsage meshUsage() const;
         void setMeshUsage(MeshUsage meshUsage);
+
+        /// true if the number of vertices or the vertex attributes changed since clearDirty()
+        bool layoutDirty() const;
+        /// vertices changed since clearDirty() are in the range [dirtyVertexBegin(), dirtyVertexEnd())
+        size_t dirtyVertexBegin() const;
+        size_t dirtyVertexEnd() const;
+        /// true if the submesh indices changed since clearDirty()
+        bool indicesDirty() const;
+        void clearDirty();
+        /// incremented on each change of the vertex data or the indices
+        uint32_t version() const;
+        /// the version when clearDirty() was last called (the dirty state describes the changes since this version)
+        uint32_t cleanVersion() const;
     private:
+        template<typename T>
+        void setVertexData(std::vector<T> &dest, const std::vector<T> &src);
+        void markVerticesDirty(size_t begin, size_t end);
+        size_t interleavedVertexSize();
+
         Bounds3 mBounds;
         MeshUsage mMeshUsage = MeshUsage::StaticDraw;
         std::vector<glm::vec3> mPosition;
@@ -132,11 +166,16 @@ namespace kick {
         std::vector<glm::vec4> mColor;
         
         struct SubMeshInternal {
-            std::vector<GLushort> indices;
+            std::vector<GLuint> indices;
             MeshType meshType;
         };
         
         std::vector<SubMeshInternal> subMeshes;
-        size_t computeInterleavedDataSize();
+        bool mLayoutDirty = true;
+        bool mIndicesDirty = true;
+        size_t mDirtyVertexBegin = 0;
+        size_t mDirtyVertexEnd = 0;
+        uint32_t mVersion = 1;
+        uint32_t mCleanVersion = 0;
     };
 }
\ No newline at end of file
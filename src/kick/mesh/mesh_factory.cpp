@@ -59,7 +59,7 @@ namespace kick {
         vector<vec2> uvs{vertexCount};
         vector<vec3> normals{vertexCount};
         vector<vec4> colors{vertexCount};
-        vector<GLushort> indices(vertexCount);
+        vector<GLuint> indices(vertexCount);
         for (unsigned short i = 0; i <= slices; i++) {
             auto fraction = 2 * glm::pi<float>() * i / slices;
             vertices[i] = vec3{sin(fraction),
@@ -119,7 +119,7 @@ namespace kick {
         vector<vec2> uvs{vertexCount};
         vector<vec3> normals{vertexCount};
         vector<vec4> colors{vertexCount};
-        vector<GLushort> indices;
+        vector<GLuint> indices;
 
         int index = 0;
         // create vertices
@@ -19,8 +19,10 @@
 #include "kick/core/engine.h"
 #include "kick/scene/light.h"
 #include "kick/math/misc.h"
+#include "kick/math/frustum.h"
 #include "kick/material/material.h"
 #include "kick/core/debug.h"
+#include "kick/scene/engine_uniform_blocks.h"
 #include "time.h"
 
 using namespace std;
@@ -30,22 +32,6 @@ namespace kick {
     
     Camera::Camera(GameObject *gameObject)
     :Component(gameObject){
-        Scene* scene = gameObject->scene();
-        componentListener = scene->componentEvents.createListener([&](pair<std::shared_ptr<Component>, ComponentUpdateStatus> value){
-            auto r = std::dynamic_pointer_cast<ComponentRenderable>(value.first);
-            if (r) {
-                if (value.second == ComponentUpdateStatus::Created) {
-                    mRenderableComponents.push_back(r);
-
-                } else if (value.second == ComponentUpdateStatus::Destroyed) {
-                    auto iter = find(mRenderableComponents.begin(), mRenderableComponents.end(), r);
-                    if (iter != mRenderableComponents.end()) {
-                        mRenderableComponents.erase(iter);
-                    }
-                }
-            }
-        });
-        createComponentList();
     }
 
     Camera::~Camera() {
@@ -53,25 +39,6 @@ namespace kick {
         delete mPickingRenderTarget;
     }
     
-
-    
-    void Camera::createComponentList(){
-        mRenderableComponents.clear();
-        for (auto & gameObject_ : *gameObject()->scene()) {
-            for (auto & component :  *gameObject_){
-                auto r = std::dynamic_pointer_cast<ComponentRenderable>(component);
-                if (r){
-                    mRenderableComponents.push_back(r);
-                }
-            }
-        }
-    }
-
-    void Camera::deactivated(){
-        // remove listener
-        componentListener = {};
-    }
-    
     glm::vec4 Camera::clearColor(){
         return mClearColor;
     }
@@ -87,8 +54,8 @@ namespace kick {
         int offsetY = (int)offset.y;
         int width = (int)dim.x;
         int height = (int)dim.y;
-        glViewport(offsetX, offsetY, width, height);
-        glScissor(offsetX, offsetY, width, height);
+        GLState::viewport(offsetX, offsetY, width, height);
+        GLState::scissor(offsetX, offsetY, width, height);
     }
     
     void Camera::setupCamera(EngineUniforms *engineUniforms) {
@@ -107,6 +74,7 @@ namespace kick {
         engineUniforms->viewMatrix = viewMatrix();
         engineUniforms->viewProjectionMatrix = mProjectionMatrix * engineUniforms->viewMatrix;
         engineUniforms->projectionMatrix = mProjectionMatrix;
+        EngineUniformBlocks::updateCamera(engineUniforms);
     }
 
     glm::mat4 Camera::viewMatrix(){
@@ -130,19 +98,21 @@ namespace kick {
         }
         bool customViewport = mNormalizedViewportOffset != vec2{0} || mNormalizedViewportDim != vec2{1};
         if (customViewport){
-            glEnable(GL_SCISSOR_TEST);
+            GLState::setEnabled(GL_SCISSOR_TEST, true);
         }
         setupCamera(engineUniforms);
         engineUniforms->sceneLights->recomputeLight(engineUniforms->viewMatrix);
-        auto components = cull();
-
-        sort(components.begin(), components.end(), [](ComponentRenderable* r1, ComponentRenderable* r2){
-            return r1->renderOrder() < r2->renderOrder();
-        });
+        auto components = cull(engineUniforms);
 
+        mRenderQueue.clear();
         for (auto c : components){
-            c->render(engineUniforms, mReplacementMaterial.get());
+            mRenderQueue.add(c, engineUniforms->viewMatrix);
+        }
+        mRenderQueue.sort();
+        for (size_t i = 0; i < mRenderQueue.size(); i++){
+            components[i] = mRenderQueue[i].renderable;
         }
+        renderComponents(engineUniforms, components, mReplacementMaterial.get());
         if (mTarget){
             mTarget->unbind();
         }
@@ -151,7 +121,41 @@ namespace kick {
             handleObjectPicking(engineUniforms, components);
         }
         if (customViewport){
-            glDisable(GL_SCISSOR_TEST);
+            GLState::setEnabled(GL_SCISSOR_TEST, false);
+        }
+    }
+
+    void Camera::renderComponents(EngineUniforms *engineUniforms, std::vector<ComponentRenderable*>& components, Material* replacementMaterial){
+        bool instancing = Engine::config().instancing && InstanceBuffer::supported();
+        // split the sorted components into runs, which can be rendered using a single instanced draw
+        mInstanceRuns.clear();
+        mInstanceBuffer.clear();
+        for (size_t i = 0; i < components.size();){
+            size_t end = i + 1;
+            while (instancing && end < components.size() && components[i]->canInstanceWith(components[end], replacementMaterial)){
+                end++;
+            }
+            if (end - i > 1){
+                for (size_t j = i; j < end; j++){
+                    mInstanceBuffer.add(components[j]);
+                }
+            }
+            mInstanceRuns.push_back(end);
+            i = end;
+        }
+        mInstanceBuffer.upload();
+
+        size_t first = 0;
+        size_t firstInstance = 0;
+        for (auto end : mInstanceRuns){
+            size_t count = end - first;
+            if (count == 1){
+                components[first]->render(engineUniforms, replacementMaterial);
+            } else {
+                components[first]->renderInstanced(engineUniforms, replacementMaterial, mInstanceBuffer, firstInstance, count);
+                firstInstance += count;
+            }
+            first = end;
         }
     }
 
@@ -186,9 +190,7 @@ namespace kick {
         mPickingRenderTarget->bind();
         glClearColor(0, 0, 0, 0);
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-        for (auto c : components){
-            c->render(engineUniforms, mPickingMaterial.get());
-        }
+        renderComponents(engineUniforms, components, mPickingMaterial.get());
         for (auto q : mPickQueue){
             vector<glm::u8vec4> data((int)(q.size.x * q.size.y));
             glReadPixels(q.point.x, q.point.y, q.size.x, q.size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *) glm::value_ptr(*data.data()));
@@ -369,13 +371,15 @@ namespace kick {
 
     void Camera::setIndex(int index) {mIndex = index;}
 
-    std::vector<ComponentRenderable *> Camera::cull() {
+    std::vector<ComponentRenderable *> Camera::cull(EngineUniforms *engineUniforms) {
+        Frustum frustum;
+        frustum.extractPlanes(engineUniforms->viewProjectionMatrix);
         std::vector<ComponentRenderable *> res;
-        for (auto c : mRenderableComponents){
-            if (c->gameObject()->layer() & mCullingMask) {
-                res.push_back(c.get());
-            }
-        }
+        mGameObject->scene()->queryRenderables(frustum, res, &mCullingLastPlanes);
+        res.erase(remove_if(res.begin(), res.end(), [&](ComponentRenderable *c){
+            // batched renderers are rendered by their static batch
+            return (c->gameObject()->layer() & mCullingMask) == 0 || c->staticBatch() != nullptr;
+        }), res.end());
         return res;
     }
 
@@ -14,6 +14,8 @@
 #include "kick/core/event_listener.h"
 #include "kick/math/ray.h"
 #include "component_renderable.h"
+#include "render_queue.h"
+#include "instance_buffer.h"
 #include <utility>
 #include <functional>
 #include "kick/core/kickgl.h"
@@ -36,7 +38,6 @@ namespace kick {
     public:
         Camera(GameObject *gameObject);
         ~Camera();
-        virtual void deactivated();
         virtual void render(EngineUniforms *engineUniforms);
 
         // reset matrix if used parameters (if any)
@@ -90,23 +91,27 @@ namespace kick {
         glm::vec2 mNormalizedViewportOffset = glm::vec2(0,0);
         glm::vec2 mNormalizedViewportDim = glm::vec2(1,1);
     private:
-        std::vector<ComponentRenderable*> cull();
+        std::vector<ComponentRenderable*> cull(EngineUniforms *engineUniforms);
         void initShadowMap();
         void destroyShadowMap();
         void renderShadowMap(Light* directionalLight);
-        void createComponentList();
         void handleObjectPicking(EngineUniforms *engineUniforms, std::vector<ComponentRenderable*>& components);
+        void renderComponents(EngineUniforms *engineUniforms, std::vector<ComponentRenderable*>& components, Material* replacementMaterial);
         TextureRenderTarget*mPickingRenderTarget = nullptr;
         std::shared_ptr<Texture2D> mPickingTexture;
         std::shared_ptr<Material> mPickingMaterial;
         std::shared_ptr<Shader> mShadowMapShader;
         std::shared_ptr<Material> mReplacementMaterial;
         Material*mShadowMapMaterial;
-        EventListener<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>> componentListener;
         void setupViewport(glm::vec2 &offset, glm::vec2 &dim);
-        std::vector<std::shared_ptr<ComponentRenderable>> mRenderableComponents;
         glm::vec4 mClearColor = glm::vec4(0,0,0,1);
         int mCullingMask = 0xFFFFFEFF;
+        // frustum plane which rejected each spatial index proxy in the last frame
+        std::vector<uint8_t> mCullingLastPlanes;
+        RenderQueue mRenderQueue;
+        InstanceBuffer mInstanceBuffer;
+        // end index of each run of components rendered by a single (instanced) draw
+        std::vector<size_t> mInstanceRuns;
         int mClearFlag  = GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT; // default clear color clear depth
         bool mShadow = false;
         TextureRenderTarget*mTarget = nullptr;
@@ -9,10 +9,16 @@
 #include "kick/scene/engine_uniforms.h"
 #include "kick/scene/component.h"
 #include "kick/scene/game_object.h"
+#include <atomic>
 
 using namespace std;
 
 namespace kick {
+
+    int createComponentTypeId(){
+        static std::atomic<int> counter{0};
+        return counter++;
+    }
     
     Component::Component(GameObject* gameObject)
     : mGameObject(gameObject)
@@ -49,7 +55,7 @@ namespace kick {
     void Component::setEnabled(bool enabled) {
         if (Component::mEnabled != enabled){
             Component::mEnabled = enabled;
-
+            enabledChanged();
         }
     }
 }
\ No newline at end of file
@@ -39,12 +39,24 @@ namespace kick {
         bool enabled() const;
         void setEnabled(bool enabled);
     protected:
+        // called when enabled() changes
+        virtual void enabledChanged(){}
         GameObject*mGameObject;
     private:
         Component(const Component& component) = delete;
         bool mEnabled = true;
     };
     
+    // Returns a new component type id. Use componentTypeId<T>() instead
+    int createComponentTypeId();
+
+    // Returns a small integer id unique for the component type T (ids are assigned on first use)
+    template <typename T>
+    inline int componentTypeId(){
+        static const int id = createComponentTypeId();
+        return id;
+    }
+
     typedef std::vector<std::shared_ptr<Component>>::const_iterator ConstComponentIter;
     typedef std::vector<std::shared_ptr<Component>>::iterator ComponentIter;
 }
\ No newline at end of file
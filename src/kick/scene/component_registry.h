@@ -0,0 +1,80 @@
+//
+//  component_registry.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "kick/scene/component.h"
+
+namespace kick {
+
+    class ComponentRegistryBase {
+    public:
+        virtual ~ComponentRegistryBase(){}
+        virtual void add(const std::shared_ptr<Component> &component) = 0;
+        virtual void remove(Component *component) = 0;
+    };
+
+    /// Dense list of the components in a scene of type T (or derived from T). Maintained by the scene.
+    /// The components are kept in creation order (findComponent and mainCamera return the first one).
+    /// Removal is O(1): the slot is cleared and the list is compacted once when it is read after removals.
+    template <typename T>
+    class ComponentRegistry : public ComponentRegistryBase {
+    public:
+        virtual void add(const std::shared_ptr<Component> &component) override {
+            T *t = dynamic_cast<T*>(component.get());
+            if (t){
+                mIndex[component.get()] = mComponents.size();
+                // aliasing constructor: shares ownership with the component
+                mComponents.push_back(std::shared_ptr<T>(component, t));
+                mOwners.push_back(component.get());
+            }
+        }
+
+        virtual void remove(Component *component) override {
+            auto pos = mIndex.find(component);
+            if (pos == mIndex.end()){
+                return;
+            }
+            mComponents[pos->second].reset();
+            mOwners[pos->second] = nullptr;
+            mIndex.erase(pos);
+            mRemovedCount++;
+        }
+
+        const std::vector<std::shared_ptr<T>> &components() const {
+            if (mRemovedCount > 0){
+                compact();
+            }
+            return mComponents;
+        }
+    private:
+        // remove the cleared slots, keeping the order of the remaining components
+        void compact() const {
+            size_t count = 0;
+            for (size_t i = 0; i < mOwners.size(); i++){
+                if (mOwners[i] == nullptr){
+                    continue;
+                }
+                if (count != i){
+                    mComponents[count] = std::move(mComponents[i]);
+                    mOwners[count] = mOwners[i];
+                    mIndex[mOwners[count]] = count;
+                }
+                count++;
+            }
+            mComponents.resize(count);
+            mOwners.resize(count);
+            mRemovedCount = 0;
+        }
+        // compacted lazily in components()
+        mutable std::vector<std::shared_ptr<T>> mComponents;
+        mutable std::vector<Component*> mOwners;
+        mutable std::unordered_map<Component*, size_t> mIndex;
+        mutable size_t mRemovedCount = 0;
+    };
+}
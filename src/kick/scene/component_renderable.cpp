@@ -0,0 +1,66 @@
+//
+//  component_renderable.cpp
+//  KickCPP
+//
+
+#include "kick/scene/component_renderable.h"
+#include "kick/scene/transform.h"
+#include "kick/scene/scene.h"
+#include "kick/scene/static_batch.h"
+
+namespace kick {
+
+    Material *ComponentRenderable::sortMaterial() {
+        return nullptr;
+    }
+
+    Mesh *ComponentRenderable::sortMesh() {
+        return nullptr;
+    }
+
+    bool ComponentRenderable::canInstanceWith(ComponentRenderable *other, Material *replacementMaterial) {
+        return false;
+    }
+
+    void ComponentRenderable::renderInstanced(EngineUniforms *engineUniforms, Material *replacementMaterial,
+            InstanceBuffer &instances, size_t firstInstance, size_t count) {
+    }
+
+    Bounds3 ComponentRenderable::localBounds() {
+        return Bounds3{};
+    }
+
+    const Bounds3 &ComponentRenderable::worldBounds() {
+        auto t = transform();
+        if (mBoundsDirty || mWorldBoundsVersion != t->globalVersion()){
+            Bounds3 bounds = localBounds();
+            if (bounds.uninitialized()){
+                mWorldBounds = bounds;
+            } else {
+                mWorldBounds = bounds.transform(t->globalMatrix());
+            }
+            mWorldBoundsVersion = t->globalVersion();
+            mBoundsDirty = false;
+        }
+        return mWorldBounds;
+    }
+
+    void ComponentRenderable::evictFromStaticBatch() {
+        if (mStaticBatch){
+            mStaticBatch->evict(this);
+        }
+    }
+
+    void ComponentRenderable::enabledChanged() {
+        if (!enabled()){
+            evictFromStaticBatch();
+        }
+    }
+
+    void ComponentRenderable::markBoundsDirty() {
+        mBoundsDirty = true;
+        if (mInScene){
+            mGameObject->scene()->renderableChanged(this);
+        }
+    }
+}
@@ -8,10 +8,15 @@
 #include "kick/scene/component.h"
 #include "game_object.h"
 #include "glm/glm.hpp"
+#include "kick/math/bounds3.h"
 
 namespace kick {
     struct EngineUniforms;
     class Material;
+    class Mesh;
+    class Scene;
+    class InstanceBuffer;
+    class StaticBatch;
 
     class ComponentRenderable : public Component{
     public:
@@ -27,6 +32,47 @@ namespace kick {
         // 2000-2999 Transparent. This queue is sorted in a back to front order before rendering.
         // 3000-3999 Overlay
         virtual int renderOrder() = 0;
+
+        // return the material and mesh of the (first) draw. Used for sorting the draws to minimize state changes
+        virtual Material *sortMaterial();
+        virtual Mesh *sortMesh();
+
+        // return true if this and other can be rendered using a single instanced draw. A run of renderables in the
+        // render queue, which can be instanced with the first, is rendered by renderInstanced on the first
+        virtual bool canInstanceWith(ComponentRenderable *other, Material* replacementMaterial);
+        // render the count instances starting at firstInstance in the instance buffer
+        virtual void renderInstanced(EngineUniforms *engineUniforms, Material* replacementMaterial,
+                InstanceBuffer &instances, size_t firstInstance, size_t count);
+
+        // return the bounds in object space. Uninitialized bounds (the default) means that the
+        // renderable is never frustum culled
+        virtual Bounds3 localBounds();
+
+        // return the static batch rendering this renderable (see StaticBatcher) or nullptr
+        StaticBatch *staticBatch() const { return mStaticBatch; }
+
+        // return the bounds in world space. The value is cached and only recomputed when the
+        // transform or the local bounds has changed
+        const Bounds3& worldBounds();
+    protected:
+        // must be called when the value returned by localBounds() changes
+        void markBoundsDirty();
+        // removes the renderable from its static batch (if any). Must be called when a change makes the batched
+        // data stale
+        void evictFromStaticBatch();
+        virtual void enabledChanged() override;
+    private:
+        friend class Scene;
+        friend class StaticBatch;
+        Bounds3 mWorldBounds;
+        uint32_t mWorldBoundsVersion = 0;
+        bool mBoundsDirty = true;
+        // spatial index state (maintained by the scene)
+        int mProxyId = -1;
+        bool mInScene = false;
+        bool mSpatialDirty = false;
+        StaticBatch *mStaticBatch = nullptr;
+        int mStaticBatchSlot = -1; // index in the static batch
     };
 }
 
@@ -0,0 +1,166 @@
+//
+//  engine_uniform_blocks.cpp
+//  KickCPP
+//
+
+#include "kick/scene/engine_uniform_blocks.h"
+#include "kick/scene/engine_uniforms.h"
+#include "kick/scene/scene_lights.h"
+#include "kick/scene/light.h"
+#include "kick/scene/transform.h"
+#include "kick/core/engine.h"
+#include "glm/gtc/type_ptr.hpp"
+#include <algorithm>
+#include <cstring>
+#include <regex>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+namespace kick {
+    namespace {
+        struct BlockMember {
+            const char *type;
+            const char *name;
+            bool lightArray;
+        };
+
+        struct Block {
+            const char *name;
+            EngineUniformBlocks::Binding binding;
+            vector<BlockMember> members;
+        };
+
+        // the members in std140 order (the offsets used in the update functions)
+        const vector<Block> &blocks(){
+            static vector<Block> res{
+                {"_KickFrame", EngineUniformBlocks::FrameBinding, {
+                        {"float", "_time", false},              // offset 0
+                        {"vec2", "_viewport", false}}},         // offset 8
+                {"_KickCamera", EngineUniformBlocks::CameraBinding, {
+                        {"mat4", "_v", false},                  // offset 0
+                        {"mat4", "_proj", false},               // offset 64
+                        {"vec3", "_worldCamPos", false}}},      // offset 128
+                {"_KickLights", EngineUniformBlocks::LightsBinding, {
+                        {"vec3", "_ambient", false},            // offset 0
+                        {"mat3", "_dLight", false},             // offset 16 (std140 mat3 columns are vec4 aligned)
+                        {"vec3", "_dLightWorldDir", false},     // offset 64
+                        {"mat3", "_pLights", true}}}            // offset 80
+            };
+            return res;
+        }
+
+        const size_t lightsPointLightOffset = 80;
+        const size_t std140Mat3Size = 48;
+
+#ifndef GL_ES_VERSION_2_0
+        GLuint buffers[3] = {0, 0, 0};
+        vector<char> lightsData;
+
+        void upload(EngineUniformBlocks::Binding binding, const void *data, size_t size){
+            GLuint &buffer = buffers[binding];
+            if (buffer == 0){
+                glGenBuffers(1, &buffer);
+            }
+            // glBindBufferBase also binds the buffer to the generic GL_UNIFORM_BUFFER binding
+            glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+            // respecify the storage, so the driver does not wait for draws using the previous data
+            glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+        }
+
+        void writeMat3(char *dest, const mat3 &m){
+            for (int column = 0; column < 3; column++){
+                memcpy(dest + column * 16, value_ptr(m[column]), sizeof(vec3));
+            }
+        }
+#endif
+    }
+
+    bool EngineUniformBlocks::supported() {
+#ifdef GL_ES_VERSION_2_0
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    std::string EngineUniformBlocks::replaceDeclarations(std::string &source, int lightCount) {
+        string declarations;
+        if (!supported()){
+            return declarations;
+        }
+        for (auto & block : blocks()){
+            bool used = false;
+            for (auto & member : block.members){
+                regex declaration{string{R"(\buniform\s+(?:(?:lowp|mediump|highp)\s+)?\w+\s+)"} + member.name + R"(\s*(?:\[[^\]]*\])?\s*;)"};
+                if (regex_search(source, declaration)){
+                    source = regex_replace(source, declaration, "");
+                    used = true;
+                }
+            }
+            if (!used){
+                continue;
+            }
+            declarations += string{"layout(std140) uniform "} + block.name + " {\n";
+            for (auto & member : block.members){
+                declarations += string{"    "} + member.type + " " + member.name;
+                if (member.lightArray){
+                    declarations += "[" + std::to_string(lightCount) + "]";
+                }
+                declarations += ";\n";
+            }
+            declarations += "};\n";
+        }
+        return declarations;
+    }
+
+    void EngineUniformBlocks::bindBlocks(GLuint program) {
+#ifndef GL_ES_VERSION_2_0
+        for (auto & block : blocks()){
+            GLuint index = glGetUniformBlockIndex(program, block.name);
+            if (index != GL_INVALID_INDEX){
+                glUniformBlockBinding(program, index, block.binding);
+            }
+        }
+#endif
+    }
+
+    void EngineUniformBlocks::updateFrame(EngineUniforms *engineUniforms) {
+#ifndef GL_ES_VERSION_2_0
+        float data[4] = {engineUniforms->time, 0,
+                (float)engineUniforms->viewportDimension.getValue().x, (float)engineUniforms->viewportDimension.getValue().y};
+        upload(FrameBinding, data, sizeof(data));
+#endif
+    }
+
+    void EngineUniformBlocks::updateCamera(EngineUniforms *engineUniforms) {
+#ifndef GL_ES_VERSION_2_0
+        float data[36] = {};
+        memcpy(data, value_ptr(engineUniforms->viewMatrix), sizeof(mat4));
+        memcpy(data + 16, value_ptr(engineUniforms->projectionMatrix), sizeof(mat4));
+        if (engineUniforms->currentCameraTransform){
+            vec3 cameraPosition = engineUniforms->currentCameraTransform->position();
+            memcpy(data + 32, value_ptr(cameraPosition), sizeof(vec3));
+        }
+        upload(CameraBinding, data, sizeof(data));
+#endif
+    }
+
+    void EngineUniformBlocks::updateLights(const SceneLights &sceneLights) {
+#ifndef GL_ES_VERSION_2_0
+        // the shaders declare Engine::config().maxNumerOfLights point lights
+        int lightCount = std::max(Engine::config().maxNumerOfLights, 1);
+        lightsData.assign(lightsPointLightOffset + lightCount * std140Mat3Size, 0);
+        char *data = lightsData.data();
+        vec3 ambient = sceneLights.ambientLight ? sceneLights.ambientLight->colorIntensity() : vec3{0};
+        memcpy(data, value_ptr(ambient), sizeof(vec3));
+        writeMat3(data + 16, sceneLights.directionalLightData);
+        memcpy(data + 64, value_ptr(sceneLights.directionalLightWorld), sizeof(vec3));
+        for (int i = 0; i < std::min(lightCount, KICK_MAX_POINT_LIGHTS); i++){
+            writeMat3(data + lightsPointLightOffset + i * std140Mat3Size, sceneLights.pointLightData[i]);
+        }
+        upload(LightsBinding, data, lightsData.size());
+#endif
+    }
+}
@@ -0,0 +1,41 @@
+//
+//  engine_uniform_blocks.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <string>
+#include "kick/core/kickgl.h"
+
+namespace kick {
+    struct EngineUniforms;
+    struct SceneLights;
+
+    /// std140 uniform blocks for the engine uniforms shared by all draws of a frame or a camera:
+    ///  _KickFrame (binding 0): _time, _viewport
+    ///  _KickCamera (binding 1): _v, _proj, _worldCamPos
+    ///  _KickLights (binding 2): _ambient, _dLight, _dLightWorldDir, _pLights
+    /// Shader sources keep declaring the engine uniforms as plain uniforms. When precompiled the declarations are
+    /// replaced by the uniform block (see Shader::getPrecompiledSource), so the blocks are written once per frame or
+    /// camera instead of once per draw. Not supported on GLES2, where the plain uniforms are set per draw.
+    class EngineUniformBlocks {
+    public:
+        enum Binding {
+            FrameBinding = 0,
+            CameraBinding = 1,
+            LightsBinding = 2
+        };
+
+        static bool supported();
+        /// Remove the declarations of the engine uniforms stored in blocks from the source.
+        /// Returns the declarations of the blocks used (empty if none)
+        static std::string replaceDeclarations(std::string &source, int lightCount);
+        /// Assign the binding points of the blocks used by the linked program
+        static void bindBlocks(GLuint program);
+
+        static void updateFrame(EngineUniforms *engineUniforms);
+        static void updateCamera(EngineUniforms *engineUniforms);
+        static void updateLights(const SceneLights &sceneLights);
+    };
+}
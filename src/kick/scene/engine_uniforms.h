@@ -25,5 +25,7 @@ namespace kick {
         std::shared_ptr<Camera> currentCamera;
         Transform* currentCameraTransform;
         SceneLights* sceneLights;
+        // Time::total() at the start of the frame
+        float time = 0;
     };
 }
\ No newline at end of file
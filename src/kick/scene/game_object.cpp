@@ -9,19 +9,21 @@
 #include "kick/scene/game_object.h"
 #include "kick/scene/transform.h"
 #include "kick/scene/scene.h"
+#include "kick/scene/static_batch.h"
 
 using namespace std;
 
 namespace kick {
     
-    GameObject::GameObject(const string &name, Scene* scene, int uniqueId)
-    : mName(name), mScene{scene}, mUniqueId{uniqueId}, mComponents{}, componentListeners{}
+    GameObject::GameObject(const string &name, Scene* scene, int uniqueId, std::shared_ptr<PoolAllocators> allocators)
+    : mName(name), mScene{scene}, mAllocators{move(allocators)}, mUniqueId{uniqueId}, mComponents{}, componentListeners{}
     {
         mTransform = addComponent<Transform>();
     }
     
     GameObject::GameObject(const GameObject& other)
-        : mName(other.mName), mComponents(other.mComponents), componentListeners(other.componentListeners){
+        : mName(other.mName), mComponents(other.mComponents), mComponentTypes(other.mComponentTypes),
+      mComponentIndexByType(other.mComponentIndexByType), componentListeners(other.componentListeners){
     }
  
     GameObject::~GameObject(){
@@ -31,7 +33,8 @@ namespace kick {
     }
     
     GameObject::GameObject(GameObject&& other)
-    : mName(move(other.mName)), mComponents(move(other.mComponents)), componentListeners(move(other.componentListeners)){
+    : mName(move(other.mName)), mComponents(move(other.mComponents)), mComponentTypes(move(other.mComponentTypes)),
+      mComponentIndexByType(move(other.mComponentIndexByType)), componentListeners(move(other.componentListeners)){
         other.mDestroyed = true;
     }
     
@@ -40,6 +43,8 @@ namespace kick {
         {
             mName = move(other.mName);
             mComponents = move(other.mComponents);
+            mComponentTypes = move(other.mComponentTypes);
+            mComponentIndexByType = move(other.mComponentIndexByType);
             componentListeners = move(other.componentListeners);
             other.mDestroyed = true;
         }
@@ -51,12 +56,26 @@ namespace kick {
         if (pos != mComponents.end()){
             component->deactivated();
             componentEvent.notifyListeners({component, ComponentUpdateStatus::Destroyed});
+            // a listener may already have removed the component
+            pos = find(mComponents.begin(), mComponents.end(), component);
+            if (pos == mComponents.end()){
+                return true;
+            }
+            mComponentTypes.erase(mComponentTypes.begin() + (pos - mComponents.begin()));
             mComponents.erase(pos);
+            rebuildComponentTypeIndex();
             return true;
         }
         return false;
     }
     
+    void GameObject::rebuildComponentTypeIndex() {
+        std::fill(mComponentIndexByType.begin(), mComponentIndexByType.end(), -1);
+        for (int i = (int)mComponents.size() - 1; i >= 0; i--){
+            mComponentIndexByType[mComponentTypes[i]] = i;
+        }
+    }
+
     ComponentIter GameObject::begin() {
         return mComponents.begin();
     }
@@ -85,10 +104,31 @@ namespace kick {
         return mLayer;
     }
 
+    bool GameObject::isStatic() const {
+        return mStatic;
+    }
+
+    void GameObject::setStatic(bool isStatic) {
+        mStatic = isStatic;
+        if (!isStatic){
+            for (auto & component : mComponents){
+                auto renderable = dynamic_cast<ComponentRenderable*>(component.get());
+                if (renderable && renderable->staticBatch()){
+                    renderable->staticBatch()->evict(renderable);
+                }
+            }
+        }
+    }
+
     void GameObject::setLayer(int layer) {
         if (GameObject::mLayer != layer){
             GameObject::mLayer = layer;
             for (auto c : mComponents){
+                // static batches contain renderers of a single layer
+                auto renderable = dynamic_cast<ComponentRenderable*>(c.get());
+                if (renderable && renderable->staticBatch()){
+                    renderable->staticBatch()->evict(renderable);
+                }
                 componentEvent.notifyListeners({c, ComponentUpdateStatus::Updated});
             }
         }
@@ -97,4 +137,13 @@ namespace kick {
     int GameObject::uniqueId() {
         return mUniqueId;
     }
+
+    void GameObjectDeleter::operator()(GameObject *gameObject) const {
+        if (pool){
+            gameObject->~GameObject();
+            pool->deallocate(gameObject);
+        } else {
+            delete gameObject;
+        }
+    }
 };
\ No newline at end of file
@@ -16,10 +16,25 @@
 #include "kick/scene/component.h"
 #include "kick/scene/transform.h"
 #include "kick/core/event.h"
+#include "kick/core/pool_allocator.h"
 
 
 namespace kick {
     class Scene;
+
+    /// Weak reference to a GameObject that can be stored instead of a raw GameObject pointer.
+    /// Resolve the handle using Scene::gameObject(), which returns nullptr once the GameObject is destroyed
+    /// (slots are reused with a new generation).
+    struct GameObjectHandle {
+        GameObjectHandle(){}
+        GameObjectHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+        uint32_t index = 0;
+        uint32_t generation = 0; // 0 means a null handle
+
+        bool operator==(const GameObjectHandle &other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const GameObjectHandle &other) const { return !(*this == other); }
+        explicit operator bool() const { return generation != 0; }
+    };
     
     class GameObject {
     public:
@@ -29,6 +44,8 @@ namespace kick {
         ~GameObject();
         template <typename C, typename... T>
         std::shared_ptr<C> addComponent(T... t);
+        // Return the first component of type C. Components of exactly type C are found using a single lookup,
+        // otherwise the first component derived from C is returned
         template <typename C>
         std::shared_ptr<C> component();
         template <typename C>
@@ -56,21 +73,46 @@ namespace kick {
 
         int layer() const;
         void setLayer(int layer);
+
+        // static game objects are not moved after load, and their mesh renderers may be merged by StaticBatcher
+        bool isStatic() const;
+        // clearing the flag evicts the mesh renderers from their static batch
+        void setStatic(bool isStatic);
         friend class Scene;
 
         int32_t uniqueId();
+        GameObjectHandle handle() const { return mHandle; }
     private:
-        GameObject(const std::string &name, Scene *scene, int uniqueId);
+        GameObject(const std::string &name, Scene *scene, int uniqueId, std::shared_ptr<PoolAllocators> allocators = nullptr);
+        template <typename C>
+        void appendComponents(std::vector<std::shared_ptr<C>> &res) const;
+        void rebuildComponentTypeIndex();
         Scene *mScene;
+        // pools used for components (if nullptr components are allocated using make_shared)
+        std::shared_ptr<PoolAllocators> mAllocators;
         int mUniqueId;
+        GameObjectHandle mHandle;
+        int mSceneIndex = -1; // index in the scene's list of gameobjects
         std::string mName;
         int mLayer = 1;
+        bool mStatic = false;
         bool mDestroyed = false;
         std::vector<std::shared_ptr<Component>> mComponents;
+        // component type id for each component in mComponents
+        std::vector<int> mComponentTypes;
+        // index in mComponents of the first component of each type id (or -1)
+        std::vector<int> mComponentIndexByType;
         std::vector<std::shared_ptr<Component>> newComponents;
         std::vector<std::function<void (std::shared_ptr<Component>, ComponentUpdateStatus)>> componentListeners;
         std::shared_ptr<Transform> mTransform;
     };
+
+    // Destroys a GameObject allocated from a pool (or using new if pool is nullptr)
+    struct GameObjectDeleter {
+        explicit GameObjectDeleter(PoolAllocator *pool = nullptr) : pool(pool) {}
+        void operator()(GameObject *gameObject) const;
+        PoolAllocator *pool;
+    };
 };
 
 #include "game_object.inl"
@@ -1,12 +1,37 @@
 #include "transform.h"
 
+#include <type_traits>
+
 namespace kick {
-    typedef std::vector<std::unique_ptr<GameObject>>::const_iterator GameObjectIter;
+    typedef std::vector<std::unique_ptr<GameObject, GameObjectDeleter>>::const_iterator GameObjectIter;
+
+    namespace detail {
+        // cast of a component known to be of type C
+        template <typename C>
+        inline std::shared_ptr<C> exactComponentCast(const std::shared_ptr<Component> &c, std::true_type){
+            return std::static_pointer_cast<C>(c);
+        }
+        // C is not derived from Component (such as Updatable)
+        template <typename C>
+        inline std::shared_ptr<C> exactComponentCast(const std::shared_ptr<Component> &c, std::false_type){
+            return std::dynamic_pointer_cast<C>(c);
+        }
+    }
     
     template <typename C, typename... T>
     inline std::shared_ptr<C> GameObject::addComponent(T... t){
-        auto res = std::make_shared<C>(this, t...);
+        // allocate the component and its reference count in a single pooled block
+        std::shared_ptr<C> res = mAllocators ? std::allocate_shared<C>(PoolStlAllocator<C>(mAllocators), this, t...)
+                                             : std::make_shared<C>(this, t...);
+        int typeId = componentTypeId<C>();
+        if (typeId >= (int)mComponentIndexByType.size()){
+            mComponentIndexByType.resize(typeId + 1, -1);
+        }
+        if (mComponentIndexByType[typeId] == -1){
+            mComponentIndexByType[typeId] = (int)mComponents.size();
+        }
         mComponents.push_back(res);
+        mComponentTypes.push_back(typeId);
         res->activated();
         componentEvent.notifyListeners({res, ComponentUpdateStatus::Created});
         return res;
@@ -14,24 +39,35 @@ namespace kick {
 
     template <typename C>
     inline std::shared_ptr<C> GameObject::component(){
-        for (auto c : mComponents){
-            auto comp = std::dynamic_pointer_cast<C>(c);
-            if (comp){
-                return comp;
+        int typeId = componentTypeId<C>();
+        if (typeId < (int)mComponentIndexByType.size() && mComponentIndexByType[typeId] != -1){
+            return detail::exactComponentCast<C>(mComponents[mComponentIndexByType[typeId]], std::is_base_of<Component, C>{});
+        }
+        // fallback: search for derived types
+        for (auto & c : mComponents){
+            if (dynamic_cast<C*>(c.get())){
+                return std::dynamic_pointer_cast<C>(c);
             }
         }
         return nullptr;
     }
 
     template <typename C>
-    inline std::vector<std::shared_ptr<C>> GameObject::components(){
-        std::vector<std::shared_ptr<C>> res;
-        for (auto c : mComponents){
-            std::shared_ptr<C> comp = std::dynamic_pointer_cast<C>(c);
-            if (comp){
-                res.push_back(comp);
+    inline void GameObject::appendComponents(std::vector<std::shared_ptr<C>> &res) const {
+        int typeId = componentTypeId<C>();
+        for (size_t i = 0; i < mComponents.size(); i++){
+            if (mComponentTypes[i] == typeId){
+                res.push_back(detail::exactComponentCast<C>(mComponents[i], std::is_base_of<Component, C>{}));
+            } else if (dynamic_cast<C*>(mComponents[i].get())){
+                res.push_back(std::dynamic_pointer_cast<C>(mComponents[i]));
             }
         }
+    }
+
+    template <typename C>
+    inline std::vector<std::shared_ptr<C>> GameObject::components(){
+        std::vector<std::shared_ptr<C>> res;
+        appendComponents(res);
         return res;
     }
 
@@ -0,0 +1,94 @@
+//
+//  instance_buffer.cpp
+//  KickCPP
+//
+
+#include "kick/scene/instance_buffer.h"
+#include "kick/scene/component_renderable.h"
+#include "kick/scene/transform.h"
+#include "kick/material/shader.h"
+#include "kick/math/misc.h"
+#include <cstring>
+
+using namespace std;
+
+namespace kick {
+
+    InstanceBuffer::InstanceBuffer() {
+    }
+
+    InstanceBuffer::~InstanceBuffer() {
+        if (mBuffer){
+            GLState::deleteBuffers(1, &mBuffer);
+        }
+    }
+
+    bool InstanceBuffer::supported() {
+#ifdef GL_ES_VERSION_2_0
+        return false;
+#else
+        // instanced vertex attributes are core in OpenGL 3.3 (or GL_ARB_instanced_arrays)
+        static int res = -1;
+        if (res == -1){
+            GLint major = 0;
+            GLint minor = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            res = major > 3 || (major == 3 && minor >= 3);
+            GLint extensions = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+            for (GLint i = 0; i < extensions && !res; i++){
+                const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+                res = name && strcmp(name, "GL_ARB_instanced_arrays") == 0;
+            }
+        }
+        return res == 1;
+#endif
+    }
+
+    void InstanceBuffer::clear() {
+        mInstances.clear();
+    }
+
+    size_t InstanceBuffer::add(ComponentRenderable *renderable) {
+        auto transform = renderable->transform();
+        mInstances.push_back(Instance{transform->globalMatrix(), uint32ToVec4(renderable->gameObject()->uniqueId())});
+        return mInstances.size() - 1;
+    }
+
+    void InstanceBuffer::upload() {
+        if (mInstances.empty()){
+            return;
+        }
+        if (!mBuffer){
+            glGenBuffers(1, &mBuffer);
+        }
+        GLState::bindBuffer(GL_ARRAY_BUFFER, mBuffer);
+        // reallocating the storage each frame lets the driver orphan the buffer still used by the previous frame
+        glBufferData(GL_ARRAY_BUFFER, mInstances.size() * sizeof(Instance), mInstances.data(), GL_STREAM_DRAW);
+    }
+
+    void InstanceBuffer::bindAttributes(Shader *shader, size_t firstInstance) {
+#ifndef GL_ES_VERSION_2_0
+        GLState::bindBuffer(GL_ARRAY_BUFFER, mBuffer);
+        size_t offset = firstInstance * sizeof(Instance);
+        auto model = shader->getShaderAttribute(VertexAttributeSemantic::InstanceModel);
+        if (model){
+            // a mat4 attribute uses four consecutive locations (one per column)
+            for (GLuint i = 0; i < 4; i++){
+                glEnableVertexAttribArray(model->index + i);
+                glVertexAttribPointer(model->index + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                        BUFFER_OFFSET(offset + offsetof(Instance, model) + i * sizeof(glm::vec4)));
+                glVertexAttribDivisor(model->index + i, 1);
+            }
+        }
+        auto uid = shader->getShaderAttribute(VertexAttributeSemantic::InstanceUID);
+        if (uid){
+            glEnableVertexAttribArray(uid->index);
+            glVertexAttribPointer(uid->index, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                    BUFFER_OFFSET(offset + offsetof(Instance, uid)));
+            glVertexAttribDivisor(uid->index, 1);
+        }
+#endif
+    }
+}
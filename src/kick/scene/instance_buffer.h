@@ -0,0 +1,48 @@
+//
+//  instance_buffer.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "kick/core/kickgl.h"
+
+namespace kick {
+    class ComponentRenderable;
+    class Shader;
+
+    /// Per frame instance data of hardware instanced draws. The instances of all draws are added first and uploaded
+    /// as a single buffer, after which each draw reads its instances from an offset in the buffer.
+    /// Instanced shaders read the data using the vertex attributes _instanceModel (mat4) and _instanceUID (vec4).
+    class InstanceBuffer {
+    public:
+        struct Instance {
+            glm::mat4 model;
+            glm::vec4 uid;  // game object uid packed as a color (see uint32ToVec4)
+        };
+
+        InstanceBuffer();
+        ~InstanceBuffer();
+        InstanceBuffer(const InstanceBuffer&) = delete;
+        InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+        // true if the GL context supports instanced draws and instanced vertex attributes
+        static bool supported();
+
+        void clear();
+        // adds the world matrix and uid of the renderable. Returns the instance index
+        size_t add(ComponentRenderable *renderable);
+        size_t size() const { return mInstances.size(); }
+        const Instance &operator[](size_t index) const { return mInstances[index]; }
+        // uploads the instances (orphans the previous buffer)
+        void upload();
+        // points the instance attributes of the shader at firstInstance. The vertex array must be bound
+        void bindAttributes(Shader *shader, size_t firstInstance);
+    private:
+        std::vector<Instance> mInstances;
+        GLuint mBuffer = 0;
+    };
+}
@@ -14,6 +14,7 @@ namespace kick {
     LineRenderer::LineRenderer(GameObject *gameObject) : ComponentRenderable(gameObject) {
         mMesh = make_shared<Mesh>();
         auto meshData = make_shared<MeshData>();
+        meshData->setMeshUsage(MeshUsage::DynamicDraw);
         auto shader = Project::loadShader("assets/shaders/unlit_line.shader");
 
         mMaterial = new Material();
@@ -29,7 +30,7 @@ namespace kick {
         return mPoints;
     }
 
-    void LineRenderer::setPoints(const std::vector<glm::vec3> &points, MeshType meshType, const std::vector<GLushort> &indices) {
+    void LineRenderer::setPoints(const std::vector<glm::vec3> &points, MeshType meshType, const std::vector<GLuint> &indices) {
         if (meshType != MeshType::Lines && meshType != MeshType::LineLoop && meshType != MeshType::LineStrip){
             logWarning("Invalid MeshType for line.");
         }
@@ -46,11 +47,7 @@ namespace kick {
             return;
         }
 #ifndef KICK_CONTEXT_ES2
-        if (mSmoothLine){
-            glEnable(GL_LINE_SMOOTH);
-        } else {
-            glDisable(GL_LINE_SMOOTH);
-        }
+        GLState::setEnabled(GL_LINE_SMOOTH, mSmoothLine);
 #endif
         auto mat = replacementMaterial?replacementMaterial : mMaterial;
         auto shader = mat->shader().get();
@@ -73,12 +70,25 @@ namespace kick {
         return mMaterial->renderOrder();
     }
 
+    Material *LineRenderer::sortMaterial() {
+        return mMaterial;
+    }
+
+    Mesh *LineRenderer::sortMesh() {
+        return mMesh.get();
+    }
+
     void LineRenderer::rebuildMesh() {
         auto meshData = mMesh->meshData();
         meshData->setPosition(mPoints);
         meshData->recomputeBounds();
         meshData->setSubmesh(0, mIndices, mMeshType);
         mMesh->setMeshData(meshData);
+        markBoundsDirty();
+    }
+
+    Bounds3 LineRenderer::localBounds() {
+        return mMesh->meshData()->bounds();
     }
 
     bool LineRenderer::smoothLine() const {
@@ -89,7 +99,11 @@ namespace kick {
         mSmoothLine = smoothLine;
     }
 
-    std::vector<GLushort> const &LineRenderer::indices() const {
+    std::vector<GLuint> const &LineRenderer::indices() const {
         return mIndices;
     }
+
+    MeshType LineRenderer::meshType() const {
+        return mMeshType;
+    }
 }
\ No newline at end of file
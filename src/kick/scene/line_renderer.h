@@ -24,10 +24,12 @@ namespace kick {
         virtual void render(EngineUniforms *engineUniforms, Material* replacementMaterial = nullptr) override;
 
         std::vector<glm::vec3> const &points() const;
-        std::vector<GLushort> const & indices() const;
+        std::vector<GLuint> const & indices() const;
+
+        MeshType meshType() const;
 
         // meshType should be MeshType::Lines, MeshType::LineLoop, MeshType::LineStrip
-        void setPoints(const std::vector<glm::vec3>  &points, MeshType meshType = MeshType::Lines, const std::vector<GLushort> &indices = std::vector<GLushort>{});
+        void setPoints(const std::vector<glm::vec3>  &points, MeshType meshType = MeshType::Lines, const std::vector<GLuint> &indices = std::vector<GLuint>{});
 
         // set the material
         void setMaterial(Material *material);
@@ -35,6 +37,10 @@ namespace kick {
         Material*material();
 
         virtual int renderOrder();
+        virtual Material *sortMaterial() override;
+        virtual Mesh *sortMesh() override;
+
+        virtual Bounds3 localBounds() override;
 
         bool smoothLine() const;
 
@@ -42,9 +48,9 @@ namespace kick {
 
     private:
         void rebuildMesh();
-        MeshType mMeshType;
+        MeshType mMeshType = MeshType::Lines;
         std::vector<glm::vec3> mPoints;
-        std::vector<GLushort> mIndices;
+        std::vector<GLuint> mIndices;
         std::shared_ptr<Mesh> mMesh;
         std::shared_ptr<Transform> mTransform;
         Material* mMaterial;
@@ -11,6 +11,7 @@
 #include "kick/mesh/mesh.h"
 #include "kick/scene/game_object.h"
 #include "kick/core/debug.h"
+#include "kick/scene/instance_buffer.h"
 
 namespace kick {
     MeshRenderer::MeshRenderer(GameObject *gameObject)
@@ -22,8 +23,8 @@ namespace kick {
     }
 
     void MeshRenderer::render(EngineUniforms *engineUniforms, Material* replacementMaterial){
-        if (!enabled()){
-            return;
+        if (!enabled() || staticBatch()){
+            return; // batched renderers are rendered by the static batch
         }
         if (mMesh == nullptr){
             logWarning("Cannot render mesh is null");
@@ -41,8 +42,55 @@ namespace kick {
         }
     }
     
+    bool MeshRenderer::canInstanceWith(ComponentRenderable *other, Material* replacementMaterial){
+        if (!enabled() || staticBatch() || mMesh == nullptr || mMaterials.empty() || mMesh->meshData()->position().size()==0){
+            return false;
+        }
+        auto otherRenderer = dynamic_cast<MeshRenderer*>(other);
+        if (otherRenderer == nullptr || !otherRenderer->enabled() || otherRenderer->staticBatch() || otherRenderer->mMesh != mMesh){
+            return false;
+        }
+        if (replacementMaterial){
+            return replacementMaterial->shader() && replacementMaterial->shader()->instancedShader();
+        }
+        if (otherRenderer->mMaterials != mMaterials){
+            return false;
+        }
+        for (auto material : mMaterials){
+            if (!material->shader() || !material->shader()->instancedShader()){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void MeshRenderer::renderInstanced(EngineUniforms *engineUniforms, Material* replacementMaterial,
+            InstanceBuffer &instances, size_t firstInstance, size_t count){
+        for (unsigned int i=0;i< mMaterials.size();i++){
+            auto material = replacementMaterial ? replacementMaterial : mMaterials[i];
+            auto shader = material->shader()->instancedShader();
+
+            mMesh->bind(shader);
+            instances.bindAttributes(shader, firstInstance);
+            shader->bind_uniforms(material, engineUniforms, mTransform.get());
+            mMesh->renderInstanced(i, (int)count);
+        }
+    }
+
     void MeshRenderer::setMesh(std::shared_ptr<Mesh> mesh){
+        if (mesh){
+            mMeshDataListener = mesh->meshDataChanged.createListener([this](Mesh*){
+                evictFromStaticBatch();
+                markBoundsDirty();
+            });
+        } else {
+            mMeshDataListener = EventListener<Mesh*>();
+        }
+        if (mesh != mMesh){
+            evictFromStaticBatch();
+        }
         this->mMesh = mesh;
+        markBoundsDirty();
     }
 
     std::shared_ptr<Mesh>  MeshRenderer::mesh(){
@@ -50,6 +98,9 @@ namespace kick {
     }
     
     void MeshRenderer::setMaterials(const std::vector<Material *> &mats){
+        if (mats != mMaterials){
+            evictFromStaticBatch();
+        }
         isInstanced = false;
         this->mMaterials = mats;
     }
@@ -59,6 +110,9 @@ namespace kick {
     }
     
     void MeshRenderer::setMaterial(Material *material){
+        if (mMaterials.empty() || mMaterials[0] != material){
+            evictFromStaticBatch();
+        }
         isInstanced = false;
         if (mMaterials.size()==0){
             mMaterials.push_back(material);
@@ -81,8 +135,25 @@ namespace kick {
         return mMaterials[0]->renderOrder();
     }
 
+    Material *MeshRenderer::sortMaterial() {
+        return mMaterials.empty() ? nullptr : mMaterials[0];
+    }
+
+    Mesh *MeshRenderer::sortMesh() {
+        return mMesh.get();
+    }
+
+    Bounds3 MeshRenderer::localBounds() {
+        if (mMesh == nullptr || mMesh->meshData() == nullptr){
+            return Bounds3{};
+        }
+        return mMesh->meshData()->bounds();
+    }
+
     Material *MeshRenderer::instancedMaterial() {
         if (!isInstanced){
+            // the batch would keep rendering using the shared material
+            evictFromStaticBatch();
             isInstanced = true;
             for (int i=0;i<mMaterials.size();i++){
                 mMaterials[i] = new Material(*mMaterials[i]); // memory leak
@@ -11,6 +11,7 @@
 #include "component.h"
 #include "kick/material/material.h"
 #include "component_renderable.h"
+#include "kick/core/event.h"
 #include <vector>
 
 namespace kick {
@@ -37,10 +38,18 @@ namespace kick {
         const std::vector<Material*> &instancedMaterials();
 
         virtual int renderOrder();
+        virtual Material *sortMaterial() override;
+        virtual Mesh *sortMesh() override;
+        virtual bool canInstanceWith(ComponentRenderable *other, Material* replacementMaterial) override;
+        virtual void renderInstanced(EngineUniforms *engineUniforms, Material* replacementMaterial,
+                InstanceBuffer &instances, size_t firstInstance, size_t count) override;
+
+        virtual Bounds3 localBounds() override;
 
     private:
         bool isInstanced = false;
         std::shared_ptr<Mesh> mMesh;
+        EventListener<Mesh*> mMeshDataListener;
         std::shared_ptr<Transform> mTransform;
         std::vector<Material*> mMaterials;
     };
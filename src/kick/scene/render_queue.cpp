@@ -0,0 +1,114 @@
+//
+//  render_queue.cpp
+//  KickCPP
+//
+
+#include "kick/scene/render_queue.h"
+#include "kick/scene/component_renderable.h"
+#include "kick/scene/transform.h"
+#include "kick/material/material.h"
+#include "kick/material/shader.h"
+#include "kick/mesh/mesh.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+namespace kick {
+    namespace {
+        const int renderOrderShift = 52;
+        const uint64_t renderOrderMask = 0xfff;
+
+        uint64_t renderOrderBits(int renderOrder){
+            return (uint64_t)std::min<int>(std::max<int>(renderOrder, 0), (int)renderOrderMask) << renderOrderShift;
+        }
+
+        uint32_t assetId(const ProjectAsset *asset){
+            return asset ? (uint32_t)asset->uid() : 0;
+        }
+    }
+
+    bool RenderQueue::transparent(int renderOrder) {
+        return renderOrder >= 2000 && renderOrder < 3000;
+    }
+
+    uint64_t RenderQueue::opaqueKey(int renderOrder, uint32_t shaderId, uint32_t materialId, uint32_t meshId) {
+        return renderOrderBits(renderOrder) |
+                ((uint64_t)(shaderId & 0xffff) << 36) |
+                ((uint64_t)(materialId & 0x3ffff) << 18) |
+                (uint64_t)(meshId & 0x3ffff);
+    }
+
+    uint64_t RenderQueue::transparentKey(int renderOrder, float depth, uint32_t materialId) {
+        // the bits of non negative floats are ordered as the float values. Inverted for back to front order
+        depth = depth > 0 ? depth : 0;
+        uint32_t depthBits;
+        memcpy(&depthBits, &depth, sizeof(depthBits));
+        return renderOrderBits(renderOrder) |
+                ((uint64_t)~depthBits << 20) |
+                (uint64_t)(materialId & 0xfffff);
+    }
+
+    void RenderQueue::clear() {
+        mItems.clear();
+    }
+
+    void RenderQueue::add(ComponentRenderable *renderable, const glm::mat4 &viewMatrix) {
+        int renderOrder = renderable->renderOrder();
+        Material *material = renderable->sortMaterial();
+        uint64_t key;
+        if (transparent(renderOrder)){
+            const Bounds3 &bounds = renderable->worldBounds();
+            vec3 center = bounds.uninitialized() ? renderable->transform()->position() : bounds.center();
+            float depth = -(viewMatrix[0][2] * center.x + viewMatrix[1][2] * center.y + viewMatrix[2][2] * center.z + viewMatrix[3][2]);
+            key = transparentKey(renderOrder, depth, assetId(material));
+        } else {
+            Shader *shader = material ? material->shader().get() : nullptr;
+            key = opaqueKey(renderOrder, assetId(shader), assetId(material), assetId(renderable->sortMesh()));
+        }
+        add(key, renderable);
+    }
+
+    void RenderQueue::add(uint64_t key, ComponentRenderable *renderable) {
+        mItems.push_back(Item{key, renderable});
+    }
+
+    void RenderQueue::sort() {
+        size_t count = mItems.size();
+        if (count < 2){
+            return;
+        }
+        // bits that differ between the keys
+        uint64_t differentBits = 0;
+        for (auto & item : mItems){
+            differentBits |= item.key ^ mItems[0].key;
+        }
+        mBuffer.resize(count);
+        Item *source = mItems.data();
+        Item *dest = mBuffer.data();
+        size_t histogram[256];
+        for (int shift = 0; shift < 64; shift += 8){
+            if (((differentBits >> shift) & 0xff) == 0){
+                continue;
+            }
+            memset(histogram, 0, sizeof(histogram));
+            for (size_t i = 0; i < count; i++){
+                histogram[(source[i].key >> shift) & 0xff]++;
+            }
+            size_t offset = 0;
+            for (int i = 0; i < 256; i++){
+                size_t c = histogram[i];
+                histogram[i] = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < count; i++){
+                dest[histogram[(source[i].key >> shift) & 0xff]++] = source[i];
+            }
+            swap(source, dest);
+        }
+        if (source != mItems.data()){
+            mItems.swap(mBuffer);
+        }
+    }
+}
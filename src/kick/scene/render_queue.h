@@ -0,0 +1,46 @@
+//
+//  render_queue.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace kick {
+    class ComponentRenderable;
+
+    /// Draws sorted by a packed 64 bit key. The render order is stored in the top 12 bits. Draws in the transparent
+    /// queue (render order 2000-2999) are sorted back to front using the view depth of the world bounds center.
+    /// Other draws are sorted by shader, material and mesh id to minimize state changes.
+    /// The sort is a stable LSD radix sort, which skips the digits that are equal for all keys.
+    class RenderQueue {
+    public:
+        struct Item {
+            uint64_t key;
+            ComponentRenderable *renderable;
+        };
+
+        static bool transparent(int renderOrder);
+        // render order (12 bits) | shader id (16 bits) | material id (18 bits) | mesh id (18 bits)
+        static uint64_t opaqueKey(int renderOrder, uint32_t shaderId, uint32_t materialId, uint32_t meshId);
+        // render order (12 bits) | inverted depth (32 bits) | material id (20 bits)
+        static uint64_t transparentKey(int renderOrder, float depth, uint32_t materialId);
+
+        void clear();
+        // computes the key of the renderable
+        void add(ComponentRenderable *renderable, const glm::mat4 &viewMatrix);
+        void add(uint64_t key, ComponentRenderable *renderable);
+        void sort();
+
+        size_t size() const { return mItems.size(); }
+        const Item &operator[](size_t index) const { return mItems[index]; }
+        std::vector<Item>::const_iterator begin() const { return mItems.begin(); }
+        std::vector<Item>::const_iterator end() const { return mItems.end(); }
+    private:
+        std::vector<Item> mItems;
+        std::vector<Item> mBuffer;
+    };
+}
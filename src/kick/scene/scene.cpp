@@ -7,6 +7,7 @@
 //
 
 #include "kick/scene/scene.h"
+#include "kick/scene/static_batch.h"
 #include <iostream>
 #include <algorithm>
 #include "rapidjson/rapidjson.h"
@@ -26,58 +27,143 @@
 #include "kick/texture/texture_atlas.h"
 #include "kick/2d/button.h"
 #include "kick/2d/canvas.h"
+#include "kick/scene/component_renderable.h"
+#include "kick/scene/transform.h"
+#include "kick/scene/transform_hierarchy.h"
 
 using namespace std;
 
 namespace kick {
     
     Scene::Scene(const std::string & name)
-    : mName(name)
+    : mAllocators(make_shared<PoolAllocators>()), mName(name)
     {
+        registerComponentType<Camera>();
+        registerComponentType<ComponentRenderable>();
+        registerComponentType<Light>();
+        registerComponentType<Updatable>();
     }
     
     Scene::~Scene(){
     }
     
     Scene::Scene(Scene&& scene)
-    : mGameObjects(move(scene.mGameObjects)),
-     mCameras(move(scene.mCameras)),
-     mName(move(scene.mName))
-    {}
+    : mAllocators(move(scene.mAllocators)),
+     mGameObjects(move(scene.mGameObjects)),
+     mGameObjectSlots(move(scene.mGameObjectSlots)),
+     mFreeGameObjectSlots(move(scene.mFreeGameObjectSlots)),
+     mGameObjectSlotByUID(move(scene.mGameObjectSlotByUID)),
+     mRegistries(move(scene.mRegistries)),
+     mUpdating(scene.mUpdating),
+     mUpdatableRemoved(scene.mUpdatableRemoved),
+     mLights(move(scene.mLights)),
+     mSceneLights(move(scene.mSceneLights)),
+     mName(move(scene.mName)),
+     mUniqueIdGenerator(scene.mUniqueIdGenerator),
+     mSpatialIndex(move(scene.mSpatialIndex)),
+     mUnboundedRenderables(move(scene.mUnboundedRenderables)),
+     mDirtyRenderables(move(scene.mDirtyRenderables)),
+     mDirtyTransforms(move(scene.mDirtyTransforms)),
+     mThreadDirtyTransforms(move(scene.mThreadDirtyTransforms)),
+     mTransformHierarchy(move(scene.mTransformHierarchy)),
+     mTransformChangeEpoch(scene.mTransformChangeEpoch.load())
+    {
+        for (int i = 0; i < 3; i++){
+            mUpdatables[i] = move(scene.mUpdatables[i]);
+        }
+    }
     
     Scene& Scene::operator=(Scene&& other){
         if (this != &other){
+            // destroy the old gameobjects (after their listeners) before their pools
+            mGameObjectSlots.clear();
+            mGameObjects.clear();
+            mAllocators = move(other.mAllocators);
             mGameObjects = move(other.mGameObjects);
-            mCameras = move(other.mCameras);
+            mGameObjectSlots = move(other.mGameObjectSlots);
+            mFreeGameObjectSlots = move(other.mFreeGameObjectSlots);
+            mGameObjectSlotByUID = move(other.mGameObjectSlotByUID);
+            mRegistries = move(other.mRegistries);
+            for (int i = 0; i < 3; i++){
+                mUpdatables[i] = move(other.mUpdatables[i]);
+            }
+            mUpdating = other.mUpdating;
+            mUpdatableRemoved = other.mUpdatableRemoved;
+            mLights = move(other.mLights);
+            mSceneLights = move(other.mSceneLights);
             mName = move(other.mName);
+            mUniqueIdGenerator = other.mUniqueIdGenerator;
+            mSpatialIndex = move(other.mSpatialIndex);
+            mUnboundedRenderables = move(other.mUnboundedRenderables);
+            mDirtyRenderables = move(other.mDirtyRenderables);
+            mDirtyTransforms = move(other.mDirtyTransforms);
+            mThreadDirtyTransforms = move(other.mThreadDirtyTransforms);
+            mTransformHierarchy = move(other.mTransformHierarchy);
+            mTransformChangeEpoch = other.mTransformChangeEpoch.load();
         }
         return *this;
     }
     
     GameObject *Scene::createGameObject(const string &name){
-        auto res = new GameObject(name, this, ++mUniqueIdGenerator);
-        EventListener<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>> eventListener = res->componentEvent.createListener([&](std::pair<std::shared_ptr<Component>, ComponentUpdateStatus> e){
+        PoolAllocator *pool = mAllocators->pool<GameObject>();
+        auto res = new (pool->allocate()) GameObject(name, this, ++mUniqueIdGenerator, mAllocators);
+        EventListener<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>> eventListener = res->componentEvent.createListener([this](const std::pair<std::shared_ptr<Component>, ComponentUpdateStatus> &e){
             componentListener(e.first, e.second);
         });
 
-        mGameObjects.push_back(unique_ptr<GameObject>(res));
-        mComponentListeners[res] = move(eventListener);
+        uint32_t slotIndex;
+        if (mFreeGameObjectSlots.empty()){
+            slotIndex = (uint32_t)mGameObjectSlots.size();
+            mGameObjectSlots.emplace_back();
+        } else {
+            slotIndex = mFreeGameObjectSlots.back();
+            mFreeGameObjectSlots.pop_back();
+        }
+        GameObjectSlot &slot = mGameObjectSlots[slotIndex];
+        slot.gameObject = res;
+        slot.componentListener = move(eventListener);
+        res->mHandle = GameObjectHandle{slotIndex, slot.generation};
+        res->mSceneIndex = (int)mGameObjects.size();
+        mGameObjectSlotByUID[res->uniqueId()] = slotIndex;
+        mGameObjects.push_back(unique_ptr<GameObject, GameObjectDeleter>(res, GameObjectDeleter(pool)));
         return res;
     }
 
+    void Scene::reserveGameObjects(size_t count) {
+        mGameObjects.reserve(mGameObjects.size() + count);
+        mGameObjectSlots.reserve(mGameObjectSlots.size() + count);
+        mGameObjectSlotByUID.reserve(mGameObjectSlotByUID.size() + count);
+        mAllocators->pool<GameObject>()->reserve(count);
+    }
+
     bool Scene::destroyGameObject(GameObject *gameObject){
-        for (int i=0;i< mGameObjects.size();i++){
-            if (mGameObjects[i].get() == gameObject){
-                //explicit destroy (since gameObject may be referenced from other places)
-                for (auto c : gameObject->components<Component>()){
-                    gameObject->destroyComponent(c);
-                }
-                mComponentListeners.erase(gameObject);
-                mGameObjects.erase(mGameObjects.begin()+i);
-                return true;
-            }
+        if (!gameObject || gameObject->mSceneIndex < 0 || gameObject->mSceneIndex >= (int)mGameObjects.size()
+                || mGameObjects[gameObject->mSceneIndex].get() != gameObject){
+            return false;
+        }
+        //explicit destroy (since gameObject may be referenced from other places)
+        for (auto c : gameObject->components<Component>()){
+            gameObject->destroyComponent(c);
+        }
+        uint32_t slotIndex = gameObject->mHandle.index;
+        GameObjectSlot &slot = mGameObjectSlots[slotIndex];
+        slot.gameObject = nullptr;
+        slot.componentListener = {};
+        // skip generation 0, which is used by null handles
+        if (++slot.generation == 0){
+            slot.generation = 1;
+        }
+        mFreeGameObjectSlots.push_back(slotIndex);
+        mGameObjectSlotByUID.erase(gameObject->uniqueId());
+
+        // swap and pop
+        int index = gameObject->mSceneIndex;
+        if (index != (int)mGameObjects.size() - 1){
+            swap(mGameObjects[index], mGameObjects.back());
+            mGameObjects[index]->mSceneIndex = index;
         }
-        return false;
+        mGameObjects.pop_back();
+        return true;
     }
     
     std::string Scene::name() const{
@@ -97,17 +183,85 @@ namespace kick {
     }
         
     void Scene::update() {
-        for (auto & component : mUpdatable) {
-            component->update();
+        mUpdating = true;
+        for (auto & phase : mUpdatables){
+            updatePhase(phase);
+        }
+        mUpdating = false;
+        if (mUpdatableRemoved){
+            // compact entries removed during update
+            for (auto & phase : mUpdatables){
+                for (auto list : {&phase.parallel, &phase.serial}){
+                    list->erase(remove_if(list->begin(), list->end(), [](const UpdatableEntry &e){
+                        return e.updatable == nullptr;
+                    }), list->end());
+                }
+            }
+            mUpdatableRemoved = false;
+        }
+    }
+
+    void Scene::updatePhase(UpdatePhaseEntries &entries) {
+        JobSystem *jobSystem = Engine::jobSystem();
+        auto &parallel = entries.parallel;
+        if (jobSystem && jobSystem->workerThreadCount() > 0 && parallel.size() > 1){
+            mThreadDirtyTransforms.resize(jobSystem->workerThreadCount() + 1);
+            mParallelUpdating = true;
+            jobSystem->parallelFor(0, (int)parallel.size(), [&](int begin, int end){
+                for (int i = begin; i < end; i++){
+                    if (parallel[i].updatable && parallel[i].component->enabled()){
+                        parallel[i].updatable->update();
+                    }
+                }
+            }, 16);
+            mParallelUpdating = false;
+            for (auto & dirtyTransforms : mThreadDirtyTransforms){
+                mDirtyTransforms.insert(mDirtyTransforms.end(), dirtyTransforms.begin(), dirtyTransforms.end());
+                dirtyTransforms.clear();
+            }
+        } else {
+            for (auto & e : parallel){
+                if (e.updatable && e.component->enabled()){
+                    e.updatable->update();
+                }
+            }
+        }
+        // index based, since components may be added or removed during update
+        auto &serial = entries.serial;
+        for (size_t i = 0; i < serial.size(); i++){
+            if (serial[i].updatable && serial[i].component->enabled()){
+                serial[i].updatable->update();
+            }
+        }
+    }
+
+    void Scene::removeUpdatable(Updatable *updatable) {
+        for (auto & phase : mUpdatables){
+            for (auto list : {&phase.parallel, &phase.serial}){
+                auto pos = find_if(list->begin(), list->end(), [&](const UpdatableEntry &e){
+                    return e.updatable == updatable;
+                });
+                if (pos != list->end()){
+                    if (mUpdating){
+                        pos->updatable = nullptr;
+                        mUpdatableRemoved = true;
+                    } else {
+                        list->erase(pos);
+                    }
+                    return;
+                }
+            }
         }
     }
     
     void Scene::render(EngineUniforms* engineUniforms){
+        updateSpatialIndex();
         engineUniforms->sceneLights = &mSceneLights;
-        std::sort(mCameras.begin(), mCameras.end(), [](std::shared_ptr<Camera> c1, std::shared_ptr<Camera> c2){
+        auto cameras = componentRegistry<Camera>()->components();
+        std::stable_sort(cameras.begin(), cameras.end(), [](const std::shared_ptr<Camera> &c1, const std::shared_ptr<Camera> &c2){
             return c1->index() < c2->index();
         });
-        for (auto & camera : mCameras) {
+        for (auto & camera : cameras) {
             if (camera->enabled()){
                 engineUniforms->currentCamera = camera;
                 camera->render(engineUniforms);
@@ -117,29 +271,45 @@ namespace kick {
     
     void Scene::componentListener(std::shared_ptr<Component> component, ComponentUpdateStatus status){
         componentEvents.notifyListeners({component, status});
-        auto camera = std::dynamic_pointer_cast<Camera>(component);
         auto light = std::dynamic_pointer_cast<Light>(component);
+        auto renderable = dynamic_cast<ComponentRenderable*>(component.get());
         if (status == ComponentUpdateStatus::Created){
-            if (camera){
-                mCameras.push_back(camera);
-            } else if (light){
-                mLights[light] = light->lightTypeChanged.createListener([&](std::shared_ptr<Light> l){
+            for (auto & registry : mRegistries){
+                if (registry){
+                    registry->add(component);
+                }
+            }
+            if (renderable){
+                addRenderable(renderable);
+            }
+            if (light){
+                mLights[light] = light->lightTypeChanged.createListener([this](const std::shared_ptr<Light> &l){
                     rebuildSceneLights();
                 }, 0);
                 addLight(light);
             }
-            auto updateable = std::dynamic_pointer_cast<Updatable>(component);
+            auto updateable = dynamic_cast<Updatable*>(component.get());
             if (updateable){
-                mUpdatable.push_back(updateable);
+                auto & phase = mUpdatables[(int)updateable->updatePhase()];
+                auto & list = updateable->parallelUpdate() ? phase.parallel : phase.serial;
+                list.push_back({updateable, component.get()});
             }
         }
         if (status == ComponentUpdateStatus::Destroyed){
-            if (camera){
-                auto pos = find(mCameras.begin(), mCameras.end(), camera);
-                if (pos != mCameras.end()){
-                    mCameras.erase(pos);
+            for (auto & registry : mRegistries){
+                if (registry){
+                    registry->remove(component.get());
                 }
-            } else if (light){
+            }
+            if (renderable){
+                removeRenderable(renderable);
+            }
+            auto transform = dynamic_cast<Transform*>(component.get());
+            if (transform && transform->mSpatialDirty){
+                transform->mSpatialDirty = false;
+                mDirtyTransforms.erase(find(mDirtyTransforms.begin(), mDirtyTransforms.end(), transform));
+            }
+            if (light){
                 // rebuild lights
                 auto lightPos = mLights.find(light);
                 if (lightPos != mLights.end()){
@@ -147,12 +317,9 @@ namespace kick {
                     rebuildSceneLights();
                 }
             }
-            auto updateable = std::dynamic_pointer_cast<Updatable>(component);
+            auto updateable = dynamic_cast<Updatable*>(component.get());
             if (updateable){
-                auto pos = find(mUpdatable.begin(), mUpdatable.end(), updateable);
-                if (pos != mUpdatable.end()){
-                    mUpdatable.erase(pos);
-                }
+                removeUpdatable(updateable);
             }
         }
     }
@@ -233,7 +400,7 @@ namespace kick {
     }
 
 
-    std::shared_ptr<LineRenderer> Scene::createLine(GameObject *gameObject, const vector<glm::vec3> &points, kick::MeshType meshType, const std::vector<GLushort> &indices) {
+    std::shared_ptr<LineRenderer> Scene::createLine(GameObject *gameObject, const vector<glm::vec3> &points, kick::MeshType meshType, const std::vector<GLuint> &indices) {
         if (!gameObject) {
             gameObject = createGameObject("Plane");
         }
@@ -308,23 +475,206 @@ namespace kick {
     }
 
     GameObject *Scene::gameObjectByUID(int32_t uid) {
-        for (auto & gameObject : *this) {
-            if (gameObject->uniqueId() == uid) {
-                return gameObject.get();
-            }
+        auto pos = mGameObjectSlotByUID.find(uid);
+        if (pos == mGameObjectSlotByUID.end()){
+            return nullptr;
         }
-        return nullptr;
+        return mGameObjectSlots[pos->second].gameObject;
+    }
+
+    const PoolAllocators &Scene::allocators() const {
+        return *mAllocators;
+    }
+
+    GameObject *Scene::gameObject(GameObjectHandle handle) {
+        if (handle.index >= mGameObjectSlots.size()){
+            return nullptr;
+        }
+        const GameObjectSlot &slot = mGameObjectSlots[handle.index];
+        return slot.generation == handle.generation ? slot.gameObject : nullptr;
     }
 
     std::shared_ptr<Camera> Scene::mainCamera() {
-        for (auto c : mCameras) {
+        auto & cameras = componentRegistry<Camera>()->components();
+        for (auto & c : cameras) {
             if (c->main()) {
                 return c;
             }
         }
-        if (!mCameras.empty()) {
-            return mCameras[0];
+        if (!cameras.empty()) {
+            return cameras[0];
         }
         return std::shared_ptr<Camera>();
     }
-}
\ No newline at end of file
+
+    void Scene::transformChanged(Transform *transform) {
+        if (mParallelUpdating){
+            // each thread has its own queue, so parallel updatables can move their transforms
+            mThreadDirtyTransforms[Engine::jobSystem()->threadIndex()].push_back(transform);
+        } else {
+            mDirtyTransforms.push_back(transform);
+        }
+    }
+
+    void Scene::renderableChanged(ComponentRenderable *renderable) {
+        if (!renderable->mSpatialDirty){
+            renderable->mSpatialDirty = true;
+            mDirtyRenderables.push_back(renderable);
+        }
+    }
+
+    void Scene::addRenderable(ComponentRenderable *renderable) {
+        renderable->mInScene = true;
+        renderable->mProxyId = DynamicAABBTree::nullNode;
+        // inserted into the tree on the next update (if the renderable has bounds)
+        mUnboundedRenderables.push_back(renderable);
+        renderableChanged(renderable);
+    }
+
+    void Scene::removeRenderable(ComponentRenderable *renderable) {
+        if (renderable->mStaticBatch){
+            renderable->mStaticBatch->evict(renderable);
+        }
+        if (!renderable->mInScene){
+            return;
+        }
+        if (renderable->mProxyId != DynamicAABBTree::nullNode){
+            mSpatialIndex.destroyProxy(renderable->mProxyId);
+            renderable->mProxyId = DynamicAABBTree::nullNode;
+        } else {
+            mUnboundedRenderables.erase(find(mUnboundedRenderables.begin(), mUnboundedRenderables.end(), renderable));
+        }
+        if (renderable->mSpatialDirty){
+            renderable->mSpatialDirty = false;
+            mDirtyRenderables.erase(find(mDirtyRenderables.begin(), mDirtyRenderables.end(), renderable));
+        }
+        renderable->mInScene = false;
+    }
+
+    void Scene::updateSpatialIndex() {
+        auto markRenderablesChanged = [&](Transform *transform){
+            for (auto & component : *transform->gameObject()){
+                auto renderable = dynamic_cast<ComponentRenderable*>(component.get());
+                if (renderable && renderable->mInScene){
+                    renderableChanged(renderable);
+                }
+                if (renderable && renderable->mStaticBatch){
+                    // batched renderers are evicted when moved
+                    renderable->mStaticBatch->transformChanged(renderable);
+                }
+            }
+        };
+        if (mTransformHierarchy){
+            mTransformHierarchy->update(markRenderablesChanged);
+        }
+        // only the changed transforms are queued (not their children), so visit the subtrees once per frame
+        std::vector<Transform*> &stack = mTransformStack;
+        for (auto transform : mDirtyTransforms){
+            transform->mSpatialDirty = false;
+            stack.push_back(transform);
+            while (!stack.empty()){
+                Transform *t = stack.back();
+                stack.pop_back();
+                markRenderablesChanged(t);
+                for (auto & child : *t){
+                    stack.push_back(child.get());
+                }
+            }
+        }
+        mDirtyTransforms.clear();
+
+        for (auto renderable : mDirtyRenderables){
+            renderable->mSpatialDirty = false;
+            glm::vec3 oldCenter = renderable->mWorldBounds.center();
+            const Bounds3 &bounds = renderable->worldBounds();
+            if (bounds.uninitialized()){
+                if (renderable->mProxyId != DynamicAABBTree::nullNode){
+                    mSpatialIndex.destroyProxy(renderable->mProxyId);
+                    renderable->mProxyId = DynamicAABBTree::nullNode;
+                    mUnboundedRenderables.push_back(renderable);
+                }
+            } else if (renderable->mProxyId == DynamicAABBTree::nullNode){
+                mUnboundedRenderables.erase(find(mUnboundedRenderables.begin(), mUnboundedRenderables.end(), renderable));
+                renderable->mProxyId = mSpatialIndex.createProxy(bounds, renderable);
+            } else {
+                mSpatialIndex.moveProxy(renderable->mProxyId, bounds, bounds.center() - oldCenter);
+            }
+        }
+        mDirtyRenderables.clear();
+    }
+
+    void Scene::queryRenderables(const Frustum &frustum, std::vector<ComponentRenderable *> &result, std::vector<uint8_t> *lastPlanes) {
+        updateSpatialIndex();
+        result.insert(result.end(), mUnboundedRenderables.begin(), mUnboundedRenderables.end());
+        mSpatialIndex.queryFrustum(frustum, [&](int proxyId, FrustumIntersection intersection, uint32_t planeMask){
+            auto renderable = static_cast<ComponentRenderable*>(mSpatialIndex.userData(proxyId));
+            // the tree contains the enlarged bounds, so test the exact bounds against the planes they intersect
+            if (intersection != FrustumIntersection::Inside){
+                uint8_t lastPlane = 0;
+                uint8_t &cachedPlane = lastPlanes ? (*lastPlanes)[proxyId] : lastPlane;
+                if (frustum.intersectAabb(renderable->worldBounds(), planeMask, cachedPlane) == FrustumIntersection::Outside){
+                    return true;
+                }
+            }
+            result.push_back(renderable);
+            return true;
+        }, lastPlanes);
+    }
+
+    void Scene::queryRenderables(const Bounds3 &bounds, std::vector<ComponentRenderable *> &result) {
+        updateSpatialIndex();
+        mSpatialIndex.query(bounds, [&](int proxyId){
+            auto renderable = static_cast<ComponentRenderable*>(mSpatialIndex.userData(proxyId));
+            if (renderable->worldBounds().intersect(bounds)){
+                result.push_back(renderable);
+            }
+            return true;
+        });
+    }
+
+    void Scene::raycastRenderables(const Ray &ray, std::vector<ComponentRenderable *> &result, float maxDistance) {
+        updateSpatialIndex();
+        std::vector<std::pair<float, ComponentRenderable*>> hits;
+        mSpatialIndex.rayCast(ray, [&](int proxyId, float distance){
+            auto renderable = static_cast<ComponentRenderable*>(mSpatialIndex.userData(proxyId));
+            float exactDistance;
+            if (ray.intersectAabb(renderable->worldBounds(), exactDistance, maxDistance)){
+                hits.push_back({exactDistance, renderable});
+            }
+            return true;
+        }, maxDistance);
+        sort(hits.begin(), hits.end(), [](const std::pair<float, ComponentRenderable*> &a, const std::pair<float, ComponentRenderable*> &b){
+            return a.first < b.first;
+        });
+        for (auto & hit : hits){
+            result.push_back(hit.second);
+        }
+    }
+
+    void Scene::setFlatTransformHierarchy(bool enabled) {
+        if (enabled == flatTransformHierarchy()){
+            return;
+        }
+        mTransformHierarchy = enabled ? make_shared<TransformHierarchy>() : nullptr;
+        for (auto & gameObject : mGameObjects){
+            gameObject->transform()->setHierarchy(mTransformHierarchy);
+        }
+        if (enabled){
+            // parents are linked when all transforms are added
+            for (auto & gameObject : mGameObjects){
+                auto transform = gameObject->transform();
+                if (transform->parent()){
+                    mTransformHierarchy->setParent(transform->mHierarchyIndex, transform->parent()->mHierarchyIndex);
+                }
+            }
+        }
+    }
+
+    bool Scene::flatTransformHierarchy() const {
+        return mTransformHierarchy != nullptr;
+    }
+
+    std::shared_ptr<TransformHierarchy> Scene::transformHierarchy() {
+        return mTransformHierarchy;
+    }
+}
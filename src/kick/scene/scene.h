@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -24,18 +25,23 @@
 #include "kick/scene/line_renderer.h"
 #include "kick/scene/camera_orthographic.h"
 #include "kick/2d/label.h"
+#include "kick/math/dynamic_aabb_tree.h"
+#include "kick/scene/updatable.h"
+#include "kick/scene/component_registry.h"
 
 namespace kick {
     class CameraPerspective;
     class CameraOrthographic;
     class MeshRenderer;
     class Light;
-    class Updatable;
     class Label;
     class Sprite;
     class TextureAtlas;
     class Button;
     class Canvas;
+    class ComponentRenderable;
+    class Transform;
+    class TransformHierarchy;
 
     class Scene {
     public:
@@ -43,6 +49,8 @@ namespace kick {
         Scene& operator=(Scene&& other);
         virtual ~Scene();
         GameObject *createGameObject(const std::string &name = "gameobject");
+        // Allocate room for count more gameobjects in bulk (used when loading scenes)
+        void reserveGameObjects(size_t count);
         bool destroyGameObject(GameObject * gameObject);
         GameObjectIter begin() const;
         GameObjectIter end() const;
@@ -52,28 +60,58 @@ namespace kick {
         void render(EngineUniforms* engineUniforms);
         Event<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>> componentEvents;
 
+        // Maintain a registry of the components of type T (including derived types) in the scene. Cameras,
+        // renderables, lights and updatables are always registered
+        template <typename T>
+        void registerComponentType(){
+            int typeId = componentTypeId<T>();
+            if (typeId >= (int)mRegistries.size()){
+                mRegistries.resize(typeId + 1);
+            }
+            if (!mRegistries[typeId]){
+                mRegistries[typeId].reset(new ComponentRegistry<T>());
+                for (auto & gameObject : mGameObjects){
+                    for (auto & component : *gameObject){
+                        mRegistries[typeId]->add(component);
+                    }
+                }
+            }
+        }
+
+        // Return the registry of components of type T (or nullptr if the type is not registered)
+        template <typename T>
+        const ComponentRegistry<T> *componentRegistry() const {
+            int typeId = componentTypeId<T>();
+            if (typeId < (int)mRegistries.size()){
+                return static_cast<const ComponentRegistry<T>*>(mRegistries[typeId].get());
+            }
+            return nullptr;
+        }
+
+        // Return all components of type T. Uses the registry if the type is registered
         template <typename T>
         std::vector<std::shared_ptr<T>> findComponents(){
+            auto registry = componentRegistry<T>();
+            if (registry){
+                return registry->components();
+            }
             std::vector<std::shared_ptr<T>> res;
             for (auto & gameObject : *this){
-                for (auto & comp : *gameObject){
-                    auto component = std::dynamic_pointer_cast<T>(comp);
-                    if (component){
-                        res.push_back(component);
-                    }
-                }
+                gameObject->appendComponents(res);
             }
             return res;
         }
 
         template <typename T>
         std::shared_ptr<T> findComponent(){
+            auto registry = componentRegistry<T>();
+            if (registry){
+                return registry->components().empty() ? nullptr : registry->components().front();
+            }
             for (auto & gameObject : *this){
-                for (auto & comp : *gameObject){
-                    auto component = std::dynamic_pointer_cast<T>(comp);
-                    if (component){
-                        return component;
-                    }
+                auto component = gameObject->component<T>();
+                if (component){
+                    return component;
                 }
             }
             return nullptr;
@@ -84,7 +122,7 @@ namespace kick {
         // Creates a gameobject and attaches an orthographic camera to it
         std::shared_ptr<CameraOrthographic> createOrthographicCamera(GameObject *go = nullptr);
         // Creates a gameobject and attaches a line renderer with diffuse renderer
-        std::shared_ptr<LineRenderer> createLine(GameObject *go = nullptr, const std::vector<glm::vec3> &points = std::vector<glm::vec3>(), MeshType meshType = MeshType::Lines, const std::vector<GLushort> &indices = std::vector<GLushort>{});
+        std::shared_ptr<LineRenderer> createLine(GameObject *go = nullptr, const std::vector<glm::vec3> &points = std::vector<glm::vec3>(), MeshType meshType = MeshType::Lines, const std::vector<GLuint> &indices = std::vector<GLuint>{});
         // Creates a gameobject and attaches a cube with diffuse renderer
         std::shared_ptr<MeshRenderer> createCube(GameObject *go = nullptr, float length = 1);
         // Creates a gameobject and attaches a sphere with diffuse renderer
@@ -103,20 +141,68 @@ namespace kick {
         friend class Engine;
         friend class GameObject;
 
+        // Return the gameobject with the unique id (or nullptr if not found)
         GameObject *gameObjectByUID(int32_t uid);
+        // Resolve a handle. Returns nullptr if the gameobject has been destroyed
+        GameObject *gameObject(GameObjectHandle handle);
+
+        // The pools used for the gameobjects and components of the scene. The allocation counters can be used to
+        // verify that creating and destroying gameobjects does not allocate new memory from the heap
+        const PoolAllocators &allocators() const;
 
         // Return the first camera component marked as main camera (or any camera if no camera marked).
         // Return nullptr if no camera component in scene
         std::shared_ptr<Camera> mainCamera();
+
+        // Append the renderables inside (or intersecting) the frustum to result.
+        // Renderables without bounds (such as skyboxes and canvases) are always included.
+        // lastPlanes (optional) caches the rejecting frustum plane of each proxy between queries (one per view).
+        void queryRenderables(const Frustum &frustum, std::vector<ComponentRenderable*> &result, std::vector<uint8_t> *lastPlanes = nullptr);
+        // Append the renderables with world bounds overlapping the bounds to result
+        void queryRenderables(const Bounds3 &bounds, std::vector<ComponentRenderable*> &result);
+        // Append the renderables with world bounds hit by the ray to result (sorted by distance)
+        void raycastRenderables(const Ray &ray, std::vector<ComponentRenderable*> &result, float maxDistance = std::numeric_limits<float>::max());
+
+        // Store the transforms in a flat depth sorted hierarchy. Global matrices are then updated lazily and in a
+        // single batched pass each frame. Existing transforms are migrated. Disabled by default.
+        void setFlatTransformHierarchy(bool enabled);
+        bool flatTransformHierarchy() const;
+        // Return the flat transform hierarchy (or nullptr if not enabled)
+        std::shared_ptr<TransformHierarchy> transformHierarchy();
     private:
+        friend class Transform;
+        friend class ComponentRenderable;
         Scene(const std::string & name);
         Scene(const Scene& scene) = delete;
         void componentListener(std::shared_ptr<Component> component, ComponentUpdateStatus status);
         void addLight(std::shared_ptr<Light> light);
-        std::vector<std::unique_ptr<GameObject>> mGameObjects;
-        std::map<GameObject*,EventListener<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>>> mComponentListeners;
-        std::vector<std::shared_ptr<Camera>> mCameras;
-        std::vector<std::shared_ptr<Updatable>> mUpdatable;
+        // pools for gameobjects and components (declared before the gameobjects, which must be destroyed first)
+        std::shared_ptr<PoolAllocators> mAllocators;
+        // gameobjects are removed using swap and pop (GameObject::mSceneIndex is the position)
+        std::vector<std::unique_ptr<GameObject, GameObjectDeleter>> mGameObjects;
+        struct GameObjectSlot {
+            GameObject *gameObject = nullptr;
+            uint32_t generation = 1;
+            EventListener<std::pair<std::shared_ptr<Component>, ComponentUpdateStatus>> componentListener;
+        };
+        // handle index -> slot. Free slots are reused with an incremented generation
+        std::vector<GameObjectSlot> mGameObjectSlots;
+        std::vector<uint32_t> mFreeGameObjectSlots;
+        std::unordered_map<int32_t, uint32_t> mGameObjectSlotByUID;
+        std::vector<std::unique_ptr<ComponentRegistryBase>> mRegistries; // indexed by component type id
+        struct UpdatableEntry {
+            Updatable *updatable;
+            Component *component;
+        };
+        struct UpdatePhaseEntries {
+            std::vector<UpdatableEntry> parallel;
+            std::vector<UpdatableEntry> serial;
+        };
+        void updatePhase(UpdatePhaseEntries &entries);
+        void removeUpdatable(Updatable *updatable);
+        UpdatePhaseEntries mUpdatables[3]; // indexed by UpdatePhase
+        bool mUpdating = false;
+        bool mUpdatableRemoved = false;
         std::unordered_map<std::shared_ptr<Light>, EventListener<std::shared_ptr<Light>>> mLights;
         SceneLights mSceneLights;
         std::string mName = "";
@@ -124,6 +210,26 @@ namespace kick {
         int32_t mUniqueIdGenerator = 0;
 
         void rebuildSceneLights();
+
+        // spatial index of the renderables in the scene (bounds are updated lazily before queries)
+        void transformChanged(Transform *transform);
+        void renderableChanged(ComponentRenderable *renderable);
+        void addRenderable(ComponentRenderable *renderable);
+        void removeRenderable(ComponentRenderable *renderable);
+        void updateSpatialIndex();
+        DynamicAABBTree mSpatialIndex;
+        std::vector<ComponentRenderable*> mUnboundedRenderables;
+        std::vector<ComponentRenderable*> mDirtyRenderables;
+        std::vector<Transform*> mDirtyTransforms;
+        // transforms changed by parallel updatables, per job system thread (merged after the parallel update)
+        std::vector<std::vector<Transform*>> mThreadDirtyTransforms;
+        bool mParallelUpdating = false;
+        std::vector<Transform*> mTransformStack; // scratch
+        std::shared_ptr<TransformHierarchy> mTransformHierarchy;
+        // incremented whenever a (non-flat) transform in the scene changes. A transform validated in the current
+        // epoch is up to date without checking its parents, so reading all transforms of a hierarchy is linear in
+        // the depth (see Transform::updateGlobal())
+        std::atomic<uint32_t> mTransformChangeEpoch{1};
     };
 };
 
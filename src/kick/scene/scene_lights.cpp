@@ -13,6 +13,7 @@
 #include "kick/scene/light.h"
 #include "kick/scene/game_object.h"
 #include "kick/scene/transform.h"
+#include "kick/scene/engine_uniform_blocks.h"
 
 #include "glm/gtx/quaternion.hpp"
 
@@ -56,6 +57,7 @@ namespace kick {
         for (;i<KICK_MAX_POINT_LIGHTS;i++){
             pointLightData[i] = mat3(0);
         }
+        EngineUniformBlocks::updateLights(*this);
     }
 
     void SceneLights::clear() {
@@ -0,0 +1,1538 @@
+//
+//  scene_serializer.cpp
+//  KickCPP
+//
+
+#include "kick/scene/scene_serializer.h"
+#include "kick/scene/scene.h"
+#include "kick/scene/game_object.h"
+#include "kick/scene/transform.h"
+#include "kick/scene/mesh_renderer.h"
+#include "kick/mesh/mesh.h"
+#include "kick/scene/light.h"
+#include "kick/scene/camera_perspective.h"
+#include "kick/scene/camera_orthographic.h"
+#include "kick/scene/line_renderer.h"
+#include "kick/2d/canvas.h"
+#include "kick/2d/sprite.h"
+#include "kick/2d/label.h"
+#include "kick/core/project.h"
+#include "kick/core/debug.h"
+#include "kick/core/job_system.h"
+#include "rapidjson/document.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+#define KICK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+namespace kick {
+    namespace {
+        const uint32_t none = 0xffffffff;
+
+        enum class SceneComponentType : uint32_t {
+            MeshRenderer,
+            Light,
+            CameraPerspective,
+            CameraOrthographic,
+            LineRenderer,
+            Canvas,
+            Sprite,
+            Label,
+            Count
+        };
+
+        // All records contain 4 byte fields only and all offsets are 4 byte aligned
+        struct SceneFileHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t fileSize;
+            uint32_t gameObjectCount, gameObjectOffset;
+            uint32_t componentCount, componentOffset;
+            uint32_t stringCount, stringOffset;         // offsets of the strings in the string data
+            uint32_t stringDataSize, stringDataOffset;  // null terminated strings
+            uint32_t dataSize, dataOffset;              // component parameters
+        };
+
+        struct SceneFileGameObject {
+            uint32_t name;
+            int32_t parent; // index of the parent (stored before the children) or -1
+            int32_t layer;
+            uint32_t firstComponent;
+            uint32_t componentCount;
+            float position[3];
+            float rotation[4]; // x, y, z, w
+            float scale[3];
+        };
+
+        struct SceneFileComponent {
+            uint32_t type;
+            uint32_t enabled;
+            uint32_t offset; // offset of the parameters in the data section
+            uint32_t size;
+        };
+
+        // Component parameters. String fields are indices in the string table (or none)
+
+        struct SceneFileMeshRenderer {
+            uint32_t mesh;
+            uint32_t materialCount; // followed by the material names
+        };
+
+        struct SceneFileLight {
+            uint32_t lightType;
+            uint32_t shadowType;
+            float color[3];
+            float intensity;
+            float attenuation[3];
+        };
+
+        struct SceneFileCamera {
+            float near, far;
+            float fieldOfViewY;            // perspective
+            float left, right, bottom, top; // orthographic
+            float clearColor[4];
+            uint32_t clearColorBuffer, clearDepthBuffer, clearStencilBuffer;
+            int32_t cullingMask;
+            int32_t index;
+            uint32_t main;
+            uint32_t shadow;
+            float viewportOffset[2];
+            float viewportDim[2];
+        };
+
+        struct SceneFileLineRenderer {
+            uint32_t meshType;
+            uint32_t material;
+            uint32_t smoothLine;
+            uint32_t pointCount; // followed by the points (3 floats each)
+            uint32_t indexCount; // followed by the indices (uint32)
+        };
+
+        struct SceneFileCanvas {
+            int32_t camera; // index of the gameobject of the camera or -1
+        };
+
+        struct SceneFileSprite {
+            uint32_t textureAtlas;
+            uint32_t spriteName;
+            uint32_t type;
+            int32_t order;
+            float sliceX[2], sliceY[2];
+            float anchor[2];
+            float scale[2];
+            float color[4];
+        };
+
+        struct SceneFileLabel {
+            uint32_t font;
+            uint32_t text;
+            uint32_t material;
+            int32_t order;
+            float anchor[2];
+        };
+
+        // Schema used by the JSON export (the variable sized tails are handled separately)
+        enum class FieldType {
+            UInt,
+            Int,
+            Float,
+            String
+        };
+
+        struct Field {
+            const char *name;
+            FieldType type;
+            size_t offset;
+            int count;
+        };
+
+        struct ComponentSchema {
+            const char *name;
+            size_t size;
+            vector<Field> fields;
+        };
+
+#define KICK_FIELD(T, field, type, count) Field{#field, FieldType::type, offsetof(T, field), count}
+
+        const vector<ComponentSchema> &componentSchemas(){
+            // indexed by SceneComponentType
+            static const vector<ComponentSchema> schemas = [](){
+                // both camera types store the same parameters
+                vector<Field> cameraFields {
+                    KICK_FIELD(SceneFileCamera, near, Float, 1),
+                    KICK_FIELD(SceneFileCamera, far, Float, 1),
+                    KICK_FIELD(SceneFileCamera, fieldOfViewY, Float, 1),
+                    KICK_FIELD(SceneFileCamera, left, Float, 1),
+                    KICK_FIELD(SceneFileCamera, right, Float, 1),
+                    KICK_FIELD(SceneFileCamera, bottom, Float, 1),
+                    KICK_FIELD(SceneFileCamera, top, Float, 1),
+                    KICK_FIELD(SceneFileCamera, clearColor, Float, 4),
+                    KICK_FIELD(SceneFileCamera, clearColorBuffer, UInt, 1),
+                    KICK_FIELD(SceneFileCamera, clearDepthBuffer, UInt, 1),
+                    KICK_FIELD(SceneFileCamera, clearStencilBuffer, UInt, 1),
+                    KICK_FIELD(SceneFileCamera, cullingMask, Int, 1),
+                    KICK_FIELD(SceneFileCamera, index, Int, 1),
+                    KICK_FIELD(SceneFileCamera, main, UInt, 1),
+                    KICK_FIELD(SceneFileCamera, shadow, UInt, 1),
+                    KICK_FIELD(SceneFileCamera, viewportOffset, Float, 2),
+                    KICK_FIELD(SceneFileCamera, viewportDim, Float, 2)
+                };
+                return vector<ComponentSchema>{
+                    {"MeshRenderer", sizeof(SceneFileMeshRenderer), {
+                        KICK_FIELD(SceneFileMeshRenderer, mesh, String, 1)}},
+                    {"Light", sizeof(SceneFileLight), {
+                        KICK_FIELD(SceneFileLight, lightType, UInt, 1),
+                        KICK_FIELD(SceneFileLight, shadowType, UInt, 1),
+                        KICK_FIELD(SceneFileLight, color, Float, 3),
+                        KICK_FIELD(SceneFileLight, intensity, Float, 1),
+                        KICK_FIELD(SceneFileLight, attenuation, Float, 3)}},
+                    {"CameraPerspective", sizeof(SceneFileCamera), cameraFields},
+                    {"CameraOrthographic", sizeof(SceneFileCamera), cameraFields},
+                    {"LineRenderer", sizeof(SceneFileLineRenderer), {
+                        KICK_FIELD(SceneFileLineRenderer, meshType, UInt, 1),
+                        KICK_FIELD(SceneFileLineRenderer, material, String, 1),
+                        KICK_FIELD(SceneFileLineRenderer, smoothLine, UInt, 1)}},
+                    {"Canvas", sizeof(SceneFileCanvas), {
+                        KICK_FIELD(SceneFileCanvas, camera, Int, 1)}},
+                    {"Sprite", sizeof(SceneFileSprite), {
+                        KICK_FIELD(SceneFileSprite, textureAtlas, String, 1),
+                        KICK_FIELD(SceneFileSprite, spriteName, String, 1),
+                        KICK_FIELD(SceneFileSprite, type, UInt, 1),
+                        KICK_FIELD(SceneFileSprite, order, Int, 1),
+                        KICK_FIELD(SceneFileSprite, sliceX, Float, 2),
+                        KICK_FIELD(SceneFileSprite, sliceY, Float, 2),
+                        KICK_FIELD(SceneFileSprite, anchor, Float, 2),
+                        KICK_FIELD(SceneFileSprite, scale, Float, 2),
+                        KICK_FIELD(SceneFileSprite, color, Float, 4)}},
+                    {"Label", sizeof(SceneFileLabel), {
+                        KICK_FIELD(SceneFileLabel, font, String, 1),
+                        KICK_FIELD(SceneFileLabel, text, String, 1),
+                        KICK_FIELD(SceneFileLabel, material, String, 1),
+                        KICK_FIELD(SceneFileLabel, order, Int, 1),
+                        KICK_FIELD(SceneFileLabel, anchor, Float, 2)}}
+                };
+            }();
+            return schemas;
+        }
+
+#undef KICK_FIELD
+
+        uint32_t align4(size_t size){
+            return (uint32_t)((size + 3) & ~size_t(3));
+        }
+
+        void toFloats(float *dest, vec2 v){ dest[0] = v.x; dest[1] = v.y; }
+        void toFloats(float *dest, vec3 v){ for (int i = 0; i < 3; i++) dest[i] = v[i]; }
+        void toFloats(float *dest, vec4 v){ for (int i = 0; i < 4; i++) dest[i] = v[i]; }
+        vec2 toVec2(const float *v){ return vec2{v[0], v[1]}; }
+        vec3 toVec3(const float *v){ return vec3{v[0], v[1], v[2]}; }
+        vec4 toVec4(const float *v){ return vec4{v[0], v[1], v[2], v[3]}; }
+
+        // Builds a binary scene. Gameobjects and their components are added in order
+        class SceneFileWriter {
+        public:
+            uint32_t addString(const string &str){
+                auto pos = mStringIndex.find(str);
+                if (pos != mStringIndex.end()){
+                    return pos->second;
+                }
+                uint32_t index = (uint32_t)mStringOffsets.size();
+                mStringOffsets.push_back((uint32_t)mStringData.size());
+                mStringData.insert(mStringData.end(), str.begin(), str.end());
+                mStringData.push_back('\0');
+                mStringIndex[str] = index;
+                return index;
+            }
+
+            uint32_t addOptionalString(const string &str){
+                return str.empty() ? none : addString(str);
+            }
+
+            void addGameObject(const SceneFileGameObject &gameObject){
+                mGameObjects.push_back(gameObject);
+                mGameObjects.back().firstComponent = (uint32_t)mComponents.size();
+                mGameObjects.back().componentCount = 0;
+            }
+
+            // Add a component to the last gameobject. The parameters are followed by the tail
+            void addComponent(SceneComponentType type, bool enabled, const void *parameters, size_t size,
+                    const void *tail = nullptr, size_t tailSize = 0){
+                uint32_t offset = (uint32_t)mData.size();
+                const char *p = static_cast<const char*>(parameters);
+                mData.insert(mData.end(), p, p + size);
+                if (tailSize){
+                    const char *t = static_cast<const char*>(tail);
+                    mData.insert(mData.end(), t, t + tailSize);
+                }
+                mData.resize(align4(mData.size()), 0);
+                mComponents.push_back(SceneFileComponent{(uint32_t)type, enabled ? 1u : 0u, offset, (uint32_t)(size + tailSize)});
+                mGameObjects.back().componentCount++;
+            }
+
+            vector<char> finish(){
+                SceneFileHeader header;
+                memcpy(header.magic, "KSCN", 4);
+                header.version = SceneSerializer::version;
+                size_t offset = sizeof(SceneFileHeader);
+                auto section = [&](size_t size){
+                    uint32_t res = (uint32_t)offset;
+                    offset += align4(size);
+                    return res;
+                };
+                header.gameObjectCount = (uint32_t)mGameObjects.size();
+                header.gameObjectOffset = section(mGameObjects.size() * sizeof(SceneFileGameObject));
+                header.componentCount = (uint32_t)mComponents.size();
+                header.componentOffset = section(mComponents.size() * sizeof(SceneFileComponent));
+                header.stringCount = (uint32_t)mStringOffsets.size();
+                header.stringOffset = section(mStringOffsets.size() * sizeof(uint32_t));
+                header.stringDataSize = (uint32_t)mStringData.size();
+                header.stringDataOffset = section(mStringData.size());
+                header.dataSize = (uint32_t)mData.size();
+                header.dataOffset = section(mData.size());
+                header.fileSize = (uint32_t)offset;
+
+                vector<char> res(offset, 0);
+                memcpy(res.data(), &header, sizeof(header));
+                auto write = [&](uint32_t dest, const void *src, size_t size){
+                    if (size){
+                        memcpy(res.data() + dest, src, size);
+                    }
+                };
+                write(header.gameObjectOffset, mGameObjects.data(), mGameObjects.size() * sizeof(SceneFileGameObject));
+                write(header.componentOffset, mComponents.data(), mComponents.size() * sizeof(SceneFileComponent));
+                write(header.stringOffset, mStringOffsets.data(), mStringOffsets.size() * sizeof(uint32_t));
+                write(header.stringDataOffset, mStringData.data(), mStringData.size());
+                write(header.dataOffset, mData.data(), mData.size());
+                return res;
+            }
+        private:
+            vector<SceneFileGameObject> mGameObjects;
+            vector<SceneFileComponent> mComponents;
+            vector<uint32_t> mStringOffsets;
+            vector<char> mStringData;
+            unordered_map<string, uint32_t> mStringIndex;
+            vector<char> mData;
+        };
+
+        // Validated view of a binary scene. The records are read in place
+        class SceneFileReader {
+        public:
+            bool open(const char *data, size_t size){
+                if (reinterpret_cast<uintptr_t>(data) % 4 != 0){
+                    // the records must be aligned
+                    mAlignedCopy.assign(data, data + size);
+                    data = mAlignedCopy.data();
+                }
+                mData = data;
+                if (size < sizeof(SceneFileHeader)){
+                    return false;
+                }
+                mHeader = reinterpret_cast<const SceneFileHeader*>(data);
+                const SceneFileHeader &h = *mHeader;
+                if (memcmp(h.magic, "KSCN", 4) != 0 || h.version != SceneSerializer::version || h.fileSize > size){
+                    return false;
+                }
+                auto inside = [&](uint32_t offset, uint64_t count, size_t elementSize){
+                    return offset % 4 == 0 && offset + count * elementSize <= h.fileSize;
+                };
+                if (!inside(h.gameObjectOffset, h.gameObjectCount, sizeof(SceneFileGameObject)) ||
+                        !inside(h.componentOffset, h.componentCount, sizeof(SceneFileComponent)) ||
+                        !inside(h.stringOffset, h.stringCount, sizeof(uint32_t)) ||
+                        !inside(h.stringDataOffset, h.stringDataSize, 1) ||
+                        !inside(h.dataOffset, h.dataSize, 1)){
+                    return false;
+                }
+                if (h.stringDataSize > 0 && data[h.stringDataOffset + h.stringDataSize - 1] != '\0'){
+                    return false;
+                }
+                for (uint32_t i = 0; i < h.stringCount; i++){
+                    if (stringOffsets()[i] >= h.stringDataSize){
+                        return false;
+                    }
+                }
+                for (uint32_t i = 0; i < h.gameObjectCount; i++){
+                    const SceneFileGameObject &g = gameObjects()[i];
+                    if (g.parent >= (int32_t)i || g.parent < -1 || !validString(g.name) ||
+                            (uint64_t)g.firstComponent + g.componentCount > h.componentCount){
+                        return false;
+                    }
+                }
+                for (uint32_t i = 0; i < h.componentCount; i++){
+                    if (!validComponent(components()[i])){
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const SceneFileHeader &header() const { return *mHeader; }
+
+            const SceneFileGameObject *gameObjects() const {
+                return reinterpret_cast<const SceneFileGameObject*>(mData + mHeader->gameObjectOffset);
+            }
+
+            const SceneFileComponent *components() const {
+                return reinterpret_cast<const SceneFileComponent*>(mData + mHeader->componentOffset);
+            }
+
+            // returns an empty string for none
+            const char *string(uint32_t index) const {
+                if (index == none){
+                    return "";
+                }
+                return mData + mHeader->stringDataOffset + stringOffsets()[index];
+            }
+
+            template <typename T>
+            const T &parameters(const SceneFileComponent &component) const {
+                return *reinterpret_cast<const T*>(mData + mHeader->dataOffset + component.offset);
+            }
+
+            // the variable sized data following the parameters
+            const char *tail(const SceneFileComponent &component) const {
+                return mData + mHeader->dataOffset + component.offset + componentSchemas()[component.type].size;
+            }
+        private:
+            const uint32_t *stringOffsets() const {
+                return reinterpret_cast<const uint32_t*>(mData + mHeader->stringOffset);
+            }
+
+            bool validString(uint32_t index) const {
+                return index == none || index < mHeader->stringCount;
+            }
+
+            bool validComponent(const SceneFileComponent &c) const {
+                if (c.type >= (uint32_t)SceneComponentType::Count || c.offset % 4 != 0 ||
+                        (uint64_t)c.offset + c.size > mHeader->dataSize){
+                    return false;
+                }
+                const ComponentSchema &schema = componentSchemas()[c.type];
+                if (c.size < schema.size){
+                    return false;
+                }
+                const char *p = mData + mHeader->dataOffset + c.offset;
+                for (auto & field : schema.fields){
+                    if (field.type == FieldType::String && !validString(*reinterpret_cast<const uint32_t*>(p + field.offset))){
+                        return false;
+                    }
+                }
+                size_t tailSize = c.size - schema.size;
+                switch ((SceneComponentType)c.type){
+                    case SceneComponentType::MeshRenderer: {
+                        auto &m = parameters<SceneFileMeshRenderer>(c);
+                        if (tailSize != (uint64_t)m.materialCount * sizeof(uint32_t)){
+                            return false;
+                        }
+                        auto materials = reinterpret_cast<const uint32_t*>(tail(c));
+                        for (uint32_t i = 0; i < m.materialCount; i++){
+                            if (!validString(materials[i])){
+                                return false;
+                            }
+                        }
+                        return true;
+                    }
+                    case SceneComponentType::LineRenderer: {
+                        auto &l = parameters<SceneFileLineRenderer>(c);
+                        if (l.meshType != (uint32_t)MeshType::Lines && l.meshType != (uint32_t)MeshType::LineLoop &&
+                                l.meshType != (uint32_t)MeshType::LineStrip){
+                            return false;
+                        }
+                        if (tailSize != (uint64_t)l.pointCount * sizeof(float) * 3 + (uint64_t)l.indexCount * sizeof(uint32_t)){
+                            return false;
+                        }
+                        auto indices = reinterpret_cast<const uint32_t*>(tail(c) + l.pointCount * 3 * sizeof(float));
+                        for (uint32_t i = 0; i < l.indexCount; i++){
+                            if (indices[i] >= l.pointCount){
+                                return false;
+                            }
+                        }
+                        return true;
+                    }
+                    case SceneComponentType::Light: {
+                        auto &l = parameters<SceneFileLight>(c);
+                        return tailSize == 0 && l.lightType <= (uint32_t)LightType::Spot && l.shadowType <= (uint32_t)ShadowType::Soft;
+                    }
+                    case SceneComponentType::Canvas: {
+                        auto &canvas = parameters<SceneFileCanvas>(c);
+                        return tailSize == 0 && canvas.camera >= -1 && canvas.camera < (int64_t)mHeader->gameObjectCount;
+                    }
+                    case SceneComponentType::Sprite:
+                        return tailSize == 0 && parameters<SceneFileSprite>(c).type <= (uint32_t)SpriteType::Sliced;
+                    default:
+                        return tailSize == 0;
+                }
+            }
+
+            const char *mData = nullptr;
+            const SceneFileHeader *mHeader = nullptr;
+            vector<char> mAlignedCopy;
+        };
+
+        // Read only view of a file. Memory mapped if supported
+        class MappedFile {
+        public:
+            ~MappedFile(){
+#ifdef KICK_MMAP
+                if (mMapped){
+                    munmap(mMapped, mSize);
+                }
+#endif
+            }
+
+            bool open(const std::string &filename){
+#ifdef KICK_MMAP
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if (fd >= 0){
+                    struct stat st;
+                    if (fstat(fd, &st) == 0 && st.st_size > 0){
+                        void *mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (mapped != MAP_FAILED){
+                            mMapped = mapped;
+                            mSize = (size_t)st.st_size;
+                        }
+                    }
+                    close(fd);
+                    if (mMapped){
+                        return true;
+                    }
+                }
+#endif
+                if (!Project::loadBinaryResource(filename, mBuffer)){
+                    return false;
+                }
+                mSize = mBuffer.size();
+                return true;
+            }
+
+            const char *data() const {
+                return mMapped ? static_cast<const char*>(mMapped) : mBuffer.data();
+            }
+
+            size_t size() const { return mSize; }
+        private:
+            void *mMapped = nullptr;
+            size_t mSize = 0;
+            vector<char> mBuffer;
+        };
+
+        // Writes floats with enough digits to be restored exactly (the rapidjson writer uses %g). Non-finite floats
+        // are not valid JSON numbers and are written as the strings "NaN", "Infinity" and "-Infinity"
+        class JsonWriter : public rapidjson::PrettyWriter<rapidjson::StringBuffer> {
+        public:
+            JsonWriter(rapidjson::StringBuffer &buffer) : rapidjson::PrettyWriter<rapidjson::StringBuffer>(buffer) {}
+
+            void Float(float f){
+                if (std::isnan(f)){
+                    String("NaN");
+                    return;
+                }
+                if (std::isinf(f)){
+                    String(f > 0 ? "Infinity" : "-Infinity");
+                    return;
+                }
+                PrettyPrefix(rapidjson::kNumberType);
+                char buffer[32];
+                int length = snprintf(buffer, sizeof(buffer), "%.9g", f);
+                for (int i = 0; i < length; i++){
+                    stream_.Put(buffer[i]);
+                }
+            }
+
+            void FloatArray(const float *values, int count){
+                StartArray();
+                for (int i = 0; i < count; i++){
+                    Float(values[i]);
+                }
+                EndArray();
+            }
+        };
+
+        void writeFields(JsonWriter &writer, const SceneFileReader &reader, const ComponentSchema &schema, const char *parameters){
+            for (auto & field : schema.fields){
+                writer.String(field.name);
+                const char *p = parameters + field.offset;
+                switch (field.type){
+                    case FieldType::UInt:
+                        writer.Uint(*reinterpret_cast<const uint32_t*>(p));
+                        break;
+                    case FieldType::Int:
+                        writer.Int(*reinterpret_cast<const int32_t*>(p));
+                        break;
+                    case FieldType::Float:
+                        if (field.count == 1){
+                            writer.Float(*reinterpret_cast<const float*>(p));
+                        } else {
+                            writer.FloatArray(reinterpret_cast<const float*>(p), field.count);
+                        }
+                        break;
+                    case FieldType::String: {
+                        uint32_t index = *reinterpret_cast<const uint32_t*>(p);
+                        if (index == none){
+                            writer.Null();
+                        } else {
+                            writer.String(reader.string(index));
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        // reads a number or a non-finite float written by JsonWriter::Float()
+        bool readFloat(const rapidjson::Value &value, float &dest){
+            if (value.IsNumber()){
+                dest = (float)value.GetDouble();
+                return true;
+            }
+            if (!value.IsString()){
+                return false;
+            }
+            if (strcmp(value.GetString(), "NaN") == 0){
+                dest = std::numeric_limits<float>::quiet_NaN();
+            } else if (strcmp(value.GetString(), "Infinity") == 0){
+                dest = std::numeric_limits<float>::infinity();
+            } else if (strcmp(value.GetString(), "-Infinity") == 0){
+                dest = -std::numeric_limits<float>::infinity();
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        bool readFloats(const rapidjson::Value &value, float *dest, int count){
+            if (count == 1){
+                return readFloat(value, *dest);
+            }
+            if (!value.IsArray() || value.Size() != (rapidjson::SizeType)count){
+                return false;
+            }
+            for (int i = 0; i < count; i++){
+                if (!readFloat(value[(rapidjson::SizeType)i], dest[i])){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool readString(SceneFileWriter &writer, const rapidjson::Value &value, uint32_t &dest){
+            if (value.IsNull()){
+                dest = none;
+                return true;
+            }
+            if (!value.IsString()){
+                return false;
+            }
+            dest = writer.addString(value.GetString());
+            return true;
+        }
+
+        bool readFields(SceneFileWriter &writer, const rapidjson::Value &json, const ComponentSchema &schema, char *parameters){
+            for (auto & field : schema.fields){
+                if (!json.HasMember(field.name)){
+                    return false;
+                }
+                const rapidjson::Value &value = json[field.name];
+                char *p = parameters + field.offset;
+                switch (field.type){
+                    case FieldType::UInt:
+                        if (!value.IsUint()){
+                            return false;
+                        }
+                        *reinterpret_cast<uint32_t*>(p) = value.GetUint();
+                        break;
+                    case FieldType::Int:
+                        if (!value.IsInt()){
+                            return false;
+                        }
+                        *reinterpret_cast<int32_t*>(p) = value.GetInt();
+                        break;
+                    case FieldType::Float:
+                        if (!readFloats(value, reinterpret_cast<float*>(p), field.count)){
+                            return false;
+                        }
+                        break;
+                    case FieldType::String:
+                        if (!readString(writer, value, *reinterpret_cast<uint32_t*>(p))){
+                            return false;
+                        }
+                        break;
+                }
+            }
+            return true;
+        }
+
+        // Add the supported components of the gameobject to the writer
+        void saveComponents(SceneFileWriter &writer, GameObject *gameObject, const SceneAssets &assets,
+                const unordered_map<GameObject*, int32_t> &gameObjectIndex){
+            auto materialName = [&](Material *material){
+                return assets.materialName && material ? assets.materialName(material) : string{};
+            };
+            for (auto & component : *gameObject){
+                bool enabled = component->enabled();
+                if (auto meshRenderer = dynamic_pointer_cast<MeshRenderer>(component)){
+                    SceneFileMeshRenderer p;
+                    auto mesh = meshRenderer->mesh();
+                    p.mesh = writer.addOptionalString(assets.meshName && mesh ? assets.meshName(mesh.get()) : string{});
+                    vector<uint32_t> materials;
+                    for (auto material : meshRenderer->materials()){
+                        materials.push_back(writer.addOptionalString(materialName(material)));
+                    }
+                    p.materialCount = (uint32_t)materials.size();
+                    writer.addComponent(SceneComponentType::MeshRenderer, enabled, &p, sizeof(p), materials.data(), materials.size() * sizeof(uint32_t));
+                } else if (auto light = dynamic_pointer_cast<Light>(component)){
+                    SceneFileLight p;
+                    p.lightType = (uint32_t)light->lightType();
+                    p.shadowType = (uint32_t)light->shadowType();
+                    toFloats(p.color, light->color());
+                    p.intensity = light->intensity();
+                    toFloats(p.attenuation, light->attenuation());
+                    writer.addComponent(SceneComponentType::Light, enabled, &p, sizeof(p));
+                } else if (auto camera = dynamic_pointer_cast<Camera>(component)){
+                    auto perspective = dynamic_pointer_cast<CameraPerspective>(camera);
+                    auto orthographic = dynamic_pointer_cast<CameraOrthographic>(camera);
+                    if (!perspective && !orthographic){
+                        continue;
+                    }
+                    SceneFileCamera p;
+                    memset(&p, 0, sizeof(p));
+                    if (perspective){
+                        p.near = perspective->near();
+                        p.far = perspective->far();
+                        p.fieldOfViewY = perspective->fieldOfViewY();
+                    } else {
+                        p.near = orthographic->near();
+                        p.far = orthographic->far();
+                        p.left = orthographic->left();
+                        p.right = orthographic->right();
+                        p.bottom = orthographic->bottom();
+                        p.top = orthographic->top();
+                    }
+                    toFloats(p.clearColor, camera->clearColor());
+                    p.clearColorBuffer = camera->clearColorBuffer();
+                    p.clearDepthBuffer = camera->clearDepthBuffer();
+                    p.clearStencilBuffer = camera->clearStencilBuffer();
+                    p.cullingMask = camera->cullingMask();
+                    p.index = camera->index();
+                    p.main = camera->main();
+                    p.shadow = camera->shadow();
+                    toFloats(p.viewportOffset, camera->viewportOffset());
+                    toFloats(p.viewportDim, camera->viewportDim());
+                    writer.addComponent(perspective ? SceneComponentType::CameraPerspective : SceneComponentType::CameraOrthographic, enabled, &p, sizeof(p));
+                } else if (auto lineRenderer = dynamic_pointer_cast<LineRenderer>(component)){
+                    SceneFileLineRenderer p;
+                    p.meshType = (uint32_t)lineRenderer->meshType();
+                    p.material = writer.addOptionalString(materialName(lineRenderer->material()));
+                    p.smoothLine = lineRenderer->smoothLine();
+                    p.pointCount = (uint32_t)lineRenderer->points().size();
+                    p.indexCount = (uint32_t)lineRenderer->indices().size();
+                    vector<char> tail(p.pointCount * 3 * sizeof(float) + p.indexCount * sizeof(uint32_t));
+                    if (!tail.empty()){
+                        memcpy(tail.data(), lineRenderer->points().data(), p.pointCount * 3 * sizeof(float));
+                        memcpy(tail.data() + p.pointCount * 3 * sizeof(float), lineRenderer->indices().data(), p.indexCount * sizeof(uint32_t));
+                    }
+                    writer.addComponent(SceneComponentType::LineRenderer, enabled, &p, sizeof(p), tail.data(), tail.size());
+                } else if (auto canvas = dynamic_pointer_cast<Canvas>(component)){
+                    SceneFileCanvas p;
+                    p.camera = -1;
+                    if (canvas->camera()){
+                        auto pos = gameObjectIndex.find(canvas->camera()->gameObject());
+                        if (pos != gameObjectIndex.end()){
+                            p.camera = pos->second;
+                        }
+                    }
+                    writer.addComponent(SceneComponentType::Canvas, enabled, &p, sizeof(p));
+                } else if (auto sprite = dynamic_pointer_cast<Sprite>(component)){
+                    SceneFileSprite p;
+                    auto textureAtlas = sprite->textureAtlas();
+                    p.textureAtlas = writer.addOptionalString(assets.textureAtlasName && textureAtlas ? assets.textureAtlasName(textureAtlas.get()) : string{});
+                    p.spriteName = writer.addOptionalString(sprite->spriteName());
+                    p.type = (uint32_t)sprite->type();
+                    p.order = sprite->order();
+                    toFloats(p.sliceX, sprite->sliceX());
+                    toFloats(p.sliceY, sprite->sliceY());
+                    toFloats(p.anchor, sprite->anchor());
+                    toFloats(p.scale, sprite->scale());
+                    toFloats(p.color, sprite->color());
+                    writer.addComponent(SceneComponentType::Sprite, enabled, &p, sizeof(p));
+                } else if (auto label = dynamic_pointer_cast<Label>(component)){
+                    SceneFileLabel p;
+                    auto font = label->font();
+                    p.font = writer.addOptionalString(assets.fontName && font ? assets.fontName(font.get()) : string{});
+                    p.text = writer.addOptionalString(label->text());
+                    p.material = writer.addOptionalString(materialName(label->material()));
+                    p.order = label->order();
+                    toFloats(p.anchor, label->anchor());
+                    writer.addComponent(SceneComponentType::Label, enabled, &p, sizeof(p));
+                }
+            }
+        }
+
+        enum class AssetType { Mesh, Material, TextureAtlas, Font };
+
+        // Creates the gameobjects and components of a validated scene in small steps, so the work can be spread
+        // over several frames. The assets are resolved first, one asset per step (since loading an asset may
+        // upload it to the GPU) and each name only once. Then each step creates one gameobject and finally each
+        // step adds the components of one gameobject (2D components are added last, since they need the canvas
+        // of their parent). The constructor does not access the scene, so it may run on a worker thread.
+        class SceneInstantiator {
+        public:
+            SceneInstantiator(Scene *scene, const SceneFileReader &reader, const SceneAssets &assets)
+            : mScene(scene), mReader(reader), mAssets(assets), mCount(reader.header().gameObjectCount)
+            {
+                uint32_t stringCount = reader.header().stringCount;
+                mMeshes.resize(stringCount);
+                mMaterials.resize(stringCount);
+                mTextureAtlases.resize(stringCount);
+                mFonts.resize(stringCount);
+                vector<bool> requested(stringCount * 4, false);
+                auto request = [&](AssetType type, uint32_t name){
+                    if (name != none && !requested[name * 4 + (int)type]){
+                        requested[name * 4 + (int)type] = true;
+                        mAssetRequests.push_back(make_pair(type, name));
+                    }
+                };
+                for (uint32_t i = 0; i < reader.header().componentCount; i++){
+                    const SceneFileComponent &c = reader.components()[i];
+                    switch ((SceneComponentType)c.type){
+                        case SceneComponentType::MeshRenderer: {
+                            auto &p = reader.parameters<SceneFileMeshRenderer>(c);
+                            request(AssetType::Mesh, p.mesh);
+                            auto names = reinterpret_cast<const uint32_t*>(reader.tail(c));
+                            for (uint32_t j = 0; j < p.materialCount; j++){
+                                request(AssetType::Material, names[j]);
+                            }
+                            break;
+                        }
+                        case SceneComponentType::LineRenderer:
+                            request(AssetType::Material, reader.parameters<SceneFileLineRenderer>(c).material);
+                            break;
+                        case SceneComponentType::Sprite:
+                            request(AssetType::TextureAtlas, reader.parameters<SceneFileSprite>(c).textureAtlas);
+                            break;
+                        case SceneComponentType::Label: {
+                            auto &p = reader.parameters<SceneFileLabel>(c);
+                            request(AssetType::Font, p.font);
+                            request(AssetType::Material, p.material);
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            size_t stepCount() const {
+                return mAssetRequests.size() + 3 * mCount;
+            }
+
+            size_t step() const {
+                return mStep;
+            }
+
+            bool done() const {
+                return mStep == stepCount();
+            }
+
+            void next(){
+                assert(!done());
+                size_t step = mStep++;
+                if (step < mAssetRequests.size()){
+                    loadAsset(mAssetRequests[step].first, mAssetRequests[step].second);
+                    return;
+                }
+                step -= mAssetRequests.size();
+                if (step < mCount){
+                    createGameObject((uint32_t)step);
+                } else if (step < 2 * mCount){
+                    loadComponents((uint32_t)(step - mCount), false);
+                } else {
+                    loadComponents((uint32_t)(step - 2 * mCount), true);
+                }
+            }
+
+            // the gameobjects created so far and not destroyed since
+            vector<GameObject*> created() const {
+                vector<GameObject*> res;
+                for (auto handle : mCreated){
+                    if (GameObject *gameObject = mScene->gameObject(handle)){
+                        res.push_back(gameObject);
+                    }
+                }
+                return res;
+            }
+        private:
+            void loadAsset(AssetType type, uint32_t name){
+                const char *s = mReader.string(name);
+                switch (type){
+                    case AssetType::Mesh:
+                        if (mAssets.loadMesh){
+                            mMeshes[name] = mAssets.loadMesh(s);
+                        }
+                        break;
+                    case AssetType::Material:
+                        if (mAssets.loadMaterial){
+                            mMaterials[name] = mAssets.loadMaterial(s);
+                        }
+                        break;
+                    case AssetType::TextureAtlas:
+                        if (mAssets.loadTextureAtlas){
+                            mTextureAtlases[name] = mAssets.loadTextureAtlas(s);
+                        }
+                        break;
+                    case AssetType::Font:
+                        if (mAssets.loadFont){
+                            mFonts[name] = mAssets.loadFont(s);
+                        }
+                        break;
+                }
+            }
+
+            void createGameObject(uint32_t i){
+                if (i == 0){
+                    mScene->reserveGameObjects(mCount);
+                    mCreated.reserve(mCount);
+                }
+                const SceneFileGameObject &g = mReader.gameObjects()[i];
+                GameObject *parent = g.parent >= 0 ? mScene->gameObject(mCreated[g.parent]) : nullptr;
+                if (g.parent >= 0 && !parent){
+                    // the parent was destroyed while loading, so the subtree is skipped
+                    mCreated.push_back(GameObjectHandle{});
+                    return;
+                }
+                GameObject *gameObject = mScene->createGameObject(mReader.string(g.name));
+                gameObject->setLayer(g.layer);
+                auto transform = gameObject->transform();
+                transform->setLocalPosition(toVec3(g.position));
+                transform->setLocalRotation(quat{g.rotation[3], g.rotation[0], g.rotation[1], g.rotation[2]});
+                transform->setLocalScale(toVec3(g.scale));
+                if (parent){
+                    transform->setParent(parent->transform());
+                }
+                mCreated.push_back(gameObject->handle());
+            }
+
+            void loadComponents(uint32_t i, bool components2D){
+                if (components2D && i == 0){
+                    resolveCanvasCameras();
+                }
+                const SceneFileGameObject &g = mReader.gameObjects()[i];
+                // gameobjects destroyed while loading are skipped
+                GameObject *gameObject = mScene->gameObject(mCreated[i]);
+                for (uint32_t j = 0; j < g.componentCount && gameObject; j++){
+                    const SceneFileComponent &c = mReader.components()[g.firstComponent + j];
+                    bool is2D = c.type == (uint32_t)SceneComponentType::Sprite || c.type == (uint32_t)SceneComponentType::Label;
+                    if (is2D == components2D){
+                        loadComponent(c, gameObject, components2D ? mCanvases[i] : nullptr);
+                    }
+                }
+                if (!components2D){
+                    // the canvas of each gameobject is the canvas of its nearest ancestor (parents are loaded first)
+                    mCanvases.push_back(gameObject ? gameObject->component<Canvas>() : nullptr);
+                    if (!mCanvases[i] && g.parent >= 0){
+                        mCanvases[i] = mCanvases[g.parent];
+                    }
+                }
+            }
+
+            // all non 2D components exist at this point
+            void resolveCanvasCameras(){
+                for (auto & canvasCamera : mCanvasCameras){
+                    GameObject *gameObject = canvasCamera.second < (int32_t)mCreated.size() ?
+                            mScene->gameObject(mCreated[canvasCamera.second]) : nullptr;
+                    if (gameObject){
+                        auto camera = gameObject->component<Camera>();
+                        if (camera){
+                            canvasCamera.first->setCamera(camera);
+                        }
+                    }
+                }
+                mCanvasCameras.clear();
+            }
+
+            Material *material(uint32_t name) const {
+                return name != none ? mMaterials[name] : nullptr;
+            }
+
+            void loadComponent(const SceneFileComponent &c, GameObject *gameObject, shared_ptr<Canvas> canvas){
+                shared_ptr<Component> component;
+                switch ((SceneComponentType)c.type){
+                    case SceneComponentType::MeshRenderer: {
+                        auto &p = mReader.parameters<SceneFileMeshRenderer>(c);
+                        auto meshRenderer = gameObject->addComponent<MeshRenderer>();
+                        if (p.mesh != none && mMeshes[p.mesh]){
+                            meshRenderer->setMesh(mMeshes[p.mesh]);
+                        }
+                        auto names = reinterpret_cast<const uint32_t*>(mReader.tail(c));
+                        vector<Material*> materials;
+                        for (uint32_t i = 0; i < p.materialCount; i++){
+                            Material *m = material(names[i]);
+                            if (m){
+                                materials.push_back(m);
+                            }
+                        }
+                        if (!materials.empty()){
+                            meshRenderer->setMaterials(materials);
+                        }
+                        component = meshRenderer;
+                        break;
+                    }
+                    case SceneComponentType::Light: {
+                        auto &p = mReader.parameters<SceneFileLight>(c);
+                        auto light = gameObject->addComponent<Light>();
+                        light->setColor(toVec3(p.color));
+                        light->setIntensity(p.intensity);
+                        light->setAttenuation(toVec3(p.attenuation));
+                        light->setShadowType((ShadowType)p.shadowType);
+                        light->setLightType((LightType)p.lightType);
+                        component = light;
+                        break;
+                    }
+                    case SceneComponentType::CameraPerspective:
+                    case SceneComponentType::CameraOrthographic: {
+                        auto &p = mReader.parameters<SceneFileCamera>(c);
+                        shared_ptr<Camera> camera;
+                        if ((SceneComponentType)c.type == SceneComponentType::CameraPerspective){
+                            auto perspective = gameObject->addComponent<CameraPerspective>();
+                            perspective->set(p.near, p.far, p.fieldOfViewY);
+                            camera = perspective;
+                        } else {
+                            auto orthographic = gameObject->addComponent<CameraOrthographic>();
+                            orthographic->set(p.near, p.far, p.left, p.right, p.bottom, p.top);
+                            camera = orthographic;
+                        }
+                        camera->setClearColor(toVec4(p.clearColor));
+                        camera->setClearColorBuffer(p.clearColorBuffer != 0);
+                        camera->setClearDepthBuffer(p.clearDepthBuffer != 0);
+                        camera->setClearStencilBuffer(p.clearStencilBuffer != 0);
+                        camera->setCullingMask(p.cullingMask);
+                        camera->setIndex(p.index);
+                        camera->setMain(p.main != 0);
+                        camera->setShadow(p.shadow != 0);
+                        camera->setViewportOffset(toVec2(p.viewportOffset));
+                        camera->setViewportDim(toVec2(p.viewportDim));
+                        component = camera;
+                        break;
+                    }
+                    case SceneComponentType::LineRenderer: {
+                        auto &p = mReader.parameters<SceneFileLineRenderer>(c);
+                        auto lineRenderer = gameObject->addComponent<LineRenderer>();
+                        const char *tail = mReader.tail(c);
+                        vector<vec3> points(p.pointCount);
+                        vector<GLuint> indices(p.indexCount);
+                        for (uint32_t i = 0; i < p.pointCount; i++){
+                            points[i] = toVec3(reinterpret_cast<const float*>(tail) + i * 3);
+                        }
+                        if (p.indexCount){
+                            memcpy(&indices[0], tail + p.pointCount * 3 * sizeof(float), p.indexCount * sizeof(uint32_t));
+                        }
+                        lineRenderer->setSmoothLine(p.smoothLine != 0);
+                        if (Material *m = material(p.material)){
+                            lineRenderer->setMaterial(m);
+                        }
+                        lineRenderer->setPoints(points, (MeshType)p.meshType, indices);
+                        component = lineRenderer;
+                        break;
+                    }
+                    case SceneComponentType::Canvas: {
+                        auto &p = mReader.parameters<SceneFileCanvas>(c);
+                        auto canvas = gameObject->addComponent<Canvas>();
+                        if (p.camera >= 0){
+                            // the camera may be stored after the canvas, so it is resolved before the 2D components
+                            mCanvasCameras.push_back(make_pair(canvas, p.camera));
+                        }
+                        component = canvas;
+                        break;
+                    }
+                    case SceneComponentType::Sprite:
+                    case SceneComponentType::Label: {
+                        if (!canvas){
+                            logWarning(string{"No canvas found for "}+gameObject->name());
+                            return;
+                        }
+                        if ((SceneComponentType)c.type == SceneComponentType::Sprite){
+                            auto &p = mReader.parameters<SceneFileSprite>(c);
+                            auto sprite = canvas->addComponentTo<Sprite>(gameObject);
+                            if (p.textureAtlas != none && mTextureAtlases[p.textureAtlas]){
+                                sprite->setTextureAtlas(mTextureAtlases[p.textureAtlas]);
+                            }
+                            sprite->setSpriteName(mReader.string(p.spriteName));
+                            sprite->setType((SpriteType)p.type);
+                            sprite->setSliceX(toVec2(p.sliceX));
+                            sprite->setSliceY(toVec2(p.sliceY));
+                            sprite->setAnchor(toVec2(p.anchor));
+                            sprite->setScale(toVec2(p.scale));
+                            sprite->setColor(toVec4(p.color));
+                            sprite->setOrder(p.order);
+                            component = sprite;
+                        } else {
+                            auto &p = mReader.parameters<SceneFileLabel>(c);
+                            auto label = canvas->addComponentTo<Label>(gameObject);
+                            if (p.font != none && mFonts[p.font]){
+                                label->setFont(mFonts[p.font]);
+                            }
+                            if (Material *m = material(p.material)){
+                                label->setMaterial(m);
+                            }
+                            label->setText(mReader.string(p.text));
+                            label->setAnchor(toVec2(p.anchor));
+                            label->setOrder(p.order);
+                            component = label;
+                        }
+                        break;
+                    }
+                    default:
+                        return;
+                }
+                if (!c.enabled){
+                    component->setEnabled(false);
+                }
+            }
+
+            Scene *mScene;
+            const SceneFileReader &mReader;
+            const SceneAssets &mAssets;
+            size_t mCount;
+            size_t mStep = 0;
+            vector<pair<AssetType, uint32_t>> mAssetRequests;
+            // resolved assets indexed by name
+            vector<shared_ptr<Mesh>> mMeshes;
+            vector<Material*> mMaterials;
+            vector<shared_ptr<TextureAtlas>> mTextureAtlases;
+            vector<shared_ptr<Font>> mFonts;
+            // handles of the created gameobjects (null if skipped), since game code may destroy them while loading
+            vector<GameObjectHandle> mCreated;
+            vector<shared_ptr<Canvas>> mCanvases;
+            // canvases and the index of the gameobject of their camera
+            vector<pair<shared_ptr<Canvas>, int32_t>> mCanvasCameras;
+        };
+    }
+
+    SceneAssets::SceneAssets()
+    : meshName([](Mesh *mesh){ return mesh->name(); }),
+      loadTextureAtlas([](const string &name){ return Project::loadTextureAtlas(name); }),
+      loadFont([](const string &name){ return Project::loadFont(name); })
+    {
+    }
+
+    std::vector<char> SceneSerializer::save(Scene *scene, const SceneAssets &assets) {
+        vector<GameObject*> roots;
+        for (auto & gameObject : *scene){
+            if (!gameObject->transform()->parent()){
+                roots.push_back(gameObject.get());
+            }
+        }
+        return save(roots, assets);
+    }
+
+    std::vector<char> SceneSerializer::save(const std::vector<GameObject*> &roots, const SceneAssets &assets) {
+        // store the gameobjects depth first, so parents are stored before their children
+        vector<GameObject*> gameObjects;
+        vector<Transform*> stack;
+        for (auto root : roots){
+            stack.push_back(root->transform().get());
+            while (!stack.empty()){
+                Transform *transform = stack.back();
+                stack.pop_back();
+                gameObjects.push_back(transform->gameObject());
+                size_t first = stack.size();
+                for (auto & child : *transform){
+                    stack.push_back(child.get());
+                }
+                reverse(stack.begin() + first, stack.end());
+            }
+        }
+        unordered_map<GameObject*, int32_t> gameObjectIndex;
+        for (size_t i = 0; i < gameObjects.size(); i++){
+            gameObjectIndex[gameObjects[i]] = (int32_t)i;
+        }
+
+        SceneFileWriter writer;
+        for (auto gameObject : gameObjects){
+            auto transform = gameObject->transform();
+            SceneFileGameObject g;
+            g.name = writer.addString(gameObject->name());
+            g.parent = -1;
+            if (transform->parent()){
+                auto pos = gameObjectIndex.find(transform->parent()->gameObject());
+                if (pos != gameObjectIndex.end()){
+                    g.parent = pos->second;
+                }
+            }
+            g.layer = gameObject->layer();
+            toFloats(g.position, transform->localPosition());
+            quat rotation = transform->localRotation();
+            g.rotation[0] = rotation.x;
+            g.rotation[1] = rotation.y;
+            g.rotation[2] = rotation.z;
+            g.rotation[3] = rotation.w;
+            toFloats(g.scale, transform->localScale());
+            writer.addGameObject(g);
+            saveComponents(writer, gameObject, assets, gameObjectIndex);
+        }
+        return writer.finish();
+    }
+
+    bool SceneSerializer::saveToFile(Scene *scene, const std::string &filename, const SceneAssets &assets) {
+        vector<char> data = save(scene, assets);
+        ofstream file(filename, ios::out | ios::binary);
+        if (!file.is_open() || !file.write(data.data(), data.size())){
+            logError(string{"failed to write "}+filename);
+            return false;
+        }
+        return true;
+    }
+
+    bool SceneSerializer::load(Scene *scene, const char *data, size_t size, const SceneAssets &assets,
+            std::vector<GameObject*> *createdGameObjects) {
+        SceneFileReader reader;
+        if (!reader.open(data, size)){
+            logError("Invalid scene data");
+            return false;
+        }
+        SceneInstantiator instantiator{scene, reader, assets};
+        while (!instantiator.done()){
+            instantiator.next();
+        }
+        vector<GameObject*> created = instantiator.created();
+        if (createdGameObjects){
+            createdGameObjects->insert(createdGameObjects->end(), created.begin(), created.end());
+        }
+        return true;
+    }
+
+    bool SceneSerializer::loadFromFile(Scene *scene, const std::string &filename, const SceneAssets &assets,
+            std::vector<GameObject*> *createdGameObjects) {
+        MappedFile file;
+        if (!file.open(filename)){
+            return false;
+        }
+        return load(scene, file.data(), file.size(), assets, createdGameObjects);
+    }
+
+    std::string SceneSerializer::toJson(const char *data, size_t size) {
+        SceneFileReader reader;
+        if (!reader.open(data, size)){
+            logError("Invalid scene data");
+            return "";
+        }
+        rapidjson::StringBuffer buffer;
+        JsonWriter writer(buffer);
+        writer.StartObject();
+        writer.String("version");
+        writer.Uint(reader.header().version);
+        writer.String("gameObjects");
+        writer.StartArray();
+        for (uint32_t i = 0; i < reader.header().gameObjectCount; i++){
+            const SceneFileGameObject &g = reader.gameObjects()[i];
+            writer.StartObject();
+            writer.String("name");
+            writer.String(reader.string(g.name));
+            writer.String("parent");
+            writer.Int(g.parent);
+            writer.String("layer");
+            writer.Int(g.layer);
+            writer.String("position");
+            writer.FloatArray(g.position, 3);
+            writer.String("rotation");
+            writer.FloatArray(g.rotation, 4);
+            writer.String("scale");
+            writer.FloatArray(g.scale, 3);
+            writer.String("components");
+            writer.StartArray();
+            for (uint32_t j = 0; j < g.componentCount; j++){
+                const SceneFileComponent &c = reader.components()[g.firstComponent + j];
+                const ComponentSchema &schema = componentSchemas()[c.type];
+                writer.StartObject();
+                writer.String("type");
+                writer.String(schema.name);
+                writer.String("enabled");
+                writer.Bool(c.enabled != 0);
+                writeFields(writer, reader, schema, &reader.parameters<char>(c));
+                if (c.type == (uint32_t)SceneComponentType::MeshRenderer){
+                    auto &p = reader.parameters<SceneFileMeshRenderer>(c);
+                    auto names = reinterpret_cast<const uint32_t*>(reader.tail(c));
+                    writer.String("materials");
+                    writer.StartArray();
+                    for (uint32_t k = 0; k < p.materialCount; k++){
+                        if (names[k] == none){
+                            writer.Null();
+                        } else {
+                            writer.String(reader.string(names[k]));
+                        }
+                    }
+                    writer.EndArray();
+                } else if (c.type == (uint32_t)SceneComponentType::LineRenderer){
+                    auto &p = reader.parameters<SceneFileLineRenderer>(c);
+                    writer.String("points");
+                    writer.FloatArray(reinterpret_cast<const float*>(reader.tail(c)), p.pointCount * 3);
+                    auto indices = reinterpret_cast<const uint32_t*>(reader.tail(c) + p.pointCount * 3 * sizeof(float));
+                    writer.String("indices");
+                    writer.StartArray();
+                    for (uint32_t k = 0; k < p.indexCount; k++){
+                        writer.Uint(indices[k]);
+                    }
+                    writer.EndArray();
+                }
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+        return buffer.GetString();
+    }
+
+    bool SceneSerializer::fromJson(const std::string &json, std::vector<char> &outData) {
+        using namespace rapidjson;
+        Document document;
+        if (document.Parse<0>(json.c_str()).HasParseError() || !document.IsObject() ||
+                !document.HasMember("version") || !document["version"].IsUint() || document["version"].GetUint() != version ||
+                !document.HasMember("gameObjects") || !document["gameObjects"].IsArray()){
+            logError("Invalid scene json");
+            return false;
+        }
+        auto invalid = [](const string &message){
+            logError(string{"Invalid scene json: "}+message);
+            return false;
+        };
+        SceneFileWriter writer;
+        const Value &gameObjects = document["gameObjects"];
+        for (SizeType i = 0; i < gameObjects.Size(); i++){
+            const Value &g = gameObjects[i];
+            SceneFileGameObject record;
+            if (!g.IsObject() || !g.HasMember("name") || !g["name"].IsString() || !g.HasMember("parent") || !g["parent"].IsInt() ||
+                    !g.HasMember("layer") || !g["layer"].IsInt() || !g.HasMember("position") || !g.HasMember("rotation") ||
+                    !g.HasMember("scale") || !g.HasMember("components") || !g["components"].IsArray() ||
+                    !readFloats(g["position"], record.position, 3) || !readFloats(g["rotation"], record.rotation, 4) ||
+                    !readFloats(g["scale"], record.scale, 3)){
+                return invalid("gameobject "+std::to_string(i));
+            }
+            record.name = writer.addString(g["name"].GetString());
+            record.parent = g["parent"].GetInt();
+            record.layer = g["layer"].GetInt();
+            writer.addGameObject(record);
+            const Value &components = g["components"];
+            for (SizeType j = 0; j < components.Size(); j++){
+                const Value &c = components[j];
+                if (!c.IsObject() || !c.HasMember("type") || !c["type"].IsString() || !c.HasMember("enabled") || !c["enabled"].IsBool()){
+                    return invalid("component of gameobject "+std::to_string(i));
+                }
+                string typeName = c["type"].GetString();
+                auto &schemas = componentSchemas();
+                auto schema = find_if(schemas.begin(), schemas.end(), [&](const ComponentSchema &s){ return typeName == s.name; });
+                if (schema == schemas.end()){
+                    return invalid("unknown component type "+typeName);
+                }
+                SceneComponentType type = (SceneComponentType)(schema - schemas.begin());
+                vector<char> parameters(schema->size, 0);
+                vector<char> tail;
+                if (!readFields(writer, c, *schema, parameters.data())){
+                    return invalid(typeName+" of gameobject "+std::to_string(i));
+                }
+                if (type == SceneComponentType::MeshRenderer){
+                    if (!c.HasMember("materials") || !c["materials"].IsArray()){
+                        return invalid(typeName+" materials");
+                    }
+                    const Value &materials = c["materials"];
+                    vector<uint32_t> names(materials.Size());
+                    for (SizeType k = 0; k < materials.Size(); k++){
+                        if (!readString(writer, materials[k], names[k])){
+                            return invalid(typeName+" materials");
+                        }
+                    }
+                    reinterpret_cast<SceneFileMeshRenderer*>(parameters.data())->materialCount = (uint32_t)names.size();
+                    tail.resize(names.size() * sizeof(uint32_t));
+                    if (!names.empty()){
+                        memcpy(tail.data(), names.data(), tail.size());
+                    }
+                } else if (type == SceneComponentType::LineRenderer){
+                    if (!c.HasMember("points") || !c["points"].IsArray() || c["points"].Size() % 3 != 0 ||
+                            !c.HasMember("indices") || !c["indices"].IsArray()){
+                        return invalid(typeName+" points");
+                    }
+                    const Value &points = c["points"];
+                    const Value &indices = c["indices"];
+                    auto p = reinterpret_cast<SceneFileLineRenderer*>(parameters.data());
+                    p->pointCount = points.Size() / 3;
+                    p->indexCount = indices.Size();
+                    vector<float> pointValues(points.Size());
+                    if (!pointValues.empty() && !readFloats(points, pointValues.data(), (int)pointValues.size())){
+                        return invalid(typeName+" points");
+                    }
+                    vector<uint32_t> indexValues(indices.Size());
+                    for (SizeType k = 0; k < indices.Size(); k++){
+                        if (!indices[k].IsUint()){
+                            return invalid(typeName+" indices");
+                        }
+                        indexValues[k] = indices[k].GetUint();
+                    }
+                    tail.resize(pointValues.size() * sizeof(float) + indexValues.size() * sizeof(uint32_t));
+                    if (!tail.empty()){
+                        memcpy(tail.data(), pointValues.data(), pointValues.size() * sizeof(float));
+                        memcpy(tail.data() + pointValues.size() * sizeof(float), indexValues.data(), indexValues.size() * sizeof(uint32_t));
+                    }
+                }
+                writer.addComponent(type, c["enabled"].GetBool(), parameters.data(), parameters.size(), tail.data(), tail.size());
+            }
+        }
+        outData = writer.finish();
+        // validates the parent indices, the string references and the enum values
+        SceneFileReader reader;
+        if (!reader.open(outData.data(), outData.size())){
+            return invalid("invalid values or references");
+        }
+        return true;
+    }
+
+    struct SceneLoadOperation::Data {
+        Scene *scene;
+        SceneAssets assets;
+        JobSystem *jobSystem;
+        string filename;
+        vector<char> buffer;
+        MappedFile file;
+        SceneFileReader reader;
+        unique_ptr<SceneInstantiator> instantiator;
+        shared_ptr<Job> readJob;
+        atomic<bool> valid{false};  // set by the read job
+        State state = State::Reading;
+
+        // invoked on a worker thread
+        void read(){
+            const char *data = buffer.data();
+            size_t size = buffer.size();
+            if (!filename.empty()){
+                if (!file.open(filename)){
+                    return;
+                }
+                data = file.data();
+                size = file.size();
+            }
+            if (reader.open(data, size)){
+                instantiator.reset(new SceneInstantiator(scene, reader, assets));
+                valid = true;
+            }
+        }
+    };
+
+    SceneLoadOperation::SceneLoadOperation(Scene *scene, const std::string &filename, JobSystem *jobSystem, const SceneAssets &assets)
+    : mData(make_shared<Data>())
+    {
+        mData->scene = scene;
+        mData->assets = assets;
+        mData->jobSystem = jobSystem;
+        mData->filename = filename;
+        startReading();
+    }
+
+    SceneLoadOperation::SceneLoadOperation(Scene *scene, std::vector<char> &&data, JobSystem *jobSystem, const SceneAssets &assets)
+    : mData(make_shared<Data>())
+    {
+        mData->scene = scene;
+        mData->assets = assets;
+        mData->jobSystem = jobSystem;
+        mData->buffer = move(data);
+        startReading();
+    }
+
+    SceneLoadOperation::~SceneLoadOperation() {
+    }
+
+    void SceneLoadOperation::startReading() {
+        // the job only holds a weak reference, so the operation may be destroyed while reading
+        weak_ptr<Data> weakData = mData;
+        mData->readJob = mData->jobSystem->createJob([weakData]{
+            if (auto data = weakData.lock()){
+                data->read();
+            }
+        });
+        mData->jobSystem->run(mData->readJob);
+    }
+
+    bool SceneLoadOperation::update(float budgetMilliseconds) {
+        Data &data = *mData;
+        if (data.state == State::Reading){
+            if (!data.readJob->completed()){
+                if (data.jobSystem->workerThreadCount() > 0){
+                    return false;
+                }
+                // without worker threads jobs are only executed when waited for
+                data.jobSystem->wait(data.readJob);
+            }
+            data.readJob.reset();
+            if (!data.valid){
+                logError(data.filename.empty() ? string{"Invalid scene data"} : string{"Cannot load scene "}+data.filename);
+                data.state = State::Failed;
+                completed.notifyListeners(this);
+                return true;
+            }
+            data.state = State::Instantiating;
+        }
+        if (data.state != State::Instantiating){
+            return true;
+        }
+        auto start = chrono::steady_clock::now();
+        auto budget = chrono::duration<float, milli>(budgetMilliseconds);
+        while (!data.instantiator->done()){
+            data.instantiator->next();
+            if (chrono::steady_clock::now() - start >= budget){
+                break;
+            }
+        }
+        if (data.instantiator->done()){
+            data.state = State::Completed;
+            completed.notifyListeners(this);
+            return true;
+        }
+        return false;
+    }
+
+    SceneLoadOperation::State SceneLoadOperation::state() const {
+        return mData->state;
+    }
+
+    bool SceneLoadOperation::done() const {
+        return mData->state == State::Completed || mData->state == State::Failed;
+    }
+
+    float SceneLoadOperation::progress() const {
+        switch (mData->state){
+            case State::Reading:
+                return 0;
+            case State::Instantiating: {
+                auto &instantiator = *mData->instantiator;
+                return instantiator.step() / (float)instantiator.stepCount();
+            }
+            default:
+                return 1;
+        }
+    }
+
+    Scene *SceneLoadOperation::scene() const {
+        return mData->scene;
+    }
+
+    std::vector<GameObject*> SceneLoadOperation::gameObjects() const {
+        return mData->state != State::Reading && mData->instantiator ? mData->instantiator->created() : vector<GameObject*>{};
+    }
+}
@@ -0,0 +1,106 @@
+//
+//  scene_serializer.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "kick/core/event.h"
+
+namespace kick {
+    class Scene;
+    class GameObject;
+    class Mesh;
+    class Material;
+    class TextureAtlas;
+    class Font;
+    class JobSystem;
+
+    /// Maps the assets referenced by components to names when saving and names to assets when loading.
+    /// References to assets without a name (or names which cannot be resolved) are not restored.
+    struct SceneAssets {
+        SceneAssets();
+
+        std::function<std::string(Mesh*)> meshName;                                   // default Mesh::name()
+        std::function<std::shared_ptr<Mesh>(const std::string&)> loadMesh;            // default none
+        std::function<std::string(Material*)> materialName;                           // default none
+        std::function<Material*(const std::string&)> loadMaterial;                    // default none
+        std::function<std::string(TextureAtlas*)> textureAtlasName;                   // default none
+        std::function<std::shared_ptr<TextureAtlas>(const std::string&)> loadTextureAtlas; // default Project::loadTextureAtlas
+        std::function<std::string(Font*)> fontName;                                   // default none
+        std::function<std::shared_ptr<Font>(const std::string&)> loadFont;            // default Project::loadFont
+    };
+
+    /// Binary scene format. The file is a header followed by fixed size records referenced by offsets:
+    /// gameobjects (parents are stored before their children), components, a string table and the component
+    /// parameters. The records are read in place from the file (which is memory mapped when loaded from a file)
+    /// and the gameobjects are allocated in bulk. The format uses the native byte order (little endian).
+    /// Components stored are MeshRenderer, Light, CameraPerspective, CameraOrthographic, LineRenderer, Canvas,
+    /// Sprite and Label. Other components are skipped.
+    class SceneSerializer {
+    public:
+        static const uint32_t version = 2;
+
+        static std::vector<char> save(Scene *scene, const SceneAssets &assets = SceneAssets{});
+        /// Save the gameobjects and their children
+        static std::vector<char> save(const std::vector<GameObject*> &roots, const SceneAssets &assets = SceneAssets{});
+        static bool saveToFile(Scene *scene, const std::string &filename, const SceneAssets &assets = SceneAssets{});
+
+        /// Add the gameobjects of the binary scene to the scene. The created gameobjects are appended to
+        /// createdGameObjects (if not nullptr). Returns false if the data is not a valid scene.
+        static bool load(Scene *scene, const char *data, size_t size, const SceneAssets &assets = SceneAssets{},
+                std::vector<GameObject*> *createdGameObjects = nullptr);
+        static bool loadFromFile(Scene *scene, const std::string &filename, const SceneAssets &assets = SceneAssets{},
+                std::vector<GameObject*> *createdGameObjects = nullptr);
+
+        /// Debug export of a binary scene as JSON using the same schema. Returns an empty string if not valid.
+        static std::string toJson(const char *data, size_t size);
+        /// Convert the JSON export back to the binary format. Returns false if the JSON is not valid.
+        static bool fromJson(const std::string &json, std::vector<char> &outData);
+    };
+
+    /// Asynchronous additive load of a binary scene (usually started using Engine::loadSceneAsync). The file is
+    /// read and validated on a worker thread. The assets are then resolved and the gameobjects are created in the
+    /// target scene on the main thread in small steps, limited by a time budget per update() call. The target scene
+    /// must not be destroyed while loading.
+    class SceneLoadOperation {
+    public:
+        enum class State {
+            Reading,        // reading and validating the data on a worker thread
+            Instantiating,  // creating the gameobjects (the created gameobjects are already in the scene)
+            Completed,
+            Failed
+        };
+
+        SceneLoadOperation(Scene *scene, const std::string &filename, JobSystem *jobSystem, const SceneAssets &assets = SceneAssets{});
+        SceneLoadOperation(Scene *scene, std::vector<char> &&data, JobSystem *jobSystem, const SceneAssets &assets = SceneAssets{});
+        ~SceneLoadOperation();
+
+        /// Continue the load for about budgetMilliseconds. Each call does at least one step, once the data has been
+        /// read. Must be called from the main thread. Returns true when completed or failed
+        bool update(float budgetMilliseconds);
+
+        State state() const;
+        bool done() const;
+        /// The fraction of instantiation steps done [0;1]
+        float progress() const;
+        Scene *scene() const;
+        /// The gameobjects created so far (parents before their children). Gameobjects destroyed by game code while
+        /// loading are left out, and the remaining components and children of a destroyed gameobject are skipped.
+        std::vector<GameObject*> gameObjects() const;
+
+        /// Notified on the main thread when the load is completed or failed
+        Event<SceneLoadOperation*> completed;
+    private:
+        SceneLoadOperation(const SceneLoadOperation&) = delete;
+        struct Data;
+        void startReading();
+        std::shared_ptr<Data> mData;
+    };
+}
@@ -0,0 +1,332 @@
+//
+//  static_batch.cpp
+//  KickCPP
+//
+
+#include "kick/scene/static_batch.h"
+#include "kick/scene/mesh_renderer.h"
+#include "kick/scene/scene.h"
+#include "kick/scene/transform.h"
+#include "kick/scene/render_queue.h"
+#include "kick/mesh/mesh.h"
+#include "kick/material/material.h"
+#include "kick/core/debug.h"
+#include <glm/gtc/matrix_inverse.hpp>
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+using namespace std;
+
+namespace kick {
+
+    namespace {
+        enum AttributeBits {
+            NormalBit = 1,
+            TexCoord0Bit = 2,
+            TexCoord1Bit = 4,
+            TangentBit = 8,
+            ColorBit = 16
+        };
+
+        int attributeMask(MeshData *meshData){
+            size_t count = meshData->position().size();
+            int res = 0;
+            if (meshData->normal().size() == count) res |= NormalBit;
+            if (meshData->texCoord0().size() == count) res |= TexCoord0Bit;
+            if (meshData->texCoord1().size() == count) res |= TexCoord1Bit;
+            if (meshData->tangent().size() == count) res |= TangentBit;
+            if (meshData->color().size() == count) res |= ColorBit;
+            return res;
+        }
+
+        // vertex data of the merged mesh
+        struct MergedMesh {
+            vector<glm::vec3> position;
+            vector<glm::vec3> normal;
+            vector<glm::vec2> texCoord0;
+            vector<glm::vec2> texCoord1;
+            vector<glm::vec3> tangent;
+            vector<glm::vec4> color;
+            vector<GLuint> indices;
+
+            // appends the vertices of the mesh transformed by matrix
+            void append(MeshData *meshData, int mask, const glm::mat4 &matrix){
+                size_t offset = position.size();
+                glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(matrix));
+                for (auto & p : meshData->position()){
+                    position.push_back(glm::vec3(matrix * glm::vec4(p, 1)));
+                }
+                if (mask & NormalBit){
+                    for (auto & n : meshData->normal()){
+                        normal.push_back(glm::normalize(normalMatrix * n));
+                    }
+                }
+                if (mask & TexCoord0Bit){
+                    texCoord0.insert(texCoord0.end(), meshData->texCoord0().begin(), meshData->texCoord0().end());
+                }
+                if (mask & TexCoord1Bit){
+                    texCoord1.insert(texCoord1.end(), meshData->texCoord1().begin(), meshData->texCoord1().end());
+                }
+                if (mask & TangentBit){
+                    for (auto & t : meshData->tangent()){
+                        tangent.push_back(glm::normalize(glm::mat3(matrix) * t));
+                    }
+                }
+                if (mask & ColorBit){
+                    color.insert(color.end(), meshData->color().begin(), meshData->color().end());
+                }
+                auto & submeshIndices = meshData->submeshIndices(0);
+                size_t first = indices.size();
+                if (submeshIndices.empty()){
+                    // the submesh draws all vertices sequentially
+                    for (size_t i = 0; i < meshData->position().size(); i++){
+                        indices.push_back((GLuint)(offset + i));
+                    }
+                } else {
+                    for (auto index : submeshIndices){
+                        indices.push_back((GLuint)(offset + index));
+                    }
+                }
+                // mirroring transforms reverse the winding order
+                if (glm::determinant(glm::mat3(matrix)) < 0){
+                    for (size_t i = first; i + 2 < indices.size(); i += 3){
+                        swap(indices[i + 1], indices[i + 2]);
+                    }
+                }
+            }
+
+            shared_ptr<MeshData> meshData(int mask){
+                auto res = make_shared<MeshData>();
+                res->setPosition(position);
+                if (mask & NormalBit) res->setNormal(normal);
+                if (mask & TexCoord0Bit) res->setTexCoord0(texCoord0);
+                if (mask & TexCoord1Bit) res->setTexCoord1(texCoord1);
+                if (mask & TangentBit) res->setTangent(tangent);
+                if (mask & ColorBit) res->setColor(color);
+                res->setSubmesh(0, indices, MeshType::Triangles);
+                res->recomputeBounds();
+                return res;
+            }
+        };
+
+        bool batchable(MeshRenderer *renderer, int maxVertices){
+            if (!renderer->enabled() || renderer->staticBatch() || renderer->materials().size() != 1){
+                return false;
+            }
+            auto material = renderer->material();
+            auto mesh = renderer->mesh();
+            if (!material || !mesh || !mesh->meshData() || RenderQueue::transparent(material->renderOrder())){
+                return false;
+            }
+            auto meshData = mesh->meshData();
+            return meshData->submeshesCount() > 0 && meshData->submeshType(0) == MeshType::Triangles &&
+                    meshData->position().size() > 0 && (int)meshData->position().size() <= maxVertices;
+        }
+    }
+
+    StaticBatch::StaticBatch(GameObject *gameObject)
+    :ComponentRenderable(gameObject), mMesh(make_shared<Mesh>())
+    {
+    }
+
+    StaticBatch::~StaticBatch() {
+        releaseRenderers();
+    }
+
+    void StaticBatch::deactivated() {
+        releaseRenderers();
+    }
+
+    void StaticBatch::releaseRenderers() {
+        for (auto & renderer : mRenderers){
+            renderer->mStaticBatch = nullptr;
+            renderer->mStaticBatchSlot = -1;
+        }
+        mRenderers.clear();
+        mGlobalVersions.clear();
+        mIndexRanges.clear();
+        mDirty = true;
+    }
+
+    void StaticBatch::render(EngineUniforms *engineUniforms, Material *replacementMaterial) {
+        if (!enabled()){
+            return;
+        }
+        if (mDirty){
+            rebuild();
+        }
+        if (mRenderers.empty()){
+            return;
+        }
+        auto material = replacementMaterial ? replacementMaterial : mMaterial;
+        auto shader = material->shader().get();
+        mMesh->bind(shader);
+        shader->bind_uniforms(material, engineUniforms, transform().get());
+        mMesh->render(0);
+    }
+
+    int StaticBatch::renderOrder() {
+        return mMaterial ? mMaterial->renderOrder() : 0;
+    }
+
+    Material *StaticBatch::sortMaterial() {
+        return mMaterial;
+    }
+
+    Mesh *StaticBatch::sortMesh() {
+        return mMesh.get();
+    }
+
+    Bounds3 StaticBatch::localBounds() {
+        if (mMesh->meshData() == nullptr){
+            return Bounds3{};
+        }
+        return mMesh->meshData()->bounds();
+    }
+
+    Material *StaticBatch::material() {
+        return mMaterial;
+    }
+
+    std::shared_ptr<Mesh> StaticBatch::mesh() {
+        return mMesh;
+    }
+
+    const std::vector<std::shared_ptr<MeshRenderer>> &StaticBatch::renderers() const {
+        return mRenderers;
+    }
+
+    void StaticBatch::evict(ComponentRenderable *renderer) {
+        if (renderer->mStaticBatch != this){
+            return;
+        }
+        size_t slot = (size_t)renderer->mStaticBatchSlot;
+        IndexRange range = mIndexRanges[slot];
+        renderer->mStaticBatch = nullptr;
+        renderer->mStaticBatchSlot = -1;
+        // swap and pop (each renderer has its own index range, so the order does not matter)
+        if (slot != mRenderers.size() - 1){
+            mRenderers[slot] = move(mRenderers.back());
+            mGlobalVersions[slot] = mGlobalVersions.back();
+            mIndexRanges[slot] = mIndexRanges.back();
+            mRenderers[slot]->mStaticBatchSlot = (int)slot;
+        }
+        mRenderers.pop_back();
+        mGlobalVersions.pop_back();
+        mIndexRanges.pop_back();
+        if (mDirty){
+            // merged again when rendered
+            return;
+        }
+        mEvictedIndexCount += range.count;
+        if (mRenderers.empty() || mEvictedIndexCount * 2 > mIndexCount){
+            mDirty = true;
+        } else {
+            // the bounds are kept until the batch is merged again, since they only shrink
+            mMesh->degenerateIndices(0, range.first, range.count);
+        }
+    }
+
+    void StaticBatch::transformChanged(ComponentRenderable *renderer) {
+        if (renderer->mStaticBatch == this &&
+                renderer->transform()->globalVersion() != mGlobalVersions[renderer->mStaticBatchSlot]){
+            evict(renderer);
+        }
+    }
+
+    void StaticBatch::add(std::shared_ptr<MeshRenderer> renderer) {
+        renderer->mStaticBatch = this;
+        renderer->mStaticBatchSlot = (int)mRenderers.size();
+        mRenderers.push_back(renderer);
+        mGlobalVersions.push_back(renderer->transform()->globalVersion());
+        mIndexRanges.push_back(IndexRange{});
+        mDirty = true;
+    }
+
+    void StaticBatch::rebuild() {
+        if (mRenderers.empty()){
+            mDirty = false;
+            mMesh->setMeshData(nullptr);
+            markBoundsDirty();
+            return;
+        }
+        // renderers whose mesh no longer matches the batch are evicted
+        int mask = attributeMask(mRenderers[0]->mesh()->meshData().get());
+        for (size_t i = mRenderers.size(); i > 0; i--){
+            auto meshData = mRenderers[i - 1]->mesh()->meshData();
+            if (attributeMask(meshData.get()) != mask || meshData->submeshType(0) != MeshType::Triangles){
+                evict(mRenderers[i - 1].get());
+            }
+        }
+        mDirty = false;
+        MergedMesh merged;
+        for (size_t i = 0; i < mRenderers.size(); i++){
+            auto & renderer = mRenderers[i];
+            mIndexRanges[i].first = (GLsizei)merged.indices.size();
+            merged.append(renderer->mesh()->meshData().get(), mask, renderer->transform()->globalMatrix());
+            mIndexRanges[i].count = (GLsizei)merged.indices.size() - mIndexRanges[i].first;
+        }
+        mIndexCount = (GLsizei)merged.indices.size();
+        mEvictedIndexCount = 0;
+        mMesh->setMeshData(merged.meshData(mask));
+        markBoundsDirty();
+    }
+
+    std::vector<std::shared_ptr<StaticBatch>> StaticBatcher::combine(Scene *scene, int maxVertices) {
+        vector<GameObject*> gameObjects;
+        for (auto & gameObject : *scene){
+            if (gameObject->isStatic()){
+                gameObjects.push_back(gameObject.get());
+            }
+        }
+        return combine(scene, gameObjects, maxVertices);
+    }
+
+    std::vector<std::shared_ptr<StaticBatch>> StaticBatcher::combine(Scene *scene, const std::vector<GameObject *> &gameObjects,
+            int maxVertices) {
+        // group the renderers by material, layer and vertex attributes (in scene order)
+        typedef tuple<Material*, int, int> GroupKey;
+        map<GroupKey, size_t> groupIndex;
+        vector<vector<shared_ptr<MeshRenderer>>> groups;
+        vector<int> groupLayers;
+        for (auto gameObject : gameObjects){
+            for (auto & renderer : gameObject->components<MeshRenderer>()){
+                if (!batchable(renderer.get(), maxVertices)){
+                    continue;
+                }
+                GroupKey key{renderer->material(), gameObject->layer(), attributeMask(renderer->mesh()->meshData().get())};
+                auto pos = groupIndex.find(key);
+                if (pos == groupIndex.end()){
+                    pos = groupIndex.emplace(key, groups.size()).first;
+                    groups.emplace_back();
+                    groupLayers.push_back(gameObject->layer());
+                }
+                groups[pos->second].push_back(renderer);
+            }
+        }
+
+        vector<shared_ptr<StaticBatch>> res;
+        for (size_t i = 0; i < groups.size(); i++){
+            shared_ptr<StaticBatch> batch;
+            int vertexCount = 0;
+            for (auto & renderer : groups[i]){
+                int rendererVertices = (int)renderer->mesh()->meshData()->position().size();
+                if (!batch || vertexCount + rendererVertices > maxVertices){
+                    auto gameObject = scene->createGameObject("StaticBatch");
+                    gameObject->setLayer(groupLayers[i]);
+                    batch = gameObject->addComponent<StaticBatch>();
+                    batch->mMaterial = renderer->material();
+                    res.push_back(batch);
+                    vertexCount = 0;
+                }
+                batch->add(renderer);
+                vertexCount += rendererVertices;
+            }
+        }
+        for (auto & batch : res){
+            batch->rebuild();
+        }
+        return res;
+    }
+}
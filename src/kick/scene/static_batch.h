@@ -0,0 +1,79 @@
+//
+//  static_batch.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "kick/scene/component_renderable.h"
+#include "kick/mesh/mesh_data.h"
+
+namespace kick {
+    class MeshRenderer;
+    class Mesh;
+    class Material;
+    class Scene;
+
+    /// Renders the mesh renderers of static game objects (see GameObject::setStatic()) sharing a material as a single
+    /// mesh, with the vertices transformed into world space. The batched mesh renderers are not rendered (or culled)
+    /// while batched. A mesh renderer is evicted from the batch when its transform, material, mesh, mesh data or
+    /// layer changes, when it is disabled, when its game object is no longer static or when it is destroyed.
+    /// Eviction is O(1): the index range of the renderer is made degenerate in the element buffer. The remaining
+    /// renderers are only merged again (on the next render) when more than half of the indices are evicted.
+    /// Note that picking returns the game object of the batch.
+    class StaticBatch : public ComponentRenderable {
+    public:
+        StaticBatch(GameObject *gameObject);
+        ~StaticBatch();
+        virtual void deactivated() override;
+        virtual void render(EngineUniforms *engineUniforms, Material* replacementMaterial = nullptr) override;
+        virtual int renderOrder() override;
+        virtual Material *sortMaterial() override;
+        virtual Mesh *sortMesh() override;
+        virtual Bounds3 localBounds() override;
+
+        Material *material();
+        std::shared_ptr<Mesh> mesh();
+        const std::vector<std::shared_ptr<MeshRenderer>> &renderers() const;
+        // removes the renderer from the batch, so it is rendered by itself
+        void evict(ComponentRenderable *renderer);
+        // evicts the renderer if its global matrix has changed since it was batched
+        void transformChanged(ComponentRenderable *renderer);
+    private:
+        friend class StaticBatcher;
+        void add(std::shared_ptr<MeshRenderer> renderer);
+        void rebuild();
+        void releaseRenderers();
+        struct IndexRange {
+            GLsizei first = 0;
+            GLsizei count = 0;
+        };
+        // indexed by the slot of the renderer (ComponentRenderable::mStaticBatchSlot)
+        std::vector<std::shared_ptr<MeshRenderer>> mRenderers;
+        // the global version of the transform of each renderer when batched
+        std::vector<uint32_t> mGlobalVersions;
+        // the indices of each renderer in the merged mesh
+        std::vector<IndexRange> mIndexRanges;
+        GLsizei mIndexCount = 0;
+        GLsizei mEvictedIndexCount = 0;
+        std::shared_ptr<Mesh> mMesh;
+        Material *mMaterial = nullptr;
+        bool mDirty = true;
+    };
+
+    /// Merges static mesh renderers into StaticBatch renderables. Renderers are merged when they share material,
+    /// layer and vertex attributes. Each batch contains at most maxVertices vertices (mesh renderers are added to a
+    /// batch until it is full), and has its own bounds so the batches are frustum culled individually.
+    /// Only enabled mesh renderers with a single material, a triangle mesh and an opaque render order are batched.
+    class StaticBatcher {
+    public:
+        // largest batch drawn using 16 bit indices (larger batches use 32 bit indices)
+        static const int maxShortIndexedVertices = 65536;
+        // batches the static game objects of the scene
+        static std::vector<std::shared_ptr<StaticBatch>> combine(Scene *scene, int maxVertices = maxShortIndexedVertices);
+        static std::vector<std::shared_ptr<StaticBatch>> combine(Scene *scene, const std::vector<GameObject*> &gameObjects,
+                int maxVertices = maxShortIndexedVertices);
+    };
+}
@@ -8,25 +8,103 @@
 
 #include "kick/scene/transform.h"
 #include "kick/math/glm_ext.h"
+#include "kick/scene/scene.h"
+#include "kick/scene/transform_hierarchy.h"
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 
 using namespace glm;
 
 namespace kick {
+    namespace {
+        // the change epoch of transforms not in a scene
+        std::atomic<uint32_t> noSceneChangeEpoch{1};
+    }
+
     Transform::Transform(GameObject *gameObject)
     :Component(gameObject){
+        Scene *scene = gameObject ? gameObject->scene() : nullptr;
+        if (scene && scene->mTransformHierarchy){
+            setHierarchy(scene->mTransformHierarchy);
+        }
+    }
+
+    Transform::~Transform(){
+        if (mHierarchy){
+            mHierarchy->remove(mHierarchyIndex);
+        }
+    }
+
+    void Transform::setHierarchy(std::shared_ptr<TransformHierarchy> hierarchy){
+        if (mHierarchy){
+            mLocalPosition = mHierarchy->localPosition(mHierarchyIndex);
+            mLocalRotationQuat = mHierarchy->localRotation(mHierarchyIndex);
+            mLocalScale = mHierarchy->localScale(mHierarchyIndex);
+            mHierarchy->remove(mHierarchyIndex);
+            mHierarchyIndex = -1;
+        }
+        mHierarchy = hierarchy;
+        if (mHierarchy){
+            mHierarchyIndex = mHierarchy->add(this, mLocalPosition, mLocalRotationQuat, mLocalScale);
+        } else {
+            markLocalDirty();
+        }
     }
     
     void Transform::markGlobalDirty(){
-        mDirty.global = 1;
-        mDirty.globalInv = 1;
-        mDirty.globalPos = 1;
-        mDirty.globalRot = 1;
-        for (auto c : mChildren){
-            c->markGlobalDirty();
+        // children are not visited; they detect the change through the global version when read
+        mDirty.global = true;
+        changeEpoch()++;
+        if (!mSpatialDirty && mGameObject && mGameObject->scene()){
+            mSpatialDirty = true;
+            mGameObject->scene()->transformChanged(this);
         }
     }
+
+    void Transform::updateGlobal(){
+        uint32_t epoch = changeEpoch();
+        if (mValidatedEpoch == epoch){
+            return;
+        }
+        mValidatedEpoch = epoch;
+        if (mParent){
+            mParent->updateGlobal();
+            if (!mDirty.global && mParentGlobalVersion == mParent->mGlobalVersion){
+                return;
+            }
+            mGlobalMatrix = mParent->mGlobalMatrix * localMatrix();
+            mParentGlobalVersion = mParent->mGlobalVersion;
+        } else {
+            if (!mDirty.global){
+                return;
+            }
+            mGlobalMatrix = localMatrix();
+        }
+        mDirty.global = false;
+        mGlobalVersion++;
+    }
+
+    std::atomic<uint32_t> &Transform::changeEpoch(){
+        Scene *scene = mGameObject ? mGameObject->scene() : nullptr;
+        return scene ? scene->mTransformChangeEpoch : noSceneChangeEpoch;
+    }
+
+    const glm::mat4 &Transform::updatedGlobalInverse(){
+        if (mGlobalInverseVersion != mGlobalVersion){
+            mGlobalMatrixInverse = mParent ? localTRSInverse() * mParent->updatedGlobalInverse() : localTRSInverse();
+            mGlobalInverseVersion = mGlobalVersion;
+        }
+        return mGlobalMatrixInverse;
+    }
+
+    const glm::quat &Transform::updatedGlobalRotation(){
+        if (mGlobalRotationVersion != mGlobalVersion){
+            mGlobalRotationQuat = mParent ? mParent->updatedGlobalRotation() * mLocalRotationQuat : mLocalRotationQuat;
+            mGlobalRotationVersion = mGlobalVersion;
+        }
+        return mGlobalRotationQuat;
+    }
     
     void Transform::markLocalDirty(){
         mDirty.local = 1;
@@ -36,6 +114,10 @@ namespace kick {
     
     void Transform::setPosition(glm::vec3 position_){
         assert(!glm::any(glm::isnan(position_)));
+        if (mHierarchy){
+            setLocalPosition(mParent ? vec3(mParent->globalTRSInverse() * vec4(position_, 1)) : position_);
+            return;
+        }
         if (!mParent){
             setLocalPosition(position_);
             return;
@@ -46,35 +128,41 @@ namespace kick {
     }
     
     glm::vec3 Transform::position(){
+        if (mHierarchy){
+            return vec3(globalMatrix()[3]);
+        }
         if (!mParent){
             return mLocalPosition;
         }
-        if (mDirty.globalPos){
-            auto pos = globalMatrix() * vec4(0,0,0,1);
-            mGlobalPosition = vec3(pos);
-        }
-        return mGlobalPosition;
+        updateGlobal();
+        return vec3(mGlobalMatrix[3]);
     }
     
     void Transform::setLocalPosition(glm::vec3 position){
         assert(!glm::any(glm::isnan(position)));
+        if (mHierarchy){
+            mHierarchy->setLocalPosition(mHierarchyIndex, position);
+            return;
+        }
         mLocalPosition = position;
         markLocalDirty();
     }
     
     glm::vec3 Transform::localPosition(){
+        if (mHierarchy){
+            return mHierarchy->localPosition(mHierarchyIndex);
+        }
         return mLocalPosition;
     }
     
     void Transform::setLocalRotationEuler(glm::vec3 angles){
         assert(!glm::any(glm::isnan(angles)));
         mat4 rot = yawPitchRoll(angles.y, angles.x, angles.z);
-        mLocalRotationQuat = quat_cast(rot);
-        markLocalDirty();
+        setLocalRotation(quat_cast(rot));
     }
     
     glm::vec3 Transform::localRotationEuler(){
-        return eulerAngles(mLocalRotationQuat);
+        return eulerAngles(localRotation());
     }
     
     void Transform::setRotationEuler(glm::vec3 angles){
@@ -89,8 +177,12 @@ namespace kick {
     
     void Transform::setRotation(glm::quat rot){
         assert(!glm::isnan(rot.w) && !glm::isnan(rot.x) && !glm::isnan(rot.y) && !glm::isnan(rot.z));
+        if (mHierarchy){
+            setLocalRotation(mParent ? conjugate(mParent->rotation()) * rot : rot);
+            return;
+        }
         if (mParent == nullptr ||
-                mParent->mGlobalRotationQuat == glm::quat{1,0,0,0}){ // if parent is identity rotation
+                mParent->rotation() == glm::quat{1,0,0,0}){ // if parent is identity rotation
             setLocalRotation(rot);
         } else {
             quat diff = conjugate(rot) * rotation();
@@ -99,37 +191,47 @@ namespace kick {
     }
     
     glm::quat Transform::rotation(){
+        if (mHierarchy){
+            return mHierarchy->globalRotation(mHierarchyIndex);
+        }
         if (mParent == nullptr){
             return mLocalRotationQuat;
         }
-        if (mDirty.globalRot){
-            mGlobalRotationQuat = mLocalRotationQuat;
-            auto parentIterator = this->mParent;
-            while (parentIterator != nullptr){
-                mGlobalRotationQuat = parentIterator->mLocalRotationQuat * mGlobalRotationQuat;
-                parentIterator = parentIterator->mParent;
-            }
-        }
-        return mGlobalRotationQuat;
+        updateGlobal();
+        return updatedGlobalRotation();
     }
     
     void Transform::setLocalRotation(glm::quat rot){
         assert(!glm::isnan(rot.w) && !glm::isnan(rot.x) && !glm::isnan(rot.y) && !glm::isnan(rot.z));
+        if (mHierarchy){
+            mHierarchy->setLocalRotation(mHierarchyIndex, rot);
+            return;
+        }
         mLocalRotationQuat = rot;
         markLocalDirty();
     }
     
     glm::quat Transform::localRotation(){
+        if (mHierarchy){
+            return mHierarchy->localRotation(mHierarchyIndex);
+        }
         return mLocalRotationQuat;
     }
     
     void Transform::setLocalScale(glm::vec3 scale){
         assert(!glm::any(glm::isnan(scale)));
+        if (mHierarchy){
+            mHierarchy->setLocalScale(mHierarchyIndex, scale);
+            return;
+        }
         mLocalScale = scale;
         markLocalDirty();
     }
     
     glm::vec3 Transform::localScale(){
+        if (mHierarchy){
+            return mHierarchy->localScale(mHierarchyIndex);
+        }
         return mLocalScale;
     }
     
@@ -142,6 +244,13 @@ namespace kick {
             this->mParent->mChildren.erase(pos);
         }
         this->mParent = parent;
+        if (!mHierarchy){
+            markGlobalDirty();
+        }
+        if (mHierarchy){
+            assert(!parent || parent->mHierarchy == mHierarchy);
+            mHierarchy->setParent(mHierarchyIndex, parent ? parent->mHierarchyIndex : -1);
+        }
         if (parent){
             parent->mChildren.push_back(std::dynamic_pointer_cast<Transform>( shared_from_this()));
 
@@ -156,6 +265,9 @@ namespace kick {
     }
     
     glm::mat4 Transform::localTRSInverse(){
+        if (mHierarchy){
+            return kick::TRSInverse(localPosition(), localRotation(), localScale());
+        }
         if (mDirty.localInv){
             mLocalMatrixInverse = kick::TRSInverse(mLocalPosition, mLocalRotationQuat, mLocalScale);
             mDirty.localInv = false;
@@ -164,16 +276,11 @@ namespace kick {
     }
     
     glm::mat4 Transform::globalTRSInverse(){
-        if (mDirty.globalInv){
-            mGlobalMatrixInverse = localTRSInverse();
-            auto transformIterator = mParent;
-            while (transformIterator){
-                mGlobalMatrixInverse = mGlobalMatrixInverse * transformIterator->localTRSInverse();
-                transformIterator = transformIterator->mParent;
-            }
-            mDirty.globalInv = false;
+        if (mHierarchy){
+            return mHierarchy->globalMatrixInverse(mHierarchyIndex);
         }
-        return mGlobalMatrixInverse;
+        updateGlobal();
+        return updatedGlobalInverse();
     }
 
     void Transform::lookAt(vec3 center, glm::vec3 up){
@@ -195,6 +302,9 @@ namespace kick {
     }
     
     glm::mat4 Transform::localMatrix(){
+        if (mHierarchy){
+            return mHierarchy->localMatrix(mHierarchyIndex);
+        }
         if (mDirty.local) {
             mLocalMatrix = kick::TRS(mLocalPosition, mLocalRotationQuat, mLocalScale);
             mDirty.local = false;
@@ -203,16 +313,10 @@ namespace kick {
     }
     
     glm::mat4 Transform::globalMatrix(){
-        if (mDirty.global) {
-            mGlobalMatrix = localMatrix();
-            
-            auto transformIterator = mParent;
-            while (transformIterator) {
-                mGlobalMatrix = transformIterator->localMatrix() * mGlobalMatrix;
-                transformIterator  = transformIterator->mParent;
-            }
-            mDirty.global = false;
+        if (mHierarchy){
+            return mHierarchy->globalMatrix(mHierarchyIndex);
         }
+        updateGlobal();
         return mGlobalMatrix;
     }
     
@@ -258,4 +362,12 @@ namespace kick {
     vec3 Transform::right() {
         return mat3_cast(rotation()) * vec3(1,0,0);
     }
+
+    uint32_t Transform::globalVersion() {
+        if (mHierarchy){
+            return mHierarchy->globalVersion(mHierarchyIndex);
+        }
+        updateGlobal();
+        return mGlobalVersion;
+    }
 }
\ No newline at end of file
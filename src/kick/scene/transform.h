@@ -10,6 +10,7 @@
 
 
 #include "component.h"
+#include <atomic>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -18,13 +19,20 @@
 namespace kick {
     class GameObject;
     class Transform;
+    class TransformHierarchy;
     
     typedef std::vector<std::shared_ptr<Transform>>::iterator TransformIter;
     typedef std::vector<std::shared_ptr<Transform>>::const_iterator ConstTransformIter;
     
+    /// When the scene uses a flat transform hierarchy (Scene::setFlatTransformHierarchy()) the transform is a thin
+    /// handle to an entry in the TransformHierarchy, otherwise the transform data is stored in the object itself.
+    /// Global matrices are computed lazily: changing a transform only marks the transform itself dirty, and a global
+    /// matrix is recomputed on read if the transform is dirty or the parent's global version differs from the
+    /// version it was computed against.
     class Transform : public Component {
     public:
         Transform(GameObject *gameObject);
+        ~Transform();
         void setPosition(glm::vec3 position);
         glm::vec3 position();
         void setLocalPosition(glm::vec3 position);
@@ -57,27 +65,51 @@ namespace kick {
         glm::vec3 forward();
         glm::vec3 up();
         glm::vec3 right();
+
+        // changes each time the global matrix changes (by this transform or a parent)
+        uint32_t globalVersion();
     private:
+        friend class Scene;
+        friend class TransformHierarchy;
+        void setHierarchy(std::shared_ptr<TransformHierarchy> hierarchy);
         void markGlobalDirty();
         void markLocalDirty();
+        // update the global matrix of the parent chain (if needed)
+        void updateGlobal();
+        // the change epoch of the scene (or a shared epoch for transforms not in a scene)
+        std::atomic<uint32_t> &changeEpoch();
+        // the following assumes that updateGlobal() has been called
+        const glm::mat4 &updatedGlobalInverse();
+        const glm::quat &updatedGlobalRotation();
         glm::mat4 mLocalMatrix = glm::mat4(0);
         glm::mat4 mGlobalMatrix = glm::mat4(0);
         glm::mat4 mLocalMatrixInverse = glm::mat4(0);
         glm::mat4 mGlobalMatrixInverse = glm::mat4(0);
         glm::vec3 mLocalPosition = glm::vec3(0);
-        glm::vec3 mGlobalPosition = glm::vec3(0);
         glm::quat mGlobalRotationQuat = glm::quat(1,0,0,0);
         glm::quat mLocalRotationQuat = glm::quat(1,0,0,0);
         glm::vec3 mLocalScale = glm::vec3(1);
         struct {
             bool local = true;
             bool localInv = true;
-            bool global = true;
-            bool globalInv = true;
-            bool globalPos = true;
-            bool globalRot = true;
+            bool global = true; // the local matrix or the parent has changed
         } mDirty;
+        // incremented when the global matrix is recomputed
+        uint32_t mGlobalVersion = 0;
+        // the parent's global version used to compute the global matrix
+        uint32_t mParentGlobalVersion = 0;
+        // the change epoch of the scene when the global matrix was last validated (see updateGlobal()). The epoch is
+        // atomic, since parallel updatables may change transforms on worker threads. Reading the global matrix writes
+        // this and the parents' caches, so transforms sharing parents must not be read concurrently.
+        uint32_t mValidatedEpoch = 0;
+        // the global versions used to compute the global inverse and rotation
+        uint32_t mGlobalInverseVersion = 0xffffffff;
+        uint32_t mGlobalRotationVersion = 0xffffffff;
+        // true when queued for a spatial index update in the scene
+        bool mSpatialDirty = false;
         std::vector<std::shared_ptr<Transform>> mChildren;
         std::shared_ptr<Transform> mParent = nullptr;
+        std::shared_ptr<TransformHierarchy> mHierarchy;
+        int mHierarchyIndex = -1;
     };
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+//
+//  transform_hierarchy.cpp
+//  KickCPP
+//
+
+#include "kick/scene/transform_hierarchy.h"
+#include "kick/scene/transform.h"
+#include "kick/math/glm_ext.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace glm;
+
+namespace kick {
+
+    namespace {
+        template <typename T>
+        void permute(std::vector<T> &values, const std::vector<int> &order){
+            std::vector<T> res;
+            res.reserve(order.size());
+            for (int i : order){
+                res.push_back(values[i]);
+            }
+            values.swap(res);
+        }
+    }
+
+    int TransformHierarchy::add(Transform *owner, glm::vec3 localPosition, glm::quat localRotation, glm::vec3 localScale) {
+        int index = (int)mOwner.size();
+        mLocalPosition.push_back(localPosition);
+        mLocalRotation.push_back(localRotation);
+        mLocalScale.push_back(localScale);
+        mLocalMatrix.push_back(mat4{1});
+        mGlobalMatrix.push_back(mat4{1});
+        mGlobalMatrixInverse.push_back(mat4{1});
+        mGlobalRotation.push_back(quat{1,0,0,0});
+        mParent.push_back(-1);
+        mVersion.push_back(0);
+        mParentVersion.push_back(0);
+        mInverseVersion.push_back(0);
+        mFlags.push_back(LocalDirty);
+        mOwner.push_back(owner);
+        return index;
+    }
+
+    void TransformHierarchy::remove(int index) {
+        mOwner[index] = nullptr;
+        mOrderDirty = true;
+    }
+
+    void TransformHierarchy::setParent(int index, int parentIndex) {
+        mParent[index] = parentIndex;
+        // force recomputation of the global matrix
+        mFlags[index] |= LocalDirty;
+        // a parent must be stored before its children
+        if (parentIndex > index){
+            mOrderDirty = true;
+        }
+    }
+
+    void TransformHierarchy::setLocalPosition(int index, glm::vec3 position) {
+        mLocalPosition[index] = position;
+        mFlags[index] |= LocalDirty;
+    }
+
+    void TransformHierarchy::setLocalRotation(int index, glm::quat rotation) {
+        mLocalRotation[index] = rotation;
+        mFlags[index] |= LocalDirty;
+    }
+
+    void TransformHierarchy::setLocalScale(int index, glm::vec3 scale) {
+        mLocalScale[index] = scale;
+        mFlags[index] |= LocalDirty;
+    }
+
+    const glm::mat4 &TransformHierarchy::localMatrix(int index) {
+        if (mFlags[index] & LocalDirty){
+            updateParentChain(index);
+        }
+        return mLocalMatrix[index];
+    }
+
+    const glm::mat4 &TransformHierarchy::globalMatrix(int index) {
+        updateParentChain(index);
+        return mGlobalMatrix[index];
+    }
+
+    const glm::mat4 &TransformHierarchy::globalMatrixInverse(int index) {
+        updateParentChain(index);
+        if (mInverseVersion[index] != mVersion[index]){
+            mat4 localInverse = TRSInverse(mLocalPosition[index], mLocalRotation[index], mLocalScale[index]);
+            int parent = mParent[index];
+            mGlobalMatrixInverse[index] = parent == -1 ? localInverse : localInverse * globalMatrixInverse(parent);
+            mInverseVersion[index] = mVersion[index];
+        }
+        return mGlobalMatrixInverse[index];
+    }
+
+    glm::quat TransformHierarchy::globalRotation(int index) {
+        updateParentChain(index);
+        return mGlobalRotation[index];
+    }
+
+    uint32_t TransformHierarchy::globalVersion(int index) {
+        updateParentChain(index);
+        return mVersion[index];
+    }
+
+    void TransformHierarchy::update() {
+        update([](Transform*){});
+    }
+
+    bool TransformHierarchy::stale(int index) const {
+        int parent = mParent[index];
+        return (mFlags[index] & (LocalDirty | GlobalDirty)) || (parent != -1 && mParentVersion[index] != mVersion[parent]);
+    }
+
+    void TransformHierarchy::updateGlobal(int index) {
+        if (mFlags[index] & LocalDirty){
+            mLocalMatrix[index] = TRS(mLocalPosition[index], mLocalRotation[index], mLocalScale[index]);
+        }
+        int parent = mParent[index];
+        if (parent == -1){
+            mGlobalMatrix[index] = mLocalMatrix[index];
+            mGlobalRotation[index] = mLocalRotation[index];
+            mParentVersion[index] = 0;
+        } else {
+            mGlobalMatrix[index] = mGlobalMatrix[parent] * mLocalMatrix[index];
+            mGlobalRotation[index] = mGlobalRotation[parent] * mLocalRotation[index];
+            mParentVersion[index] = mVersion[parent];
+        }
+        mVersion[index]++;
+        mFlags[index] = Changed;
+    }
+
+    void TransformHierarchy::updateLocalMatrices() {
+        int count = (int)mOwner.size();
+        int i = 0;
+        while (i < count){
+            if (!(mFlags[i] & LocalDirty)){
+                i++;
+                continue;
+            }
+            int begin = i;
+            while (i < count && (mFlags[i] & LocalDirty)){
+                mFlags[i] = (mFlags[i] & ~LocalDirty) | GlobalDirty;
+                i++;
+            }
+            TRS(&mLocalPosition[begin], &mLocalRotation[begin], &mLocalScale[begin], &mLocalMatrix[begin], i - begin);
+        }
+    }
+
+    void TransformHierarchy::updateParentChain(int index) {
+        // update from the root and down to the index
+        mChain.clear();
+        for (int i = index; i != -1; i = mParent[i]){
+            mChain.push_back(i);
+        }
+        for (auto i = mChain.rbegin(); i != mChain.rend(); i++){
+            if (stale(*i)){
+                updateGlobal(*i);
+            }
+        }
+    }
+
+    void TransformHierarchy::sortByDepth() {
+        int count = (int)mOwner.size();
+        std::vector<int> depth(count, -1);
+        for (int i = 0; i < count; i++){
+            // walk up until a node with known depth is found, then assign depths down the path
+            int d = 0;
+            int j = i;
+            while (j != -1 && depth[j] == -1){
+                j = mParent[j];
+                d++;
+            }
+            int base = j == -1 ? -1 : depth[j];
+            j = i;
+            while (j != -1 && depth[j] == -1){
+                d--;
+                depth[j] = base + 1 + d;
+                j = mParent[j];
+            }
+        }
+
+        std::vector<int> order;
+        order.reserve(count);
+        for (int i = 0; i < count; i++){
+            if (mOwner[i]){
+                order.push_back(i);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+            return depth[a] < depth[b];
+        });
+
+        std::vector<int> newIndex(count, -1);
+        for (int i = 0; i < (int)order.size(); i++){
+            newIndex[order[i]] = i;
+        }
+
+        permute(mLocalPosition, order);
+        permute(mLocalRotation, order);
+        permute(mLocalScale, order);
+        permute(mLocalMatrix, order);
+        permute(mGlobalMatrix, order);
+        permute(mGlobalMatrixInverse, order);
+        permute(mGlobalRotation, order);
+        permute(mParent, order);
+        permute(mVersion, order);
+        permute(mParentVersion, order);
+        permute(mInverseVersion, order);
+        permute(mFlags, order);
+        permute(mOwner, order);
+
+        for (int i = 0; i < (int)mParent.size(); i++){
+            if (mParent[i] != -1){
+                mParent[i] = newIndex[mParent[i]];
+                if (mParent[i] == -1){
+                    // parent was removed
+                    mFlags[i] |= LocalDirty;
+                }
+            }
+            assert(mParent[i] < i);
+            mOwner[i]->mHierarchyIndex = i;
+        }
+        mOrderDirty = false;
+    }
+}
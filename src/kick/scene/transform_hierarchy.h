@@ -0,0 +1,97 @@
+//
+//  transform_hierarchy.h
+//  KickCPP
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace kick {
+    class Transform;
+
+    /// Flat storage of the transforms in a scene (structure of arrays). Local TRS, global matrices and parent indices
+    /// are stored in contiguous arrays sorted by depth, such that a parent is always stored before its children.
+    /// Changing a local TRS only marks the entry dirty; global matrices are computed either by the batched update()
+    /// pass (a single linear pass over the arrays) or on demand by walking the parent indices.
+    /// Indices are not stable: they change when the hierarchy is re-sorted (after reparenting or removal).
+    class TransformHierarchy {
+    public:
+        int add(Transform *owner, glm::vec3 localPosition = glm::vec3{0}, glm::quat localRotation = glm::quat{1,0,0,0}, glm::vec3 localScale = glm::vec3{1});
+        void remove(int index);
+        void setParent(int index, int parentIndex);
+        int parent(int index) const { return mParent[index]; }
+
+        void setLocalPosition(int index, glm::vec3 position);
+        void setLocalRotation(int index, glm::quat rotation);
+        void setLocalScale(int index, glm::vec3 scale);
+        glm::vec3 localPosition(int index) const { return mLocalPosition[index]; }
+        glm::quat localRotation(int index) const { return mLocalRotation[index]; }
+        glm::vec3 localScale(int index) const { return mLocalScale[index]; }
+
+        const glm::mat4 &localMatrix(int index);
+        // the matrices and the global rotation are brought up to date (only the parent chain is visited)
+        const glm::mat4 &globalMatrix(int index);
+        const glm::mat4 &globalMatrixInverse(int index);
+        glm::quat globalRotation(int index);
+        // incremented each time the global matrix is recomputed
+        uint32_t globalVersion(int index);
+
+        /// Updates all global matrices in a single pass in depth order. The callback (void(Transform*)) is invoked
+        /// for each transform whose global matrix changed since the last update
+        template <typename F>
+        void update(F changed);
+        void update();
+
+        // number of entries (including removed entries not yet compacted)
+        int size() const { return (int)mOwner.size(); }
+    private:
+        enum Flags : uint8_t {
+            LocalDirty = 1,
+            Changed = 2,
+            GlobalDirty = 4 // local matrix is up to date, but the global matrix is not
+        };
+        bool stale(int index) const;
+        // compute the local matrices of consecutive dirty entries using the batch TRS
+        void updateLocalMatrices();
+        void updateGlobal(int index);
+        void updateParentChain(int index);
+        void sortByDepth();
+
+        std::vector<glm::vec3> mLocalPosition;
+        std::vector<glm::quat> mLocalRotation;
+        std::vector<glm::vec3> mLocalScale;
+        std::vector<glm::mat4> mLocalMatrix;
+        std::vector<glm::mat4> mGlobalMatrix;
+        std::vector<glm::mat4> mGlobalMatrixInverse;
+        std::vector<glm::quat> mGlobalRotation;
+        std::vector<int> mParent;
+        std::vector<uint32_t> mVersion;
+        std::vector<uint32_t> mParentVersion;  // parent version used when computing the global matrix
+        std::vector<uint32_t> mInverseVersion; // version used when computing the inverse global matrix
+        std::vector<uint8_t> mFlags;
+        std::vector<Transform*> mOwner;        // nullptr if removed
+        std::vector<int> mChain;
+        bool mOrderDirty = false;
+    };
+
+    template <typename F>
+    inline void TransformHierarchy::update(F changed) {
+        if (mOrderDirty){
+            sortByDepth();
+        }
+        updateLocalMatrices();
+        for (int i = 0; i < (int)mOwner.size(); i++){
+            if (stale(i)){
+                updateGlobal(i);
+            }
+            if (mFlags[i] & Changed){
+                mFlags[i] &= ~Changed;
+                changed(mOwner[i]);
+            }
+        }
+    }
+}
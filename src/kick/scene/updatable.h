@@ -9,14 +9,34 @@
 
 
 namespace kick {
+    // The scene updates the components phase by phase (all EarlyUpdate components before Update components etc.)
+    enum class UpdatePhase {
+        EarlyUpdate,
+        Update,
+        LateUpdate
+    };
+
     // "Mixin" must be added to a Component to enable update events
     // Example:
     // class RotatorComponent : public Component, public Updatable {
     // //...
     // }
+    // Disabled components are not updated.
     class Updatable {
     public:
         virtual void update() = 0;
+
+        // The phase the component is updated in. Read when the component is added to the scene
+        virtual UpdatePhase updatePhase() const { return UpdatePhase::Update; }
+
+        // Return true if update() can run on a worker thread in parallel with other components in the same phase.
+        // Such components must not call OpenGL, create or destroy game objects / components or modify state shared
+        // with other components. They may change the transform of their own game object (the scene queues the change
+        // per thread), but must not read the global transform of a game object whose parents are shared with other
+        // parallel components, since reading updates the cached matrices of the parents.
+        // Components not parallel-safe are updated on the main thread in the order they were added, after the
+        // parallel-safe components of the same phase. Read when the component is added to the scene
+        virtual bool parallelUpdate() const { return false; }
     };
 }
 
@@ -32,12 +32,11 @@ namespace kick {
     }
     
     Texture2D::~Texture2D(){
-        glDeleteTextures(1, &mTextureid);
+        GLState::deleteTextures(1, &mTextureid);
     }
     
     void Texture2D::bind(int textureSlot){
-        glActiveTexture(GL_TEXTURE0 + textureSlot);
-        glBindTexture(GL_TEXTURE_2D, mTextureid);
+        GLState::bindTexture(textureSlot, GL_TEXTURE_2D, mTextureid);
     }
     
     void Texture2D::setData(const Texture2DData& data, const ImageFormat& imageFormat){
@@ -51,7 +50,7 @@ namespace kick {
         GLenum target = GL_TEXTURE_2D;
         GLint border = 0; // must be 0
 
-        glBindTexture(GL_TEXTURE_2D, mTextureid);
+        GLState::bindTexture(GL_TEXTURE_2D, mTextureid);
 
         glTexImage2D(target, imageFormat.mipmapLevel, imageFormat.internalFormat, width, height, border, imageFormat.format, imageFormat.type, data);
         if (imageFormat.mipmap != Mipmap::None){
@@ -61,7 +60,7 @@ namespace kick {
 
     void Texture2D::setTextureSampler(const TextureSampler & textureSampler){
         this->mTextureSampler = textureSampler;
-        glBindTexture(GL_TEXTURE_2D, mTextureid);
+        GLState::bindTexture(GL_TEXTURE_2D, mTextureid);
         
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(textureSampler.wrapS));
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(textureSampler.wrapT));
@@ -19,12 +19,11 @@ namespace kick {
     }
 
     TextureCube::~TextureCube(){
-        glDeleteTextures(1, &mTextureid);
+        GLState::deleteTextures(1, &mTextureid);
     }
 
     void TextureCube::bind(int textureSlot){
-        glActiveTexture(GL_TEXTURE0 + textureSlot);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureid);
+        GLState::bindTexture(textureSlot, GL_TEXTURE_CUBE_MAP, mTextureid);
     }
 
     void TextureCube::setData(int width, int height, char* data, int cubemapIndex, const ImageFormat& imageFormat){
@@ -33,7 +32,7 @@ namespace kick {
         this->mImageFormat = imageFormat;
         GLint border = 0; // must be 0
 
-        glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureid);
+        GLState::bindTexture(GL_TEXTURE_CUBE_MAP, mTextureid);
 
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+cubemapIndex, imageFormat.mipmapLevel, imageFormat.internalFormat, width, height/6, border, imageFormat.format, imageFormat.type, data);
         mFacesSet[cubemapIndex] = 1;
@@ -44,7 +43,7 @@ namespace kick {
 
     void TextureCube::setTextureSampler(const TextureSampler & textureSampler){
         this->mTextureSampler = textureSampler;
-        glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureid);
+        GLState::bindTexture(GL_TEXTURE_CUBE_MAP, mTextureid);
 
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, static_cast<GLint>(textureSampler.wrapS));
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, static_cast<GLint>(textureSampler.wrapT));
@@ -845,3 +845,1057 @@ int TestRay(){
     TINYTEST_ASSERT(intersectionPoint == vec3(1,1,0));
     return 1;
 }
+
+int TestRenderableWorldBounds(){
+    auto meshRenderer = Engine::activeScene()->createCube(nullptr, 2);
+    Bounds3 bounds = meshRenderer->worldBounds();
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.min, vec3{-1}, vec3{0.0001f})));
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.max, vec3{1}, vec3{0.0001f})));
+
+    auto parent = Engine::activeScene()->createGameObject("Parent");
+    meshRenderer->transform()->setParent(parent->transform());
+    parent->transform()->setLocalPosition(vec3{10,0,0});
+    bounds = meshRenderer->worldBounds();
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.min, vec3{9,-1,-1}, vec3{0.0001f})));
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.max, vec3{11,1,1}, vec3{0.0001f})));
+
+    // assigning new mesh data to the mesh updates the bounds
+    meshRenderer->mesh()->setMeshData(MeshFactory::createCubeData(2));
+    bounds = meshRenderer->worldBounds();
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.min, vec3{8,-2,-2}, vec3{0.0001f})));
+    TINYTEST_ASSERT(all(epsilonEqual(bounds.max, vec3{12,2,2}, vec3{0.0001f})));
+
+    meshRenderer->setMesh(nullptr);
+    TINYTEST_ASSERT(meshRenderer->worldBounds().uninitialized());
+    return 1;
+}
+
+int TestSceneSpatialQuery(){
+    Scene *scene = Engine::activeScene();
+    auto meshRenderer = scene->createCube(nullptr, 2);
+    meshRenderer->transform()->setPosition(vec3{1000,0,0});
+
+    auto contains = [](const vector<ComponentRenderable*>& list, ComponentRenderable* r){
+        return find(list.begin(), list.end(), r) != list.end();
+    };
+    vector<ComponentRenderable*> res;
+    scene->queryRenderables(Bounds3{vec3{995,-5,-5}, vec3{1005,5,5}}, res);
+    TINYTEST_ASSERT(res.size() == 1 && res[0] == meshRenderer.get());
+
+    res.clear();
+    scene->raycastRenderables(Ray{vec3{1000,0,50}, vec3{0,0,-1}}, res);
+    TINYTEST_ASSERT(contains(res, meshRenderer.get()));
+
+    // moving the object must update the spatial index
+    meshRenderer->transform()->setPosition(vec3{2000,0,0});
+    res.clear();
+    scene->queryRenderables(Bounds3{vec3{995,-5,-5}, vec3{1005,5,5}}, res);
+    TINYTEST_ASSERT(res.empty());
+    scene->queryRenderables(Bounds3{vec3{1995,-5,-5}, vec3{2005,5,5}}, res);
+    TINYTEST_ASSERT(contains(res, meshRenderer.get()));
+
+    mat4 projection = glm::perspective(radians(60.0f), 1.0f, 0.1f, 100.0f);
+    mat4 view = glm::lookAt(vec3{2000,0,10}, vec3{2000,0,0}, vec3{0,1,0});
+    Frustum frustum;
+    frustum.extractPlanes(projection * view);
+    res.clear();
+    scene->queryRenderables(frustum, res);
+    TINYTEST_ASSERT(contains(res, meshRenderer.get()));
+
+    // renderables without bounds are never culled
+    meshRenderer->setMesh(nullptr);
+    view = glm::lookAt(vec3{-2000,0,10}, vec3{-2000,0,0}, vec3{0,1,0});
+    frustum.extractPlanes(projection * view);
+    res.clear();
+    scene->queryRenderables(frustum, res);
+    TINYTEST_ASSERT(contains(res, meshRenderer.get()));
+
+    scene->destroyGameObject(meshRenderer->gameObject());
+    res.clear();
+    scene->queryRenderables(frustum, res);
+    TINYTEST_ASSERT(!contains(res, meshRenderer.get()));
+    return 1;
+}
+
+int TestFlatTransformHierarchy(){
+    Scene *scene = Engine::activeScene();
+    auto root = scene->createGameObject("Root")->transform();
+    auto child = scene->createGameObject("Child")->transform();
+    auto grandChild = scene->createGameObject("GrandChild")->transform();
+    child->setParent(root);
+    grandChild->setParent(child);
+    root->setLocalPosition(vec3{1,2,3});
+    root->setLocalRotationEuler(vec3{0.1f,0.2f,0.3f});
+    child->setLocalScale(vec3{2,2,2});
+    grandChild->setLocalPosition(vec3{0,1,0});
+    mat4 expected = grandChild->globalMatrix();
+
+    // existing transforms are migrated
+    scene->setFlatTransformHierarchy(true);
+    TINYTEST_ASSERT(scene->flatTransformHierarchy());
+    TINYTEST_ASSERT(equal(expected, grandChild->globalMatrix()));
+    TINYTEST_ASSERT(equal(mat4{1}, grandChild->globalMatrix() * grandChild->globalTRSInverse()));
+
+    // changes are propagated lazily and by the batched pass
+    root->setLocalPosition(vec3{0});
+    expected = root->globalMatrix() * child->localMatrix() * grandChild->localMatrix();
+    TINYTEST_ASSERT(equal(expected, grandChild->globalMatrix()));
+    child->setLocalPosition(vec3{5,0,0});
+    scene->transformHierarchy()->update();
+    expected = root->localMatrix() * child->localMatrix() * grandChild->localMatrix();
+    TINYTEST_ASSERT(equal(expected, grandChild->globalMatrix()));
+
+    // reparent a transform to a transform created later (requires the hierarchy to be re-sorted)
+    auto newRoot = scene->createGameObject("NewRoot")->transform();
+    newRoot->setLocalPosition(vec3{0,0,10});
+    root->setParent(newRoot);
+    scene->transformHierarchy()->update();
+    expected = newRoot->localMatrix() * root->localMatrix() * child->localMatrix() * grandChild->localMatrix();
+    TINYTEST_ASSERT(equal(expected, grandChild->globalMatrix()));
+    grandChild->setPosition(vec3{1,1,1});
+    TINYTEST_ASSERT(length(grandChild->position() - vec3{1,1,1}) < 0.0001f);
+
+    // the local transforms are copied back when disabled
+    expected = grandChild->globalMatrix();
+    scene->setFlatTransformHierarchy(false);
+    TINYTEST_ASSERT(equal(expected, grandChild->globalMatrix()));
+    for (auto t : {grandChild, child, root, newRoot}){
+        t->setParent(nullptr);
+        scene->destroyGameObject(t->gameObject());
+    }
+    return 1;
+}
+
+int TestJobSystem(){
+    JobSystem jobSystem(3);
+    TINYTEST_ASSERT(jobSystem.workerThreadCount() == 3);
+    TINYTEST_ASSERT(jobSystem.isMainThread());
+
+    std::atomic<long long> sum{0};
+    jobSystem.parallelFor(0, 100000, [&](int begin, int end){
+        long long s = 0;
+        for (int i = begin; i < end; i++){
+            s += i;
+        }
+        sum += s;
+    });
+    TINYTEST_ASSERT(sum == 4999950000LL);
+
+    // a parent job is not completed before its children are completed
+    std::atomic<int> count{0};
+    auto parent = jobSystem.createJob([&]{ count++; });
+    for (int i = 0; i < 100; i++){
+        jobSystem.run(jobSystem.createJob([&]{ count++; }, parent));
+    }
+    jobSystem.run(parent);
+    jobSystem.wait(parent);
+    TINYTEST_ASSERT(parent->completed());
+    TINYTEST_ASSERT(count == 101);
+
+    // main thread jobs scheduled from a worker thread are executed on the main thread
+    bool executedOnMainThread = false;
+    auto job = jobSystem.createJob([&]{
+        jobSystem.execute([&]{
+            executedOnMainThread = jobSystem.isMainThread();
+        }, JobAffinity::MainThread);
+    });
+    jobSystem.run(job);
+    jobSystem.wait(job);
+    TINYTEST_ASSERT(executedOnMainThread);
+
+    // without worker threads everything runs on the calling thread
+    JobSystem singleThreaded(0);
+    count = 0;
+    singleThreaded.parallelFor(0, 10, [&](int begin, int end){
+        count += end - begin;
+    });
+    TINYTEST_ASSERT(count == 10);
+    return 1;
+}
+
+class UpdateRecorder : public Component, public Updatable {
+public:
+    UpdateRecorder(GameObject *gameObject, UpdatePhase phase, bool parallel, std::vector<std::string> *log, std::atomic<int> *parallelCount, std::string name)
+    :Component(gameObject), mPhase(phase), mParallel(parallel), mLog(log), mParallelCount(parallelCount), mName(name){
+    }
+    void update() override {
+        if (mParallel){
+            (*mParallelCount)++;
+        } else {
+            mLog->push_back(mName);
+        }
+    }
+    UpdatePhase updatePhase() const override { return mPhase; }
+    bool parallelUpdate() const override { return mParallel; }
+private:
+    UpdatePhase mPhase;
+    bool mParallel;
+    std::vector<std::string> *mLog;
+    std::atomic<int> *mParallelCount;
+    std::string mName;
+};
+
+int TestUpdatablePhases(){
+    Scene *scene = Engine::activeScene();
+    GameObject *gameObject = scene->createGameObject("Updatables");
+    std::vector<std::string> log;
+    std::atomic<int> parallelCount{0};
+    gameObject->addComponent<UpdateRecorder>(UpdatePhase::LateUpdate, false, &log, &parallelCount, "late");
+    gameObject->addComponent<UpdateRecorder>(UpdatePhase::Update, false, &log, &parallelCount, "update1");
+    gameObject->addComponent<UpdateRecorder>(UpdatePhase::EarlyUpdate, false, &log, &parallelCount, "early");
+    gameObject->addComponent<UpdateRecorder>(UpdatePhase::Update, false, &log, &parallelCount, "update2");
+    auto disabled = gameObject->addComponent<UpdateRecorder>(UpdatePhase::Update, false, &log, &parallelCount, "disabled");
+    disabled->setEnabled(false);
+    for (int i = 0; i < 100; i++){
+        gameObject->addComponent<UpdateRecorder>(UpdatePhase::Update, true, &log, &parallelCount, "parallel");
+    }
+    scene->update();
+    TINYTEST_ASSERT((log == std::vector<std::string>{"early", "update1", "update2", "late"}));
+    TINYTEST_ASSERT(parallelCount == 100);
+    scene->destroyGameObject(gameObject);
+    return 1;
+}
+
+class TransformMover : public Component, public Updatable {
+public:
+    TransformMover(GameObject *gameObject, vec3 position)
+    :Component(gameObject), mPosition(position){
+    }
+    void update() override {
+        transform()->setPosition(mPosition);
+    }
+    bool parallelUpdate() const override { return true; }
+private:
+    vec3 mPosition;
+};
+
+int TestParallelUpdatableTransforms(){
+    Scene *scene = Engine::activeScene();
+    std::vector<GameObject*> gameObjects;
+    for (int i = 0; i < 200; i++){
+        auto renderer = scene->createCube();
+        renderer->gameObject()->addComponent<TransformMover>(vec3{i * 10, 3000, 0});
+        gameObjects.push_back(renderer->gameObject());
+    }
+    std::vector<ComponentRenderable*> res;
+    scene->queryRenderables(Bounds3{vec3{-5, 2995, -5}, vec3{2000, 3005, 5}}, res);
+    TINYTEST_ASSERT(res.empty());
+
+    // the transforms changed on the worker threads are merged into the spatial index
+    scene->update();
+    scene->queryRenderables(Bounds3{vec3{-5, 2995, -5}, vec3{2000, 3005, 5}}, res);
+    TINYTEST_ASSERT(res.size() == 200);
+    res.clear();
+    scene->queryRenderables(Bounds3{vec3{985, 2995, -5}, vec3{995, 3005, 5}}, res);
+    TINYTEST_ASSERT(res.size() == 1 && res[0]->gameObject() == gameObjects[99]);
+    for (auto gameObject : gameObjects){
+        scene->destroyGameObject(gameObject);
+    }
+    return 1;
+}
+
+int TestComponentTypeId(){
+    TINYTEST_ASSERT(componentTypeId<MeshRenderer>() == componentTypeId<MeshRenderer>());
+    TINYTEST_ASSERT(componentTypeId<MeshRenderer>() != componentTypeId<Light>());
+
+    auto gameObject = Engine::activeScene()->createGameObject("SomeObject");
+    auto light1 = gameObject->addComponent<Light>();
+    auto meshRenderer = gameObject->addComponent<MeshRenderer>();
+    auto light2 = gameObject->addComponent<Light>();
+    auto camera = gameObject->addComponent<CameraPerspective>();
+
+    // exact type lookup
+    TINYTEST_EQUAL(light1, gameObject->component<Light>());
+    TINYTEST_EQUAL(meshRenderer, gameObject->component<MeshRenderer>());
+    // derived type lookup
+    TINYTEST_EQUAL(std::static_pointer_cast<Camera>(camera), gameObject->component<Camera>());
+    TINYTEST_EQUAL(std::static_pointer_cast<ComponentRenderable>(meshRenderer), gameObject->component<ComponentRenderable>());
+    TINYTEST_ASSERT(gameObject->components<Light>().size() == 2);
+    TINYTEST_ASSERT(gameObject->components<Component>().size() == 5); // including transform
+
+    // the index is updated when components are destroyed
+    gameObject->destroyComponent(light1);
+    TINYTEST_EQUAL(light2, gameObject->component<Light>());
+    TINYTEST_EQUAL(meshRenderer, gameObject->component<MeshRenderer>());
+    gameObject->destroyComponent(light2);
+    TINYTEST_EQUAL(nullptr, gameObject->component<Light>());
+    TINYTEST_EQUAL(camera, gameObject->component<CameraPerspective>());
+    Engine::activeScene()->destroyGameObject(gameObject);
+    return 1;
+}
+
+int TestComponentRegistry(){
+    auto scene = Engine::activeScene();
+    auto gameObject = scene->createGameObject("SomeObject");
+    auto light = gameObject->addComponent<Light>();
+    auto meshRenderer = gameObject->addComponent<MeshRenderer>();
+
+    // registering a type indexes existing components
+    TINYTEST_ASSERT(scene->componentRegistry<MeshRenderer>() == nullptr);
+    scene->registerComponentType<MeshRenderer>();
+    auto registry = scene->componentRegistry<MeshRenderer>();
+    TINYTEST_ASSERT(registry != nullptr);
+    TINYTEST_ASSERT(registry->components().size() == 1);
+    TINYTEST_EQUAL(meshRenderer, registry->components()[0]);
+
+    // registries are kept up to date
+    auto meshRenderer2 = gameObject->addComponent<MeshRenderer>();
+    TINYTEST_ASSERT(registry->components().size() == 2);
+    gameObject->destroyComponent(meshRenderer);
+    TINYTEST_ASSERT(registry->components().size() == 1);
+    TINYTEST_EQUAL(meshRenderer2, registry->components()[0]);
+    TINYTEST_ASSERT(scene->findComponents<MeshRenderer>().size() == 1);
+
+    // removal keeps the creation order
+    auto meshRenderer3 = gameObject->addComponent<MeshRenderer>();
+    auto meshRenderer4 = gameObject->addComponent<MeshRenderer>();
+    gameObject->destroyComponent(meshRenderer2);
+    TINYTEST_ASSERT(registry->components().size() == 2);
+    TINYTEST_EQUAL(meshRenderer3, registry->components()[0]);
+    TINYTEST_EQUAL(meshRenderer4, registry->components()[1]);
+    TINYTEST_EQUAL(meshRenderer3, scene->findComponent<MeshRenderer>());
+
+    // built-in registries
+    size_t renderableCount = scene->componentRegistry<ComponentRenderable>()->components().size();
+    auto lights = scene->findComponents<Light>();
+    TINYTEST_ASSERT(std::find(lights.begin(), lights.end(), light) != lights.end());
+    scene->destroyGameObject(gameObject);
+    TINYTEST_ASSERT(scene->componentRegistry<ComponentRenderable>()->components().size() == renderableCount - 2);
+    TINYTEST_ASSERT(registry->components().empty());
+    return 1;
+}
+
+int TestGameObjectHandle(){
+    auto scene = Engine::activeScene();
+    std::vector<GameObject*> gameObjects;
+    for (int i = 0; i < 10; i++){
+        gameObjects.push_back(scene->createGameObject("SomeObject"));
+    }
+    auto handle = gameObjects[3]->handle();
+    int32_t uid = gameObjects[3]->uniqueId();
+    TINYTEST_ASSERT(handle);
+    TINYTEST_EQUAL(gameObjects[3], scene->gameObject(handle));
+    TINYTEST_EQUAL(gameObjects[3], scene->gameObjectByUID(uid));
+    TINYTEST_EQUAL(nullptr, scene->gameObject(GameObjectHandle{}));
+
+    // destroyed gameobjects resolves to null, also when the slot is reused
+    TINYTEST_ASSERT(scene->destroyGameObject(gameObjects[3]));
+    TINYTEST_ASSERT(!scene->destroyGameObject(gameObjects[3]));
+    TINYTEST_EQUAL(nullptr, scene->gameObject(handle));
+    TINYTEST_EQUAL(nullptr, scene->gameObjectByUID(uid));
+    auto reused = scene->createGameObject("Reused");
+    TINYTEST_ASSERT(reused->handle().index == handle.index);
+    TINYTEST_ASSERT(reused->handle() != handle);
+    TINYTEST_EQUAL(nullptr, scene->gameObject(handle));
+    TINYTEST_EQUAL(reused, scene->gameObject(reused->handle()));
+
+    // the remaining gameobjects can still be found after swap and pop removal
+    for (int i = 0; i < 10; i++){
+        if (i != 3){
+            TINYTEST_EQUAL(gameObjects[i], scene->gameObject(gameObjects[i]->handle()));
+            TINYTEST_EQUAL(gameObjects[i], scene->gameObjectByUID(gameObjects[i]->uniqueId()));
+            TINYTEST_ASSERT(scene->destroyGameObject(gameObjects[i]));
+        }
+    }
+    TINYTEST_ASSERT(scene->destroyGameObject(reused));
+    return 1;
+}
+
+int TestPooledAllocation(){
+    auto scene = Engine::activeScene();
+    auto spawn = [&](std::vector<GameObject*> &gameObjects){
+        for (int i = 0; i < 100; i++){
+            auto gameObject = scene->createGameObject("Pooled");
+            gameObject->addComponent<Light>();
+            gameObjects.push_back(gameObject);
+        }
+    };
+    std::vector<GameObject*> gameObjects;
+    size_t liveCount = scene->allocators().liveCount();
+    spawn(gameObjects);
+    // gameobject, transform and light per gameobject
+    TINYTEST_ASSERT(scene->allocators().liveCount() == liveCount + 300);
+    for (auto gameObject : gameObjects){
+        scene->destroyGameObject(gameObject);
+    }
+    TINYTEST_ASSERT(scene->allocators().liveCount() == liveCount);
+
+    // steady state spawning reuses the pooled memory
+    size_t slabCount = scene->allocators().slabCount();
+    size_t allocationCount = scene->allocators().allocationCount();
+    for (int i = 0; i < 10; i++){
+        gameObjects.clear();
+        spawn(gameObjects);
+        for (auto gameObject : gameObjects){
+            scene->destroyGameObject(gameObject);
+        }
+    }
+    TINYTEST_ASSERT(scene->allocators().slabCount() == slabCount);
+    TINYTEST_ASSERT(scene->allocators().allocationCount() == allocationCount + 3000);
+
+    // components may outlive their gameobject
+    auto gameObject = scene->createGameObject("Pooled");
+    auto light = gameObject->addComponent<Light>();
+    scene->destroyGameObject(gameObject);
+    TINYTEST_ASSERT(scene->allocators().liveCount() == liveCount + 1);
+    light.reset();
+    TINYTEST_ASSERT(scene->allocators().liveCount() == liveCount);
+    return 1;
+}
+
+int TestEvent(){
+    Event<int> event;
+    std::string log;
+    auto listenerA = event.createListener([&](int i){ log += "a"; }, 1);
+    auto listenerB = event.createListener([&](const int &i){ log += "b"; }, 0);
+    std::function<void(int)> function = [&](int i){ log += "c"; };
+    auto listenerC = event.createListener(function, 2);
+    event.notifyListeners(1);
+    TINYTEST_ASSERT(log == "bac");
+
+    // add and remove listeners during notification
+    EventListener<int> listenerD, listenerE;
+    listenerD = event.createListener([&](int i){
+        log += "d";
+        listenerD = EventListener<int>();
+        listenerE = event.createListener([&](int i){ log += "e"; }, -1);
+    }, 1);
+    log = "";
+    event.notifyListeners(1);
+    TINYTEST_ASSERT(log == "badc");
+    log = "";
+    event.notifyListeners(1);
+    TINYTEST_ASSERT(log == "ebac");
+
+    // removal when the listener goes out of scope
+    {
+        auto listenerF = event.createListener([&](int i){ log += "f"; }, 10);
+        TINYTEST_ASSERT(event.listenerCount() == 5);
+    }
+    TINYTEST_ASSERT(event.listenerCount() == 4);
+    log = "";
+    event.notifyListeners(1);
+    TINYTEST_ASSERT(log == "ebac");
+
+    // invalid ids are ignored
+    TINYTEST_ASSERT(!event.removeListener(-1));
+
+    // a stale id does not match a later listener, even after the slot has been reused many times (4096 reuses
+    // wrapped the generation bits of the previous 32 bit ids)
+    Event<int> recycled;
+    int64_t staleId = 0; // slot 0, generation 0
+    for (int i = 0; i < 4096; i++){
+        recycled.createListener([](int i){});
+    }
+    int count = 0;
+    auto live = recycled.createListener([&](int i){ count++; });
+    TINYTEST_ASSERT(!recycled.removeListener(staleId));
+    recycled.notifyListeners(1);
+    TINYTEST_ASSERT(count == 1);
+    return 1;
+}
+
+int TestTransformLazyUpdate(){
+    Scene *scene = Engine::activeScene();
+    // deep hierarchy
+    vector<std::shared_ptr<Transform>> transforms;
+    for (int i = 0; i < 100; i++){
+        transforms.push_back(scene->createGameObject("Transform")->transform());
+        transforms[i]->setLocalPosition(vec3{1,0,0});
+        if (i > 0){
+            transforms[i]->setParent(transforms[i-1]);
+        }
+    }
+    auto sibling = scene->createGameObject("Sibling")->transform();
+    sibling->setParent(transforms[50]);
+    TINYTEST_ASSERT(all(epsilonEqual(transforms.back()->position(), vec3{100,0,0}, 0.001f)));
+    TINYTEST_ASSERT(all(epsilonEqual(sibling->position(), vec3{51,0,0}, 0.001f)));
+
+    // changes of a parent are detected when the children are read
+    uint32_t leafVersion = transforms.back()->globalVersion();
+    uint32_t rootVersion = transforms[0]->globalVersion();
+    for (int i = 0; i < 3; i++){
+        transforms[0]->setLocalPosition(vec3{i,0,0});
+    }
+    TINYTEST_ASSERT(all(epsilonEqual(transforms.back()->position(), vec3{101,0,0}, 0.001f)));
+    TINYTEST_ASSERT(transforms.back()->globalVersion() != leafVersion);
+    TINYTEST_ASSERT(transforms[0]->globalVersion() != rootVersion);
+    TINYTEST_ASSERT(all(epsilonEqual(sibling->position(), vec3{52,0,0}, 0.001f)));
+    TINYTEST_ASSERT(all(epsilonEqual(transforms[60]->globalTRSInverse() * vec4{transforms[60]->position(), 1}, vec4{0,0,0,1}, 0.001f)));
+
+    // changing a child does not affect the parent
+    rootVersion = transforms[0]->globalVersion();
+    transforms[1]->setLocalPosition(vec3{2,0,0});
+    TINYTEST_ASSERT(transforms[0]->globalVersion() == rootVersion);
+    TINYTEST_ASSERT(all(epsilonEqual(transforms.back()->position(), vec3{102,0,0}, 0.001f)));
+
+    // reparenting
+    sibling->setParent(transforms[0]);
+    TINYTEST_ASSERT(all(epsilonEqual(sibling->position(), vec3{2,0,0}, 0.001f)));
+
+    // renderables below a moved transform are updated in the spatial index
+    auto meshRenderer = scene->createCube(nullptr, 1);
+    meshRenderer->transform()->setParent(transforms[10]);
+    transforms[0]->setLocalPosition(vec3{1000,0,0});
+    vec3 position = meshRenderer->transform()->position();
+    vector<ComponentRenderable*> res;
+    scene->queryRenderables(Bounds3{position - vec3{2}, position + vec3{2}}, res);
+    TINYTEST_ASSERT(find(res.begin(), res.end(), meshRenderer.get()) != res.end());
+
+    scene->destroyGameObject(meshRenderer->gameObject());
+    scene->destroyGameObject(sibling->gameObject());
+    for (auto it = transforms.rbegin(); it != transforms.rend(); it++){
+        scene->destroyGameObject((*it)->gameObject());
+    }
+    return 1;
+}
+
+int TestSceneSerialization(){
+    Scene *scene = Engine::activeScene();
+    auto root = scene->createGameObject("SerializedRoot");
+    root->setLayer(2);
+    root->transform()->setLocalPosition(vec3{1,2,3});
+    auto light = root->addComponent<Light>();
+    light->setLightType(LightType::Point);
+    light->setColor(vec3{1,0.5f,0.25f});
+    light->setIntensity(0.7f);
+    auto child = scene->createGameObject("SerializedChild");
+    child->transform()->setParent(root->transform());
+    child->transform()->setLocalRotation(angleAxis(radians(30.0f), vec3{0,1,0}));
+    child->transform()->setLocalScale(vec3{2});
+    auto camera = child->addComponent<CameraPerspective>();
+    camera->set(0.5f, 50, radians(45.0f));
+    camera->setMain(false);
+    camera->setIndex(3);
+    auto line = child->addComponent<LineRenderer>();
+    line->setPoints({vec3{0}, vec3{1}, vec3{2}}, MeshType::LineStrip);
+    line->setEnabled(false);
+
+    vector<char> data = SceneSerializer::save(vector<GameObject*>{root});
+    // the JSON export uses the same schema
+    vector<char> dataFromJson;
+    TINYTEST_ASSERT(SceneSerializer::fromJson(SceneSerializer::toJson(data.data(), data.size()), dataFromJson));
+    TINYTEST_ASSERT(dataFromJson == data);
+
+    vector<GameObject*> created;
+    TINYTEST_ASSERT(SceneSerializer::load(scene, data.data(), data.size(), SceneAssets{}, &created));
+    TINYTEST_ASSERT(created.size() == 2);
+    GameObject *loadedRoot = created[0];
+    GameObject *loadedChild = created[1];
+    TINYTEST_ASSERT(loadedRoot->name() == "SerializedRoot" && loadedChild->name() == "SerializedChild");
+    TINYTEST_ASSERT(loadedRoot->layer() == 2);
+    TINYTEST_ASSERT(loadedChild->transform()->parent() == loadedRoot->transform());
+    TINYTEST_ASSERT(equal(loadedChild->transform()->globalMatrix(), child->transform()->globalMatrix(), 0.0001f));
+    auto loadedLight = loadedRoot->component<Light>();
+    TINYTEST_ASSERT(loadedLight && loadedLight->lightType() == LightType::Point);
+    TINYTEST_ASSERT(all(epsilonEqual(loadedLight->color(), light->color(), 0.0001f)) && loadedLight->intensity() == 0.7f);
+    auto loadedCamera = loadedChild->component<CameraPerspective>();
+    TINYTEST_ASSERT(loadedCamera && loadedCamera->near() == 0.5f && loadedCamera->far() == 50 && loadedCamera->fieldOfViewY() == radians(45.0f));
+    TINYTEST_ASSERT(!loadedCamera->main() && loadedCamera->index() == 3);
+    auto loadedLine = loadedChild->component<LineRenderer>();
+    TINYTEST_ASSERT(loadedLine && !loadedLine->enabled() && loadedLine->meshType() == MeshType::LineStrip);
+    TINYTEST_ASSERT(loadedLine->points().size() == 3 && loadedLine->points()[2] == vec3{2});
+
+    // canvas cameras stored after the canvas (here on a child) are resolved
+    auto canvas = scene->createCanvas(false);
+    auto uiCameraObject = scene->createGameObject("UICamera");
+    uiCameraObject->transform()->setParent(canvas->gameObject()->transform());
+    auto uiCamera = scene->createOrthographicCamera(uiCameraObject);
+    uiCamera->setMain(false);
+    canvas->setCamera(uiCamera);
+    vector<char> canvasData = SceneSerializer::save(vector<GameObject*>{canvas->gameObject()});
+    vector<GameObject*> createdCanvas;
+    TINYTEST_ASSERT(SceneSerializer::load(scene, canvasData.data(), canvasData.size(), SceneAssets{}, &createdCanvas));
+    TINYTEST_ASSERT(createdCanvas.size() == 2);
+    auto loadedCanvas = createdCanvas[0]->component<Canvas>();
+    TINYTEST_ASSERT(loadedCanvas && loadedCanvas->camera() && loadedCanvas->camera() == createdCanvas[1]->component<Camera>());
+
+    // invalid data is rejected
+    vector<char> truncated(data.begin(), data.begin() + data.size() / 2);
+    TINYTEST_ASSERT(!SceneSerializer::load(scene, truncated.data(), truncated.size()));
+    // enum values out of range are rejected
+    string json = SceneSerializer::toJson(data.data(), data.size());
+    size_t lightTypePos = json.find("\"lightType\": ");
+    TINYTEST_ASSERT(lightTypePos != string::npos);
+    lightTypePos += strlen("\"lightType\": ");
+    json.replace(lightTypePos, json.find_first_not_of("0123456789", lightTypePos) - lightTypePos, "99");
+    vector<char> invalidEnum;
+    TINYTEST_ASSERT(!SceneSerializer::fromJson(json, invalidEnum));
+
+    // non-finite floats are exported as valid JSON and read back
+    auto infiniteCameraObject = scene->createGameObject("InfiniteCamera");
+    auto infiniteCamera = infiniteCameraObject->addComponent<CameraPerspective>();
+    infiniteCamera->set(0.5f, std::numeric_limits<float>::infinity(), radians(45.0f));
+    infiniteCamera->setMain(false);
+    infiniteCamera->setEnabled(false);
+    vector<char> infiniteData = SceneSerializer::save(vector<GameObject*>{infiniteCameraObject});
+    string infiniteJson = SceneSerializer::toJson(infiniteData.data(), infiniteData.size());
+    TINYTEST_ASSERT(infiniteJson.find("\"Infinity\"") != string::npos && infiniteJson.find("inf,") == string::npos);
+    vector<char> infiniteDataFromJson;
+    TINYTEST_ASSERT(SceneSerializer::fromJson(infiniteJson, infiniteDataFromJson));
+    TINYTEST_ASSERT(infiniteDataFromJson == infiniteData);
+    scene->destroyGameObject(infiniteCameraObject);
+
+    for (auto gameObject : {loadedChild, loadedRoot, child, root, createdCanvas[1], createdCanvas[0],
+            uiCameraObject, canvas->gameObject()}){
+        scene->destroyGameObject(gameObject);
+    }
+    return 1;
+}
+
+int TestAsyncSceneLoad(){
+    Scene *scene = Engine::activeScene();
+    vector<GameObject*> roots;
+    vector<GameObject*> gameObjects;
+    for (int i = 0; i < 20; i++){
+        auto root = scene->createGameObject("AsyncRoot");
+        root->transform()->setLocalPosition(vec3{(float)i, 0, 0});
+        root->addComponent<Light>()->setIntensity(i * 0.1f);
+        auto child = scene->createGameObject("AsyncChild");
+        child->transform()->setParent(root->transform());
+        roots.push_back(root);
+        gameObjects.push_back(root);
+        gameObjects.push_back(child);
+    }
+    vector<char> data = SceneSerializer::save(roots);
+    size_t gameObjectCount = 0;
+    for (auto & gameObject : *scene){
+        (void)gameObject;
+        gameObjectCount++;
+    }
+
+    JobSystem jobSystem(1);
+    SceneLoadOperation operation{scene, vector<char>(data), &jobSystem};
+    bool completedNotified = false;
+    auto listener = operation.completed.createListener([&](SceneLoadOperation *o){
+        completedNotified = o->state() == SceneLoadOperation::State::Completed;
+    });
+    // a zero budget does a single step per update, so the load is spread over several updates
+    int updates = 0;
+    float progress = 0;
+    while (!operation.update(0)){
+        TINYTEST_ASSERT(operation.progress() >= progress);
+        progress = operation.progress();
+        updates++;
+    }
+    TINYTEST_ASSERT(updates > 40);
+    TINYTEST_ASSERT(completedNotified);
+    TINYTEST_ASSERT(operation.progress() == 1);
+    // the gameobjects are added to the existing scene
+    auto created = operation.gameObjects();
+    TINYTEST_ASSERT(created.size() == 40);
+    size_t newGameObjectCount = 0;
+    for (auto & gameObject : *scene){
+        (void)gameObject;
+        newGameObjectCount++;
+    }
+    TINYTEST_ASSERT(newGameObjectCount == gameObjectCount + 40);
+    TINYTEST_ASSERT(created[1]->transform()->parent() == created[0]->transform());
+    TINYTEST_ASSERT(created[2]->transform()->localPosition() == vec3(1, 0, 0));
+    TINYTEST_ASSERT(created[2]->component<Light>()->intensity() == 0.1f);
+
+    // gameobjects destroyed while loading are skipped together with their children
+    SceneLoadOperation destroyedWhileLoading{scene, vector<char>(data), &jobSystem};
+    while (destroyedWhileLoading.gameObjects().size() < 1){
+        destroyedWhileLoading.update(0);
+    }
+    TINYTEST_ASSERT(destroyedWhileLoading.state() == SceneLoadOperation::State::Instantiating);
+    scene->destroyGameObject(destroyedWhileLoading.gameObjects()[0]);
+    while (!destroyedWhileLoading.update(0)){
+    }
+    auto remaining = destroyedWhileLoading.gameObjects();
+    TINYTEST_ASSERT(destroyedWhileLoading.state() == SceneLoadOperation::State::Completed && remaining.size() == 38);
+    TINYTEST_ASSERT(remaining[0]->name() == "AsyncRoot" && remaining[0]->component<Light>()->intensity() == 0.1f);
+    for (auto it = remaining.rbegin(); it != remaining.rend(); it++){
+        scene->destroyGameObject(*it);
+    }
+
+    // invalid data fails without creating gameobjects
+    SceneLoadOperation invalid{scene, vector<char>(data.begin(), data.begin() + 16), &jobSystem};
+    while (!invalid.update(1)){
+    }
+    TINYTEST_ASSERT(invalid.state() == SceneLoadOperation::State::Failed && invalid.gameObjects().empty());
+
+    // children are destroyed before their parents
+    gameObjects.insert(gameObjects.end(), created.begin(), created.end());
+    for (auto it = gameObjects.rbegin(); it != gameObjects.rend(); it++){
+        scene->destroyGameObject(*it);
+    }
+    return 1;
+}
+
+int TestRenderQueue(){
+    // opaque draws are sorted by render order, then by shader, material and mesh
+    TINYTEST_ASSERT(RenderQueue::opaqueKey(1000, 9, 9, 9) < RenderQueue::opaqueKey(1001, 0, 0, 0));
+    TINYTEST_ASSERT(RenderQueue::opaqueKey(1000, 1, 9, 9) < RenderQueue::opaqueKey(1000, 2, 0, 0));
+    TINYTEST_ASSERT(RenderQueue::opaqueKey(1000, 1, 1, 9) < RenderQueue::opaqueKey(1000, 1, 2, 0));
+    // transparent draws are sorted back to front after the opaque queue
+    TINYTEST_ASSERT(RenderQueue::transparent(2500) && !RenderQueue::transparent(1000) && !RenderQueue::transparent(3000));
+    TINYTEST_ASSERT(RenderQueue::transparentKey(2000, 10, 0) < RenderQueue::transparentKey(2000, 1, 0));
+    TINYTEST_ASSERT(RenderQueue::transparentKey(2000, 1.5f, 0) < RenderQueue::transparentKey(2000, 1.25f, 0));
+    TINYTEST_ASSERT(RenderQueue::opaqueKey(1999, 0xffff, 0, 0) < RenderQueue::transparentKey(2000, 1e30f, 0));
+
+    // the radix sort is stable and matches a comparison sort
+    RenderQueue queue;
+    vector<pair<uint64_t, intptr_t>> expected;
+    uint64_t random = 12345;
+    for (intptr_t i = 1; i <= 1000; i++){
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t key = RenderQueue::opaqueKey(1000 + (int)(random >> 62), (uint32_t)(random >> 40) & 3, (uint32_t)(random >> 20) & 7, 0);
+        queue.add(key, reinterpret_cast<ComponentRenderable*>(i));
+        expected.push_back(make_pair(key, i));
+    }
+    queue.sort();
+    stable_sort(expected.begin(), expected.end(), [](const pair<uint64_t, intptr_t> &a, const pair<uint64_t, intptr_t> &b){
+        return a.first < b.first;
+    });
+    TINYTEST_ASSERT(queue.size() == expected.size());
+    for (size_t i = 0; i < queue.size(); i++){
+        TINYTEST_ASSERT(queue[i].key == expected[i].first);
+        TINYTEST_ASSERT(queue[i].renderable == reinterpret_cast<ComponentRenderable*>(expected[i].second));
+    }
+    return 1;
+}
+
+int TestGLStateCache(){
+    GLState::invalidate();
+    int programSwitches = RenderStats::current.programSwitches;
+    int textureSwitches = RenderStats::current.textureSwitches;
+    // redundant calls are skipped
+    GLState::useProgram(0);
+    GLState::useProgram(0);
+    TINYTEST_ASSERT(RenderStats::current.programSwitches == programSwitches + 1);
+    GLState::bindTexture(3, GL_TEXTURE_2D, 0);
+    GLState::bindTexture(3, GL_TEXTURE_2D, 0);
+    TINYTEST_ASSERT(RenderStats::current.textureSwitches == textureSwitches + 1);
+    // after invalidate the state is unknown, so the next call is passed on
+    GLState::invalidate();
+    GLState::useProgram(0);
+    GLState::bindTexture(3, GL_TEXTURE_2D, 0);
+    TINYTEST_ASSERT(RenderStats::current.programSwitches == programSwitches + 2);
+    TINYTEST_ASSERT(RenderStats::current.textureSwitches == textureSwitches + 2);
+    // deleted names may be reused, so they are removed from the shadowed state
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::bindTexture(3, GL_TEXTURE_2D, texture);
+    GLState::deleteTextures(1, &texture);
+    glGenTextures(1, &texture);
+    GLState::bindTexture(3, GL_TEXTURE_2D, texture);
+    TINYTEST_ASSERT(RenderStats::current.textureSwitches == textureSwitches + 4);
+    GLState::deleteTextures(1, &texture);
+    GLState::invalidate();
+    return 1;
+}
+
+int TestUniformSemantics(){
+    TINYTEST_ASSERT(toUniformSemantic("_mvProj") == UniformSemantic::ModelViewProjection);
+    TINYTEST_ASSERT(toUniformSemantic("_pLights[0]") == UniformSemantic::PointLight);
+    TINYTEST_ASSERT(toUniformSemantic("_viewport") == UniformSemantic::Viewport);
+    TINYTEST_ASSERT(toUniformSemantic("mainTexture") == UniformSemantic::None);
+    TINYTEST_ASSERT(toUniformSemantic("_unknown") == UniformSemantic::None);
+    // the uniforms are classified when the shader is linked
+    auto shader = Project::loadShader("assets/shaders/diffuse.shader");
+    TINYTEST_ASSERT(shader);
+    int engineUniforms = 0;
+    for (auto & uniform : shader->getShaderUniforms()){
+        TINYTEST_ASSERT(uniform.semantic == toUniformSemantic(uniform.name));
+        if (uniform.semantic != UniformSemantic::None){
+            engineUniforms++;
+        }
+    }
+    TINYTEST_ASSERT(engineUniforms > 0);
+    return 1;
+}
+
+int TestEngineUniformBlocks(){
+    string source = "uniform mat4 _mvProj;\nuniform mat4 _v;\nuniform highp float _time;\nvoid main(){}\n";
+    string declarations = EngineUniformBlocks::replaceDeclarations(source, 3);
+    if (!EngineUniformBlocks::supported()){
+        TINYTEST_ASSERT(declarations.empty());
+        return 1;
+    }
+    // only the blocks used are declared, and per draw uniforms are kept
+    TINYTEST_ASSERT(declarations.find("uniform _KickCamera") != string::npos);
+    TINYTEST_ASSERT(declarations.find("uniform _KickFrame") != string::npos);
+    TINYTEST_ASSERT(declarations.find("uniform _KickLights") == string::npos);
+    TINYTEST_ASSERT(source.find("_v;") == string::npos && source.find("_time") == string::npos);
+    TINYTEST_ASSERT(source.find("uniform mat4 _mvProj;") != string::npos);
+    // the line count is unchanged
+    TINYTEST_ASSERT(count(source.begin(), source.end(), '\n') == 4);
+
+    // the light uniforms of the diffuse shader are block members, which are not set per draw
+    auto shader = Project::loadShader("assets/shaders/diffuse.shader");
+    TINYTEST_ASSERT(shader && shader->getShaderUniform(UniformNames::ambient) == nullptr);
+    TINYTEST_ASSERT(shader->getShaderUniform(UniformNames::mvProj) != nullptr);
+    return 1;
+}
+
+int TestMaterialParameters(){
+    TINYTEST_ASSERT(UniformName("p") == UniformName(std::string{"p"}));
+    TINYTEST_ASSERT(UniformName("p") != UniformName("q"));
+    std::string vertexShader =
+            R"(
+            uniform vec4 p;
+            in vec4 position;
+            void main (void)
+            {
+                gl_Position = p + position;
+            }
+            )";
+    std::string fragmentShader =
+            R"(
+            out vec4 fragColor;
+            void main(void)
+            {
+                fragColor = vec4(1.0);
+            }
+            )";
+    auto shader = std::make_shared<Shader>(vertexShader, fragmentShader);
+    GLint location = shader->getShaderUniform("p")->index;
+    auto currentValue = [&](){
+        glm::vec4 value;
+        glGetUniformfv(shader->shaderProgram(), location, glm::value_ptr(value));
+        return value;
+    };
+    Material material1{shader};
+    Material material2{shader};
+    static const UniformName p{"p"};
+    material1.setUniform(p, glm::vec4{1});
+    material2.setUniform(p, glm::vec4{2});
+    TINYTEST_ASSERT(material1.parameters().size() == 1 && material1.parameters()[0].shaderLocation == location);
+
+    shader->bind();
+    material1.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{1});
+    // unchanged parameters are not uploaded when the material is bound twice in a row
+    glUniform4f(location, 9, 9, 9, 9);
+    material1.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{9});
+    material1.setUniform(p, glm::vec4{1});
+    material1.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{9});
+    material1.setUniform(p, glm::vec4{3});
+    material1.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{3});
+    // binding another material uploads all parameters
+    material2.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{2});
+    material1.bind();
+    TINYTEST_ASSERT(currentValue() == glm::vec4{3});
+    return 1;
+}
+
+int TestInstancing(){
+    auto scene = Engine::activeScene();
+    auto cube1 = scene->createCube();
+    auto cube2 = scene->createGameObject("Cube2")->addComponent<MeshRenderer>();
+    cube2->setMesh(cube1->mesh());
+    cube2->setMaterial(cube1->material());
+    auto cube3 = scene->createCube();
+
+    // only renderers sharing mesh and materials are instanced
+    bool supported = InstanceBuffer::supported();
+    TINYTEST_ASSERT(cube1->canInstanceWith(cube2.get(), nullptr) == supported);
+    TINYTEST_ASSERT(!cube1->canInstanceWith(cube3.get(), nullptr));
+    // shaders without an instanced code path have no instanced variant
+    TINYTEST_ASSERT(Project::loadShader("assets/shaders/unlit_vertex_color.shader")->instancedShader() == nullptr);
+    if (supported){
+        auto shader = cube1->material()->shader()->instancedShader();
+        TINYTEST_ASSERT(shader && shader->getShaderAttribute(VertexAttributeSemantic::InstanceModel) != nullptr);
+        TINYTEST_ASSERT(shader->getShaderUniform(UniformNames::mvProj) == nullptr);
+
+        cube2->transform()->setPosition(vec3{1,2,3});
+        InstanceBuffer instances;
+        instances.add(cube1.get());
+        instances.add(cube2.get());
+        instances.upload();
+        TINYTEST_ASSERT(instances.size() == 2);
+        TINYTEST_ASSERT(instances[1].model == cube2->transform()->globalMatrix());
+        TINYTEST_ASSERT(instances[1].uid == uint32ToVec4(cube2->gameObject()->uniqueId()));
+    }
+
+    scene->destroyGameObject(cube3->gameObject());
+    scene->destroyGameObject(cube2->gameObject());
+    scene->destroyGameObject(cube1->gameObject());
+    return 1;
+}
+
+int TestStaticBatching(){
+    auto scene = Engine::activeScene();
+    vector<shared_ptr<MeshRenderer>> renderers;
+    for (int i = 0; i < 4; i++){
+        auto renderer = scene->createCube();
+        if (i > 0){
+            renderer->setMaterial(renderers[0]->material());
+        }
+        renderer->transform()->setPosition(vec3{i * 10, 0, 0});
+        renderer->gameObject()->setStatic(true);
+        renderers.push_back(renderer);
+    }
+    auto dynamicRenderer = scene->createCube();
+    dynamicRenderer->setMaterial(renderers[0]->material());
+
+    // the budget fits two cubes per batch
+    int cubeVertices = (int)renderers[0]->mesh()->meshData()->position().size();
+    auto batches = StaticBatcher::combine(scene, cubeVertices * 2);
+    TINYTEST_ASSERT(batches.size() == 2);
+    TINYTEST_ASSERT(batches[0]->renderers().size() == 2 && batches[1]->renderers().size() == 2);
+    // batched renderers stay enabled, but are culled (they are rendered by the batch)
+    TINYTEST_ASSERT(renderers[0]->staticBatch() == batches[0].get() && renderers[0]->enabled());
+    TINYTEST_ASSERT(dynamicRenderer->staticBatch() == nullptr && dynamicRenderer->enabled());
+    // the vertices are merged in world space, and each batch has its own bounds
+    auto bounds = batches[1]->worldBounds();
+    TINYTEST_ASSERT(batches[1]->mesh()->meshData()->position().size() == cubeVertices * 2);
+    TINYTEST_ASSERT(std::abs(bounds.min.x - 19.5f) < 0.001f && std::abs(bounds.max.x - 30.5f) < 0.001f);
+
+    // moved renderers are evicted from the batch
+    renderers[3]->transform()->setPosition(vec3{0, 10, 0});
+    vector<ComponentRenderable*> result;
+    scene->queryRenderables(Bounds3{vec3{-100}, vec3{100}}, result);
+    TINYTEST_ASSERT(renderers[3]->staticBatch() == nullptr && renderers[3]->enabled());
+    TINYTEST_ASSERT(batches[1]->renderers().size() == 1);
+    renderers[2]->gameObject()->setStatic(false);
+    TINYTEST_ASSERT(renderers[2]->staticBatch() == nullptr && batches[1]->renderers().empty());
+
+    // disabled renderers are evicted and stay disabled
+    renderers[1]->setEnabled(false);
+    TINYTEST_ASSERT(renderers[1]->staticBatch() == nullptr && !renderers[1]->enabled());
+    TINYTEST_ASSERT(batches[0]->renderers().size() == 1);
+    renderers[1]->setEnabled(true);
+
+    // changing the layer, material or mesh evicts the renderer
+    renderers[0]->gameObject()->setLayer(2);
+    TINYTEST_ASSERT(renderers[0]->staticBatch() == nullptr && batches[0]->renderers().empty());
+    auto rebatched = StaticBatcher::combine(scene, vector<GameObject*>{renderers[0]->gameObject()});
+    TINYTEST_ASSERT(rebatched.size() == 1 && renderers[0]->staticBatch() == rebatched[0].get());
+    Material material{*renderers[0]->material()};
+    renderers[0]->setMaterial(&material);
+    TINYTEST_ASSERT(renderers[0]->staticBatch() == nullptr);
+    auto rebatchedMaterial = StaticBatcher::combine(scene, vector<GameObject*>{renderers[0]->gameObject()});
+    TINYTEST_ASSERT(renderers[0]->staticBatch() == rebatchedMaterial[0].get());
+    auto mesh = make_shared<Mesh>();
+    mesh->setMeshData(MeshFactory::createCubeData(2));
+    renderers[0]->setMesh(mesh);
+    TINYTEST_ASSERT(renderers[0]->staticBatch() == nullptr);
+
+    // eviction only patches the merged mesh and keeps the slots of the remaining renderers
+    vector<shared_ptr<MeshRenderer>> slotRenderers;
+    vector<GameObject*> slotGameObjects;
+    for (int i = 0; i < 4; i++){
+        auto renderer = scene->createCube();
+        renderer->setMaterial(dynamicRenderer->material());
+        renderer->transform()->setPosition(vec3{i * 10, 50, 0});
+        renderer->gameObject()->setStatic(true);
+        slotRenderers.push_back(renderer);
+        slotGameObjects.push_back(renderer->gameObject());
+    }
+    auto slotBatches = StaticBatcher::combine(scene, slotGameObjects);
+    TINYTEST_ASSERT(slotBatches.size() == 1 && slotBatches[0]->renderers().size() == 4);
+    auto mergedData = slotBatches[0]->mesh()->meshData();
+    slotRenderers[0]->gameObject()->setStatic(false);
+    TINYTEST_ASSERT(slotBatches[0]->renderers().size() == 3 && slotBatches[0]->mesh()->meshData() == mergedData);
+    // the last renderer was moved to the slot of the evicted one
+    slotRenderers[3]->gameObject()->setStatic(false);
+    TINYTEST_ASSERT(slotRenderers[3]->staticBatch() == nullptr && slotBatches[0]->renderers().size() == 2);
+    TINYTEST_ASSERT(slotRenderers[1]->staticBatch() == slotBatches[0].get());
+    TINYTEST_ASSERT(slotRenderers[2]->staticBatch() == slotBatches[0].get());
+    slotRenderers[1]->gameObject()->setStatic(false);
+    slotRenderers[2]->gameObject()->setStatic(false);
+    TINYTEST_ASSERT(slotBatches[0]->renderers().empty());
+    scene->destroyGameObject(slotBatches[0]->gameObject());
+    for (auto gameObject : slotGameObjects){
+        scene->destroyGameObject(gameObject);
+    }
+
+    // destroying a batch releases its renderers
+    scene->destroyGameObject(batches[0]->gameObject());
+    scene->destroyGameObject(rebatched[0]->gameObject());
+    scene->destroyGameObject(rebatchedMaterial[0]->gameObject());
+    scene->destroyGameObject(batches[1]->gameObject());
+    scene->destroyGameObject(dynamicRenderer->gameObject());
+    for (auto & renderer : renderers){
+        scene->destroyGameObject(renderer->gameObject());
+    }
+    return 1;
+}
+
+int TestMeshIndexType(){
+    // small meshes use 16 bit indices
+    auto meshData = MeshFactory::createPlaneData();
+    TINYTEST_ASSERT(meshData->indexType() == GL_UNSIGNED_SHORT);
+    TINYTEST_ASSERT(meshData->indexSize() == sizeof(GLushort));
+    // 16 bit index lists are still accepted
+    meshData->setSubmesh(0, vector<GLushort>{0, 1, 2, 2, 1, 3}, MeshType::Triangles);
+    TINYTEST_ASSERT(meshData->submeshIndices(0) == (vector<GLuint>{0, 1, 2, 2, 1, 3}));
+    TINYTEST_ASSERT(meshData->indexType() == GL_UNSIGNED_SHORT);
+
+    // meshes with more than 65536 vertices use 32 bit indices
+    vector<vec3> positions(70000);
+    for (size_t i = 0; i < positions.size(); i++){
+        positions[i] = vec3{(float)i, (float)(i % 2), 0};
+    }
+    meshData = make_shared<MeshData>();
+    meshData->setPosition(positions);
+    meshData->setSubmesh(0, {0, 1, 69999}, MeshType::Triangles);
+    meshData->setSubmesh(1, {69998, 69999, 2}, MeshType::Triangles);
+    TINYTEST_ASSERT(meshData->indexType() == GL_UNSIGNED_INT);
+    TINYTEST_ASSERT(meshData->submeshIndices(0)[2] == 69999);
+    auto format = meshData->indicesFormat();
+    TINYTEST_ASSERT(format.size() == 2);
+    TINYTEST_ASSERT(format[0].type == GL_UNSIGNED_INT && format[1].type == GL_UNSIGNED_INT);
+    TINYTEST_ASSERT(format[1].dataOffset == BUFFER_OFFSET(3 * sizeof(GLuint)));
+    auto indices = meshData->indicesConcat();
+    TINYTEST_ASSERT(indices.size() == 6 && indices[3] == 69998);
+    return 1;
+}
+
+int TestMeshDataDirtyRange(){
+    auto meshData = MeshFactory::createUVSphereData(8, 8, 1);
+    meshData->setTangent(vector<vec3>(meshData->position().size(), vec3{1, 0, 0}));
+    TINYTEST_ASSERT(meshData->layoutDirty() && meshData->indicesDirty());
+    // the interleaved data matches the stride of the format
+    auto format = meshData->interleavedFormat();
+    auto data = meshData->interleavedData();
+    size_t stride = format[0].stride / sizeof(float);
+    TINYTEST_ASSERT(data.size() == stride * meshData->position().size());
+    meshData->clearDirty();
+
+    // assigning equal data marks nothing dirty
+    auto indices = meshData->submeshIndices(0);
+    meshData->setSubmesh(0, indices, MeshType::TriangleStrip);
+    auto positions = meshData->position();
+    meshData->setPosition(positions);
+    TINYTEST_ASSERT(!meshData->layoutDirty() && !meshData->indicesDirty());
+    TINYTEST_ASSERT(meshData->dirtyVertexBegin() == meshData->dirtyVertexEnd());
+
+    // only the changed vertices are marked dirty
+    positions[5] = vec3{2, 0, 0};
+    positions[9] = vec3{3, 0, 0};
+    meshData->setPosition(positions);
+    auto colors = meshData->color();
+    colors[7] = vec4{1, 0, 0, 1};
+    meshData->setColor(colors);
+    TINYTEST_ASSERT(!meshData->layoutDirty());
+    TINYTEST_ASSERT(meshData->dirtyVertexBegin() == 5 && meshData->dirtyVertexEnd() == 10);
+    auto range = meshData->interleavedData(5, 5);
+    data = meshData->interleavedData();
+    TINYTEST_ASSERT(range.size() == stride * 5);
+    TINYTEST_ASSERT(std::equal(range.begin(), range.end(), data.begin() + stride * 5));
+    TINYTEST_ASSERT(range[0] == 2.0f && range[stride * 4] == 3.0f);
+
+    // changing the number of vertices changes the layout
+    positions.push_back(vec3{0});
+    meshData->setPosition(positions);
+    TINYTEST_ASSERT(meshData->layoutDirty());
+    uint32_t version = meshData->version();
+    meshData->clearDirty();
+    TINYTEST_ASSERT(!meshData->layoutDirty() && meshData->dirtyVertexBegin() == meshData->dirtyVertexEnd());
+    TINYTEST_ASSERT(meshData->cleanVersion() == version);
+    // each change increments the version
+    meshData->setPosition(positions);
+    TINYTEST_ASSERT(meshData->version() == version);
+    positions[0] = vec3{4, 0, 0};
+    meshData->setPosition(positions);
+    TINYTEST_ASSERT(meshData->version() > version && meshData->cleanVersion() == version);
+    return 1;
+}
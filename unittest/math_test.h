@@ -22,6 +22,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "glm/gtx/string_cast.hpp"
 #include "kick/math/plane.h"
+#include "kick/math/frustum.h"
+#include "kick/math/dynamic_aabb_tree.h"
+#include "kick/math/glm_ext.h"
+#include <random>
 #include <cstdint>
 
 using namespace std;
@@ -89,4 +93,278 @@ int TestIntPacking(){
         TINYTEST_ASSERT(res == i);
     }
     return 1;
-}
\ No newline at end of file
+}
+
+int TestFrustum(){
+    mat4 projection = glm::perspective(radians(60.0f), 1.0f, 0.1f, 100.0f);
+    mat4 view = glm::lookAt(vec3{0,0,10}, vec3{0,0,0}, vec3{0,1,0});
+    kick::Frustum frustum;
+    frustum.extractPlanes(projection * view);
+
+    kick::Bounds3 inside{vec3{-1}, vec3{1}};
+    TINYTEST_ASSERT(frustum.intersectAabb(inside) == kick::FrustumIntersection::Inside);
+    kick::Bounds3 behindCamera{vec3{-1,-1,11}, vec3{1,1,13}};
+    TINYTEST_ASSERT(frustum.intersectAabb(behindCamera) == kick::FrustumIntersection::Outside);
+    kick::Bounds3 farRight{vec3{50,-1,-1}, vec3{52,1,1}};
+    TINYTEST_ASSERT(frustum.intersectAabb(farRight) == kick::FrustumIntersection::Outside);
+    kick::Bounds3 crossingNearPlane{vec3{-1,-1,9}, vec3{1,1,11}};
+    TINYTEST_ASSERT(frustum.intersectAabb(crossingNearPlane) == kick::FrustumIntersection::Intersecting);
+    return 1;
+}
+
+int TestDynamicAABBTree(){
+    kick::DynamicAABBTree tree;
+    std::vector<kick::Bounds3> bounds;
+    std::vector<int> proxies;
+    for (int x = 0; x < 10; x++){
+        for (int y = 0; y < 10; y++){
+            for (int z = 0; z < 10; z++){
+                vec3 center{x * 4, y * 4, z * 4};
+                kick::Bounds3 b{center - vec3{1}, center + vec3{1}};
+                proxies.push_back(tree.createProxy(b, (void*)(intptr_t)bounds.size()));
+                bounds.push_back(b);
+            }
+        }
+    }
+    TINYTEST_ASSERT(tree.validate());
+    TINYTEST_ASSERT(tree.proxyCount() == 1000);
+    TINYTEST_ASSERT(tree.height() < 20);
+
+    // move every second proxy and remove every third
+    for (int i = 0; i < (int)bounds.size(); i += 2){
+        bounds[i] = kick::Bounds3{bounds[i].min + vec3{0.5f, 0, 0}, bounds[i].max + vec3{0.5f, 0, 0}};
+        tree.moveProxy(proxies[i], bounds[i], vec3{0.5f, 0, 0});
+    }
+    for (int i = 0; i < (int)bounds.size(); i += 3){
+        tree.destroyProxy(proxies[i]);
+        proxies[i] = kick::DynamicAABBTree::nullNode;
+    }
+    TINYTEST_ASSERT(tree.validate());
+    TINYTEST_ASSERT(tree.maxBalance() <= tree.height());
+
+
+    // the query must report every overlapping proxy (it may report more, since the tree uses fat bounds)
+    kick::Bounds3 queryBounds{vec3{5,5,5}, vec3{15,15,15}};
+    std::vector<bool> found(bounds.size(), false);
+    tree.query(queryBounds, [&](int proxyId){
+        found[(intptr_t)tree.userData(proxyId)] = true;
+        return true;
+    });
+    for (int i = 0; i < (int)bounds.size(); i++){
+        if (proxies[i] != kick::DynamicAABBTree::nullNode && bounds[i].intersect(queryBounds)){
+            TINYTEST_ASSERT(found[i]);
+        }
+    }
+
+    mat4 projection = glm::perspective(radians(60.0f), 1.0f, 0.1f, 10.0f);
+    mat4 view = glm::lookAt(vec3{18,18,-5}, vec3{18,18,0}, vec3{0,1,0});
+    kick::Frustum frustum;
+    frustum.extractPlanes(projection * view);
+    std::fill(found.begin(), found.end(), false);
+    tree.queryFrustum(frustum, [&](int proxyId, kick::FrustumIntersection intersection, uint32_t planeMask){
+        found[(intptr_t)tree.userData(proxyId)] = true;
+        return true;
+    });
+    for (int i = 0; i < (int)bounds.size(); i++){
+        if (proxies[i] != kick::DynamicAABBTree::nullNode && frustum.intersectAabb(bounds[i]) != kick::FrustumIntersection::Outside){
+            TINYTEST_ASSERT(found[i]);
+        }
+    }
+
+    // ray along the x axis through the row y=0, z=0
+    kick::Ray ray{vec3{-10,0,0}, vec3{1,0,0}};
+    int hits = 0;
+    tree.rayCast(ray, [&](int proxyId, float distance){
+        float exactDistance;
+        if (ray.intersectAabb(bounds[(intptr_t)tree.userData(proxyId)], exactDistance)){
+            hits++;
+        }
+        return true;
+    });
+    int expectedHits = 0;
+    for (int i = 0; i < 10; i++){
+        if (proxies[i * 100] != kick::DynamicAABBTree::nullNode){
+            expectedHits++;
+        }
+    }
+    TINYTEST_ASSERT(hits == expectedHits);
+
+    // random churn keeps the tree valid (it is not required to be strictly balanced)
+    srand(4);
+    for (int op = 0; op < 5000; op++){
+        int i = rand() % (int)bounds.size();
+        vec3 center{(float)(rand() % 40), (float)(rand() % 40), (float)(rand() % 40)};
+        kick::Bounds3 b{center - vec3{1}, center + vec3{1}};
+        if (proxies[i] == kick::DynamicAABBTree::nullNode){
+            proxies[i] = tree.createProxy(b, (void*)(intptr_t)i);
+        } else if (rand() % 2 == 0){
+            tree.moveProxy(proxies[i], b, b.center() - bounds[i].center());
+        } else {
+            tree.destroyProxy(proxies[i]);
+            proxies[i] = kick::DynamicAABBTree::nullNode;
+        }
+        bounds[i] = b;
+    }
+    TINYTEST_ASSERT(tree.validate());
+
+    tree.clear();
+    TINYTEST_ASSERT(tree.proxyCount() == 0);
+    TINYTEST_ASSERT(tree.validate());
+    return 1;
+}
+
+int TestTRSKernels(){
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-1, 1);
+    std::uniform_real_distribution<float> scaleValue(0.1f, 3);
+    // not a multiple of four to test the scalar fallback of the batch versions
+    const int count = 103;
+    std::vector<vec3> translate(count), scale(count);
+    std::vector<quat> rotate(count);
+    for (int i = 0; i < count; i++){
+        translate[i] = vec3{value(rng), value(rng), value(rng)} * 100.0f;
+        scale[i] = vec3{scaleValue(rng), scaleValue(rng), scaleValue(rng)};
+        rotate[i] = normalize(quat{value(rng), value(rng), value(rng), value(rng)});
+    }
+    std::vector<mat4> batch(count), batchInverse(count);
+    kick::TRS(translate.data(), rotate.data(), scale.data(), batch.data(), count);
+    kick::TRSInverse(translate.data(), rotate.data(), scale.data(), batchInverse.data(), count);
+
+    // relative error (absolute error for elements smaller than one)
+    auto maxError = [](const mat4 &a, const mat4 &b){
+        float res = 0;
+        for (int c = 0; c < 4; c++){
+            for (int r = 0; r < 4; r++){
+                res = std::max(res, std::abs(a[c][r] - b[c][r]) / std::max(1.0f, std::abs(b[c][r])));
+            }
+        }
+        return res;
+    };
+    for (int i = 0; i < count; i++){
+        mat4 expected = glm::translate(mat4{1}, translate[i]) * mat4_cast(rotate[i]) * glm::scale(mat4{1}, scale[i]);
+        mat4 expectedInverse = inverse(expected);
+        TINYTEST_ASSERT(maxError(kick::TRS(translate[i], rotate[i], scale[i]), expected) < 1e-5f);
+        TINYTEST_ASSERT(maxError(batch[i], expected) < 1e-5f);
+        TINYTEST_ASSERT(maxError(kick::TRSInverse(translate[i], rotate[i], scale[i]), expectedInverse) < 1e-4f);
+        TINYTEST_ASSERT(maxError(batchInverse[i], expectedInverse) < 1e-4f);
+        TINYTEST_ASSERT(maxError(batch[i] * batchInverse[i], mat4{1}) < 1e-4f);
+    }
+    return 1;
+}
+
+int TestBatchCulling(){
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-1, 1);
+    // not a multiple of four to test the scalar fallback of the batch versions
+    const int count = 103;
+    std::vector<kick::Bounds3> bounds(count);
+    std::vector<mat4> matrices(count);
+    kick::Bounds3Array boundsArray;
+    boundsArray.resize(count);
+    for (int i = 0; i < count; i++){
+        vec3 center = vec3{value(rng), value(rng), value(rng)} * 5.0f;
+        vec3 extent = abs(vec3{value(rng), value(rng), value(rng)}) * 2.0f;
+        bounds[i] = kick::Bounds3{center - extent, center + extent};
+        if (i == 7){
+            bounds[i] = kick::Bounds3{};
+        }
+        boundsArray.set(i, bounds[i]);
+        quat rotation = normalize(quat{value(rng), value(rng), value(rng), value(rng)});
+        matrices[i] = kick::TRS(vec3{value(rng), value(rng), value(rng)} * 20.0f, rotation, abs(vec3{value(rng), value(rng), value(rng)}) + 0.5f);
+    }
+    kick::Bounds3Array transformed;
+    kick::transformBounds(boundsArray, matrices.data(), transformed);
+    TINYTEST_ASSERT(transformed.size() == count);
+    TINYTEST_ASSERT(transformed.get(7).uninitialized());
+    for (int i = 0; i < count; i++){
+        if (i == 7){
+            continue;
+        }
+        // reference: transform the eight corners
+        kick::Bounds3 expected;
+        for (int c = 0; c < 8; c++){
+            vec3 corner{c & 1 ? bounds[i].max.x : bounds[i].min.x, c & 2 ? bounds[i].max.y : bounds[i].min.y, c & 4 ? bounds[i].max.z : bounds[i].min.z};
+            expected.expand(vec3(matrices[i] * vec4(corner, 1)));
+        }
+        kick::Bounds3 scalar = bounds[i].transform(matrices[i]);
+        kick::Bounds3 batch = transformed.get(i);
+        TINYTEST_ASSERT(all(epsilonEqual(scalar.min, expected.min, 0.001f)) && all(epsilonEqual(scalar.max, expected.max, 0.001f)));
+        TINYTEST_ASSERT(all(epsilonEqual(batch.min, expected.min, 0.001f)) && all(epsilonEqual(batch.max, expected.max, 0.001f)));
+    }
+
+    mat4 projection = glm::perspective(radians(60.0f), 1.0f, 0.1f, 100.0f);
+    mat4 view = glm::lookAt(vec3{0,0,40}, vec3{0,0,0}, vec3{0,1,0});
+    kick::Frustum frustum;
+    frustum.extractPlanes(projection * view);
+    std::vector<uint32_t> visible((count + 31) / 32), inside((count + 31) / 32);
+    frustum.intersectAabbs(transformed, visible.data(), inside.data());
+    int visibleCount = 0, insideCount = 0;
+    for (int i = 0; i < count; i++){
+        bool isVisible = (visible[i / 32] >> (i % 32)) & 1;
+        bool isInside = (inside[i / 32] >> (i % 32)) & 1;
+        if (i == 7){
+            TINYTEST_ASSERT(!isVisible && !isInside);
+            continue;
+        }
+        kick::FrustumIntersection expected = frustum.intersectAabb(transformed.get(i));
+        TINYTEST_ASSERT(isVisible == (expected != kick::FrustumIntersection::Outside));
+        TINYTEST_ASSERT(isInside == (expected == kick::FrustumIntersection::Inside));
+        visibleCount += isVisible;
+        insideCount += isInside;
+    }
+    // the random boxes should cover all cases
+    TINYTEST_ASSERT(visibleCount > insideCount && insideCount > 0 && visibleCount < count);
+    return 1;
+}
+
+int TestCoherentFrustumCulling(){
+    mat4 projection = glm::perspective(radians(60.0f), 1.0f, 0.1f, 100.0f);
+    mat4 view = glm::lookAt(vec3{0,0,10}, vec3{0,0,0}, vec3{0,1,0});
+    kick::Frustum frustum;
+    frustum.extractPlanes(projection * view);
+
+    // fully inside removes all planes from the mask
+    uint32_t planeMask = kick::Frustum::allPlanes;
+    uint8_t lastPlane = 0;
+    TINYTEST_ASSERT(frustum.intersectAabb(kick::Bounds3{vec3{-1}, vec3{1}}, planeMask, lastPlane) == kick::FrustumIntersection::Inside);
+    TINYTEST_ASSERT(planeMask == 0);
+    // only the far plane (5) is intersected
+    planeMask = kick::Frustum::allPlanes;
+    TINYTEST_ASSERT(frustum.intersectAabb(kick::Bounds3{vec3{-1,-1,-91}, vec3{1,1,-89}}, planeMask, lastPlane) == kick::FrustumIntersection::Intersecting);
+    TINYTEST_ASSERT(planeMask == (1u << 5));
+    // far right is rejected by the right plane (1), which is cached
+    planeMask = kick::Frustum::allPlanes;
+    TINYTEST_ASSERT(frustum.intersectAabb(kick::Bounds3{vec3{50,-1,-1}, vec3{52,1,1}}, planeMask, lastPlane) == kick::FrustumIntersection::Outside);
+    TINYTEST_ASSERT(lastPlane == 1);
+    // planes not in the mask are not tested
+    planeMask = kick::Frustum::allPlanes & ~(1u << 1);
+    TINYTEST_ASSERT(frustum.intersectAabb(kick::Bounds3{vec3{50,-1,-1}, vec3{52,1,1}}, planeMask, lastPlane) != kick::FrustumIntersection::Outside);
+
+    // query with plane masks and the last plane cache finds the same proxies as brute force, also when the camera moves
+    kick::DynamicAABBTree tree;
+    std::vector<kick::Bounds3> bounds;
+    for (int x = -20; x <= 20; x++){
+        for (int z = -20; z <= 20; z++){
+            vec3 center{x * 3.0f, 0, z * 3.0f};
+            bounds.push_back(kick::Bounds3{center - vec3{1}, center + vec3{1}});
+            tree.createProxy(bounds.back(), (void*)(intptr_t)(bounds.size() - 1));
+        }
+    }
+    std::vector<uint8_t> lastPlanes;
+    for (int frame = 0; frame < 8; frame++){
+        mat4 frameView = glm::lookAt(vec3{0,5,0}, vec3{cos(frame * 0.5f), 5, sin(frame * 0.5f)}, vec3{0,1,0});
+        frustum.extractPlanes(projection * frameView);
+        std::vector<bool> found(bounds.size(), false);
+        tree.queryFrustum(frustum, [&](int proxyId, kick::FrustumIntersection intersection, uint32_t planeMask){
+            intptr_t index = (intptr_t)tree.userData(proxyId);
+            if (frustum.intersectAabb(bounds[index], planeMask, lastPlanes[proxyId]) != kick::FrustumIntersection::Outside){
+                found[index] = true;
+            }
+            return true;
+        }, &lastPlanes);
+        for (size_t i = 0; i < bounds.size(); i++){
+            TINYTEST_ASSERT(found[i] == (frustum.intersectAabb(bounds[i]) != kick::FrustumIntersection::Outside));
+        }
+    }
+    return 1;
+}
@@ -54,6 +54,34 @@ TINYTEST_ADD_TEST(TestFont);
 TINYTEST_ADD_TEST(TestTextureAtlas);
 TINYTEST_ADD_TEST(TestSprite);
 TINYTEST_ADD_TEST(TestComponentHierachy);
+TINYTEST_ADD_TEST(TestFrustum);
+TINYTEST_ADD_TEST(TestRenderableWorldBounds);
+TINYTEST_ADD_TEST(TestDynamicAABBTree);
+TINYTEST_ADD_TEST(TestSceneSpatialQuery);
+TINYTEST_ADD_TEST(TestFlatTransformHierarchy);
+TINYTEST_ADD_TEST(TestJobSystem);
+TINYTEST_ADD_TEST(TestUpdatablePhases);
+TINYTEST_ADD_TEST(TestParallelUpdatableTransforms);
+TINYTEST_ADD_TEST(TestComponentTypeId);
+TINYTEST_ADD_TEST(TestComponentRegistry);
+TINYTEST_ADD_TEST(TestGameObjectHandle);
+TINYTEST_ADD_TEST(TestPooledAllocation);
+TINYTEST_ADD_TEST(TestEvent);
+TINYTEST_ADD_TEST(TestTransformLazyUpdate);
+TINYTEST_ADD_TEST(TestTRSKernels);
+TINYTEST_ADD_TEST(TestBatchCulling);
+TINYTEST_ADD_TEST(TestCoherentFrustumCulling);
+TINYTEST_ADD_TEST(TestSceneSerialization);
+TINYTEST_ADD_TEST(TestAsyncSceneLoad);
+TINYTEST_ADD_TEST(TestRenderQueue);
+TINYTEST_ADD_TEST(TestGLStateCache);
+TINYTEST_ADD_TEST(TestUniformSemantics);
+TINYTEST_ADD_TEST(TestEngineUniformBlocks);
+TINYTEST_ADD_TEST(TestMaterialParameters);
+TINYTEST_ADD_TEST(TestInstancing);
+TINYTEST_ADD_TEST(TestStaticBatching);
+TINYTEST_ADD_TEST(TestMeshIndexType);
+TINYTEST_ADD_TEST(TestMeshDataDirtyRange);
 TINYTEST_END_SUITE();
 
 #include "kick/kick.h"